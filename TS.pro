@@ -2,6 +2,15 @@ QT += widgets opengl openglwidgets testlib
 TARGET = TriangleSphere
 CONFIG += c++17
 
+# Циклы по дорожкам SoA-пачек векторизуются только с -O3 (при -O2 GCC 12
+# не трогает ни одного), а std::sqrt и std::log, которые могут выставить errno,
+# без -fno-math-errno остаются скалярными вызовами внутри цикла
+!msvc {
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS_RELEASE += -O3
+    QMAKE_CXXFLAGS += -fno-math-errno
+}
+
 SOURCES += main.cpp \
            complexplaneview.cpp \
            dragpoint.cpp \
@@ -10,7 +19,37 @@ SOURCES += main.cpp \
            mainwindow.cpp \
            coordtransform.cpp \
            spherewidget.cpp \
-           complexplaneview2.cpp
+           complexplaneview2.cpp \
+           planerenderthread.cpp \
+           acceleratedgraphicsview.cpp \
+           shapestate.cpp \
+           updatescheduler.cpp \
+           mathparser.cpp \
+           positionsource.cpp \
+           simulationworker.cpp \
+           timelinecache.cpp \
+           adaptivesampler.cpp \
+           functionfile.cpp \
+           batchexport.cpp \
+           trajectoryrecording.cpp \
+           tabulatedsource.cpp \
+           threebody.cpp \
+           threebodysource.cpp \
+           integratorbench.cpp \
+           ensemble.cpp \
+           syzygydetector.cpp \
+           masssystem.cpp \
+           shapeevents.cpp \
+           poincaresection.cpp \
+           ftlemap.cpp \
+           periodicorbit.cpp \
+           periodicsource.cpp \
+           shapepotential.cpp \
+           geodesicfan.cpp \
+           healpix.cpp \
+           shapehistogram.cpp \
+           sphericalharmonics.cpp \
+           trianglemontecarlo.cpp
 
 HEADERS += dragpoint.h \
            complexplaneview.h \
@@ -19,4 +58,40 @@ HEADERS += dragpoint.h \
            mainwindow.h \
            coordtransform.h \
            spherewidget.h \
-           complexplaneview2.h
+           complexplaneview2.h \
+           planerenderthread.h \
+           acceleratedgraphicsview.h \
+           shapestate.h \
+           updatescheduler.h \
+           mathparser.h \
+           positionsource.h \
+           simulationworker.h \
+           spscring.h \
+           triplebuffer.h \
+           timelinecache.h \
+           parallelfor.h \
+           adaptivesampler.h \
+           trajectoryspan.h \
+           functionfile.h \
+           batchexport.h \
+           trajectoryrecording.h \
+           tabulatedsource.h \
+           threebody.h \
+           threebodysource.h \
+           integratorbench.h \
+           ensemble.h \
+           syzygydetector.h \
+           masssystem.h \
+           shapeevents.h \
+           threebodylanes.h \
+           poincaresection.h \
+           ftlemap.h \
+           periodicorbit.h \
+           periodicsource.h \
+           shapepotential.h \
+           geodesicfan.h \
+           healpix.h \
+           shapehistogram.h \
+           sphericalharmonics.h \
+           trianglemontecarlo.h \
+           philox.h
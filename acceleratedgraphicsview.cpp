@@ -0,0 +1,79 @@
+#include "acceleratedgraphicsview.h"
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+#include <QElapsedTimer>
+#include <QPaintEvent>
+#include <QDebug>
+
+void FrameStats::add(double ms)
+{
+    ++frames;
+    lastMs = ms;
+    totalMs += ms;
+    maxMs = qMax(maxMs, ms);
+}
+
+QString FrameStats::toString() const
+{
+    if (frames == 0) return "n/a";
+    return QString("%1 ms avg, %2 ms max (%3 frames)")
+        .arg(averageMs(), 0, 'f', 2)
+        .arg(maxMs, 0, 'f', 2)
+        .arg(frames);
+}
+
+AcceleratedGraphicsView::AcceleratedGraphicsView(QWidget* parent)
+    : QGraphicsView(parent)
+{
+}
+
+QString AcceleratedGraphicsView::backendName(Backend backend)
+{
+    return backend == OpenGL ? "OpenGL" : "Raster";
+}
+
+void AcceleratedGraphicsView::setOpenGLViewport(bool enabled)
+{
+    Backend newBackend = enabled ? OpenGL : Raster;
+    if (newBackend == m_backend) return;
+
+    if (enabled) {
+        // Контекст разделяется с SphereWidget благодаря AA_ShareOpenGLContexts.
+        // Мультисэмплинг нужен, чтобы GL-движок QPainter сглаживал линии и пути.
+        QOpenGLWidget* glViewport = new QOpenGLWidget;
+        QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+        format.setSamples(4);
+        glViewport->setFormat(format);
+
+        setViewport(glViewport);
+        // Частичные обновления для GL-поверхности только мешают
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    } else {
+        setViewport(new QWidget);
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    }
+
+    m_backend = newBackend;
+
+    // Новый viewport должен получить фон из таблицы стилей
+    setStyleSheet(styleSheet());
+    viewport()->update();
+
+    qDebug() << "Viewport backend switched to" << backendName(m_backend);
+}
+
+void AcceleratedGraphicsView::resetFrameStats()
+{
+    m_stats[Raster].reset();
+    m_stats[OpenGL].reset();
+}
+
+void AcceleratedGraphicsView::paintEvent(QPaintEvent* event)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QGraphicsView::paintEvent(event);
+
+    m_stats[m_backend].add(timer.nsecsElapsed() / 1.0e6);
+}
@@ -0,0 +1,48 @@
+#ifndef ACCELERATEDGRAPHICSVIEW_H
+#define ACCELERATEDGRAPHICSVIEW_H
+
+#include <QGraphicsView>
+#include <QString>
+
+// Статистика времени отрисовки кадра (время CPU в paintEvent)
+struct FrameStats {
+    int frames = 0;
+    double lastMs = 0.0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+
+    void add(double ms);
+    void reset() { *this = FrameStats(); }
+    double averageMs() const { return frames > 0 ? totalMs / frames : 0.0; }
+    QString toString() const;
+};
+
+// QGraphicsView, который умеет переключать viewport между растровым
+// движком и QOpenGLWidget и замеряет время отрисовки для каждого из них.
+class AcceleratedGraphicsView : public QGraphicsView
+{
+    Q_OBJECT
+public:
+    enum Backend { Raster = 0, OpenGL = 1 };
+
+    explicit AcceleratedGraphicsView(QWidget* parent = nullptr);
+
+    void setOpenGLViewport(bool enabled);
+    bool isOpenGLViewport() const { return m_backend == OpenGL; }
+    Backend backend() const { return m_backend; }
+
+    const FrameStats& frameStats(Backend backend) const { return m_stats[backend]; }
+    const FrameStats& frameStats() const { return m_stats[m_backend]; }
+    void resetFrameStats();
+
+    static QString backendName(Backend backend);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    Backend m_backend = Raster;
+    FrameStats m_stats[2];
+};
+
+#endif // ACCELERATEDGRAPHICSVIEW_H
@@ -0,0 +1,73 @@
+#include "adaptivesampler.h"
+#include <cmath>
+
+AdaptiveSampler::AdaptiveSampler(const PositionSource& source, const QList<double>& masses,
+                                 const Tolerance& tolerance)
+    : m_source(source), m_masses(masses), m_tolerance(tolerance)
+{
+}
+
+ShapeState AdaptiveSampler::evaluate(double t) const
+{
+    QPointF points[3];
+    if (!m_source.positionsAt(t, points)) return ShapeState();
+
+    PositionSource::fitToScene(points);
+    return ShapeState::compute({points[0], points[1], points[2]}, m_masses);
+}
+
+double AdaptiveSampler::sphereAngle(const ShapeState& a, const ShapeState& b)
+{
+    // 2·asin(|a-b|/2) точнее acos(a·b) для малых углов
+    double chord = (a.normalized - b.normalized).length();
+    return 2.0 * std::asin(qMin(1.0, chord / 2.0));
+}
+
+double AdaptiveSampler::zetaDistance(const ShapeState& a, const ShapeState& b)
+{
+    return std::hypot(a.zeta.x() - b.zeta.x(), a.zeta.y() - b.zeta.y());
+}
+
+bool AdaptiveSampler::isFineEnough(const ShapeState& a, const ShapeState& b) const
+{
+    return sphereAngle(a, b) <= m_tolerance.sphereAngle &&
+           zetaDistance(a, b) <= m_tolerance.zetaStep;
+}
+
+bool AdaptiveSampler::isNegligible(const ShapeState& a, const ShapeState& b) const
+{
+    return sphereAngle(a, b) < m_tolerance.sphereAngle * m_tolerance.coarsenFraction &&
+           zetaDistance(a, b) < m_tolerance.zetaStep * m_tolerance.coarsenFraction;
+}
+
+void AdaptiveSampler::refine(double t0, const ShapeState& s0, double t1, const ShapeState& s1,
+                             const std::function<void(double, const ShapeState&)>& emitSample)
+{
+    if (!s0.valid || !s1.valid) {
+        if (s1.valid) emitSample(t1, s1);
+        return;
+    }
+    refineRecursive(t0, s0, t1, s1, 0, emitSample);
+}
+
+void AdaptiveSampler::refineRecursive(double t0, const ShapeState& s0, double t1, const ShapeState& s1,
+                                      int depth, const std::function<void(double, const ShapeState&)>& emitSample)
+{
+    if (depth >= m_tolerance.maxDepth || isFineEnough(s0, s1)) {
+        emitSample(t1, s1);
+        return;
+    }
+
+    const double tm = 0.5 * (t0 + t1);
+    ShapeState sm = evaluate(tm);
+    ++m_extraEvaluations;
+
+    // Середина не определена (например, точное соударение) - не делим дальше
+    if (!sm.valid) {
+        emitSample(t1, s1);
+        return;
+    }
+
+    refineRecursive(t0, s0, tm, sm, depth + 1, emitSample);
+    refineRecursive(tm, sm, t1, s1, depth + 1, emitSample);
+}
@@ -0,0 +1,53 @@
+#ifndef ADAPTIVESAMPLER_H
+#define ADAPTIVESAMPLER_H
+
+#include <QList>
+#include <functional>
+#include "shapestate.h"
+#include "positionsource.h"
+
+// Адаптивная выборка траектории по длине дуги.
+// Интервал [t0, t1] делится пополам, пока угловой шаг на сфере и шаг в
+// плоскости ζ не станут меньше допуска (порядка пикселя на экране).
+// Там, где форма почти не меняется, выборки прореживаются.
+class AdaptiveSampler
+{
+public:
+    struct Tolerance {
+        double sphereAngle = 0.01;   // радианы
+        double zetaStep = 0.01;      // единицы плоскости ζ
+        int maxDepth = 10;           // не больше 2^maxDepth подынтервалов
+        double coarsenFraction = 0.5; // шаги меньше этой доли допуска пропускаются
+    };
+
+    AdaptiveSampler(const PositionSource& source, const QList<double>& masses,
+                    const Tolerance& tolerance);
+
+    // Полное состояние в момент t (с подгонкой мелких треугольников к сцене)
+    ShapeState evaluate(double t) const;
+
+    // Выдаёт точки на (t0, t1], включая t1, с подразбиением по допуску
+    void refine(double t0, const ShapeState& s0, double t1, const ShapeState& s1,
+                const std::function<void(double, const ShapeState&)>& emitSample);
+
+    // Шаг достаточно мал для отрисовки
+    bool isFineEnough(const ShapeState& a, const ShapeState& b) const;
+    // Шаг настолько мал, что точку можно не добавлять в след
+    bool isNegligible(const ShapeState& a, const ShapeState& b) const;
+
+    static double sphereAngle(const ShapeState& a, const ShapeState& b);
+    static double zetaDistance(const ShapeState& a, const ShapeState& b);
+
+    int extraEvaluations() const { return m_extraEvaluations; }
+
+private:
+    void refineRecursive(double t0, const ShapeState& s0, double t1, const ShapeState& s1, int depth,
+                         const std::function<void(double, const ShapeState&)>& emitSample);
+
+    const PositionSource& m_source;
+    QList<double> m_masses;
+    Tolerance m_tolerance;
+    int m_extraEvaluations = 0;
+};
+
+#endif // ADAPTIVESAMPLER_H
@@ -0,0 +1,329 @@
+#include "batchexport.h"
+#include "parallelfor.h"
+#include "functionfile.h"
+#include "tabulatedsource.h"
+#include "integratorbench.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <limits>
+#include <cmath>
+
+namespace BatchExport {
+
+namespace {
+
+void fillRecord(double t, const ShapeState& state, double record[RecordFields])
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    int k = 0;
+    record[k++] = t;
+    for (int i = 0; i < 3; ++i) {
+        record[k++] = state.points[i].x();
+        record[k++] = state.points[i].y();
+    }
+    // ξ в порядке (ξ1, ξ2, ξ3) = (z, x, y) координат сферы
+    record[k++] = state.valid ? state.raw.z() : nan;
+    record[k++] = state.valid ? state.raw.x() : nan;
+    record[k++] = state.valid ? state.raw.y() : nan;
+    record[k++] = state.valid ? state.normalized.x() : nan;
+    record[k++] = state.valid ? state.normalized.y() : nan;
+    record[k++] = state.valid ? state.normalized.z() : nan;
+    record[k++] = state.valid ? state.zeta.x() : nan;
+    record[k++] = state.valid ? state.zeta.y() : nan;
+    record[k++] = state.valid ? 1.0 : 0.0;
+
+    double* roots = record + k;
+    for (int i = 0; i < 8; ++i) roots[i] = nan;
+    for (int i = 0; i < state.rootCount; ++i) {
+        int branch = state.roots[i].branch;
+        if (branch < 0 || branch >= 4) continue;
+        roots[2 * branch] = state.roots[i].point.x();
+        roots[2 * branch + 1] = state.roots[i].point.y();
+    }
+}
+
+void writeCsvRecords(QTextStream& out, const QVector<double>& times, const QVector<ShapeState>& states)
+{
+    double record[RecordFields];
+    for (int i = 0; i < states.size(); ++i) {
+        fillRecord(times[i], states[i], record);
+        for (int k = 0; k < RecordFields; ++k) {
+            if (k > 0) out << ',';
+            if (!std::isnan(record[k])) out << record[k];
+        }
+        out << '\n';
+    }
+}
+
+void writeBinaryHeader(QDataStream& out, quint64 count, const QList<double>& masses)
+{
+    out.writeRawData("TSBATCH1", 8);
+    out << quint32(1) << quint32(RecordFields) << count;
+    for (int i = 0; i < 3; ++i) {
+        out << masses.value(i, 1.0);
+    }
+}
+
+void writeBinaryRecords(QDataStream& out, const QVector<double>& times, const QVector<ShapeState>& states)
+{
+    double record[RecordFields];
+    for (int i = 0; i < states.size(); ++i) {
+        fillRecord(times[i], states[i], record);
+        for (double value : record) {
+            out << value;
+        }
+    }
+}
+
+QTextStream& errorStream()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+}
+
+QString csvHeader()
+{
+    return "t,x1,y1,x2,y2,x3,y3,xi1,xi2,xi3,nx,ny,nz,zeta_re,zeta_im,valid,"
+           "z0_re,z0_im,z1_re,z1_im,z2_re,z2_im,z3_re,z3_im";
+}
+
+QVector<ShapeState> sample(const PositionSource& source, const Options& options, qint64 first, int count,
+                           QVector<double>* times)
+{
+    const qint64 total = qMax<qint64>(1, options.samples);
+    const double step = total > 1 ? (options.tEnd - options.tStart) / double(total - 1) : 0.0;
+
+    QVector<ShapeState> states(count);
+    if (times) times->resize(count);
+    ShapeState* out = states.data();
+    double* outTimes = times ? times->data() : nullptr;
+
+    parallelFor(0, count, [&](int i) {
+        const double t = options.tStart + double(first + i) * step;
+        if (outTimes) outTimes[i] = t;
+
+        QPointF points[3];
+        if (!source.positionsAt(t, points)) return;
+        if (options.fitToScene) PositionSource::fitToScene(points);
+        out[i] = ShapeState::compute({points[0], points[1], points[2]}, options.masses);
+    });
+
+    return states;
+}
+
+bool write(const PositionSource& source, const Options& options, qint64* invalid, QString* error)
+{
+    QFile file(options.output);
+    const bool csv = options.format == Format::Csv;
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
+    if (csv) mode |= QIODevice::Text;
+
+    if (!file.open(mode)) {
+        if (error) *error = "Cannot open output file: " + options.output;
+        return false;
+    }
+
+    const qint64 total = qMax<qint64>(1, options.samples);
+    QTextStream text;
+    QDataStream data;
+    if (csv) {
+        text.setDevice(&file);
+        text.setRealNumberPrecision(17);
+        text << csvHeader() << '\n';
+    } else {
+        data.setDevice(&file);
+        data.setByteOrder(QDataStream::LittleEndian);
+        data.setFloatingPointPrecision(QDataStream::DoublePrecision);
+        writeBinaryHeader(data, quint64(total), options.masses);
+    }
+
+    if (invalid) *invalid = 0;
+    QVector<double> times;
+    for (qint64 first = 0; first < total; first += ChunkSamples) {
+        const int count = int(qMin<qint64>(ChunkSamples, total - first));
+        const QVector<ShapeState> states = sample(source, options, first, count, &times);
+        if (invalid) {
+            for (const ShapeState& state : states) {
+                if (!state.valid) ++*invalid;
+            }
+        }
+
+        bool ok;
+        if (csv) {
+            writeCsvRecords(text, times, states);
+            ok = text.status() == QTextStream::Ok;
+        } else {
+            writeBinaryRecords(data, times, states);
+            ok = data.status() == QDataStream::Ok;
+        }
+        if (!ok) {
+            if (error) *error = "Write error: " + file.errorString();
+            return false;
+        }
+    }
+
+    if (csv) {
+        text.flush();
+        if (text.status() != QTextStream::Ok) {
+            if (error) *error = "Write error: " + file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+int run(const Options& options)
+{
+    QTextStream& err = errorStream();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::shared_ptr<const PositionSource> source;
+    if (!options.table.isEmpty()) {
+        QString error;
+        std::shared_ptr<TabulatedSource> table = TabulatedSource::load(options.table, &error);
+        if (!table) {
+            err << "batch: " << error << '\n';
+            return 2;
+        }
+        err << "batch: table " << options.table << ": " << table->sampleCount() << " rows, "
+            << table->skippedLines() << " lines skipped, loaded in " << timer.restart() << " ms\n";
+        source = table;
+    } else {
+        auto expressions = std::make_shared<ExpressionSource>(options.functions);
+        if (!expressions->isValid()) {
+            err << "batch: six position functions are required (x1, y1, x2, y2, x3, y3)\n";
+            return 2;
+        }
+        source = expressions;
+    }
+
+    qint64 invalid = 0;
+    QString error;
+    try {
+        if (!write(*source, options, &invalid, &error)) {
+            err << "batch: " << error << '\n';
+            return 1;
+        }
+    }
+    catch (const std::exception& e) {
+        err << "batch: sampling failed: " << e.what() << '\n';
+        return 1;
+    }
+
+    err << "batch: " << qMax<qint64>(1, options.samples) << " samples (" << invalid << " invalid) on "
+        << QThread::idealThreadCount() << " threads, sampled and written in " << timer.elapsed()
+        << " ms to " << options.output << '\n';
+    err.flush();
+    return 0;
+}
+
+int runFromCommandLine(const QStringList& arguments)
+{
+    QTextStream& err = errorStream();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless trajectory sampling and export");
+    parser.addHelpOption();
+
+    QCommandLineOption batchOption("batch", "Run without a window.");
+    QCommandLineOption functionsOption({"f", "functions"}, "Function file (x1 = ..., y1 = ..., ...).", "file");
+    QCommandLineOption tableOption("table", "Position table t, x1, y1, ..., y3 (CSV or binary) instead of functions.", "file");
+    QCommandLineOption massesOption({"m", "masses"}, "Masses m1,m2,m3 (default 1,1,1).", "list", "1,1,1");
+    QCommandLineOption startOption("t0", "Start time (default 0).", "time", "0");
+    QCommandLineOption endOption("t1", "End time (default 20).", "time", "20");
+    QCommandLineOption samplesOption({"n", "samples"}, "Number of samples (default 1000).", "count", "1000");
+    QCommandLineOption outputOption({"o", "output"}, "Output file.", "file");
+    QCommandLineOption formatOption("format", "csv or binary (default: by extension, .bin is binary).", "format");
+    QCommandLineOption fitOption("fit-to-scene", "Scale small triangles as the GUI does.");
+    QCommandLineOption benchOption("bench-integrators",
+                                   "Compare three-body integrators on close-encounter orbits up to --t1.");
+    parser.addOptions({batchOption, functionsOption, tableOption, massesOption, startOption, endOption,
+                       samplesOption, outputOption, formatOption, fitOption, benchOption});
+
+    if (!parser.parse(arguments)) {
+        err << "batch: " << parser.errorText() << '\n';
+        return 2;
+    }
+    if (parser.isSet("help")) {
+        err << parser.helpText();
+        return 0;
+    }
+
+    if (parser.isSet(benchOption)) {
+        bool ok;
+        double tEnd = parser.value(endOption).toDouble(&ok);
+        if (!ok || tEnd <= 0) {
+            err << "batch: invalid --t1\n";
+            return 2;
+        }
+        QTextStream out(stdout);
+        return IntegratorBench::run(out, tEnd);
+    }
+
+    Options options;
+    QString error;
+    if (parser.isSet(tableOption)) {
+        options.table = parser.value(tableOption);
+    } else if (!parser.isSet(functionsOption) ||
+               !FunctionFile::load(parser.value(functionsOption), options.functions, &error)) {
+        err << "batch: " << (error.isEmpty() ? QString("--functions or --table is required") : error) << '\n';
+        return 2;
+    }
+
+    const QStringList massList = parser.value(massesOption).split(',');
+    if (massList.size() != 3) {
+        err << "batch: --masses expects three comma-separated values\n";
+        return 2;
+    }
+    options.masses.clear();
+    for (const QString& text : massList) {
+        bool ok;
+        double mass = text.trimmed().toDouble(&ok);
+        if (!ok || mass <= 0) {
+            err << "batch: masses must be positive numbers\n";
+            return 2;
+        }
+        options.masses.append(mass);
+    }
+
+    bool ok1, ok2, ok3;
+    options.tStart = parser.value(startOption).toDouble(&ok1);
+    options.tEnd = parser.value(endOption).toDouble(&ok2);
+    options.samples = parser.value(samplesOption).toLongLong(&ok3);
+    if (!ok1 || !ok2 || !ok3 || options.samples < 1) {
+        err << "batch: invalid time range or sample count\n";
+        return 2;
+    }
+
+    options.output = parser.value(outputOption);
+    if (options.output.isEmpty()) {
+        err << "batch: --output is required\n";
+        return 2;
+    }
+
+    QString format = parser.value(formatOption).toLower();
+    if (format.isEmpty()) {
+        format = options.output.endsWith(".bin", Qt::CaseInsensitive) ? "binary" : "csv";
+    }
+    if (format == "csv") {
+        options.format = Format::Csv;
+    } else if (format == "binary" || format == "bin") {
+        options.format = Format::Binary;
+    } else {
+        err << "batch: unknown format " << format << '\n';
+        return 2;
+    }
+
+    options.fitToScene = parser.isSet(fitOption);
+    return run(options);
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef BATCHEXPORT_H
+#define BATCHEXPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include "shapestate.h"
+#include "positionsource.h"
+
+// Пакетный (безоконный) режим: выборка траектории на всех ядрах и запись
+// треугольника, ξ, точки на сфере, ζ и корней z в CSV или бинарный файл.
+namespace BatchExport {
+
+enum class Format {
+    Csv,
+    Binary
+};
+
+struct Options {
+    QStringList functions;           // x1, y1, x2, y2, x3, y3
+    QString table;                   // вместо функций: таблица положений (TabulatedSource)
+    QList<double> masses = {1.0, 1.0, 1.0};
+    double tStart = 0.0;
+    double tEnd = 20.0;
+    qint64 samples = 1000;
+    bool fitToScene = false;         // масштабировать мелкие треугольники, как в GUI
+    QString output;
+    Format format = Format::Csv;
+};
+
+// Бинарный формат: заголовок и затем samples записей по RecordFields double.
+//   char[8]  magic "TSBATCH1"
+//   quint32  version (1)
+//   quint32  число полей в записи
+//   quint64  число записей
+//   double   массы m1, m2, m3
+// Поля записи: t, x1, y1, x2, y2, x3, y3, ξ1, ξ2, ξ3 (ненормированные),
+// n_x, n_y, n_z, ζ_re, ζ_im, valid, затем для ветвей 0..3: re, im (NaN, если корня нет).
+// Все числа little-endian.
+constexpr int RecordFields = 16 + 8;
+
+// Заголовок CSV в том же порядке полей
+QString csvHeader();
+
+// Выборка и запись идут кусками по ChunkSamples: память не зависит от samples
+constexpr int ChunkSamples = 1 << 16;
+
+// Вычисляет count состояний из samples на [tStart, tEnd], начиная с номера first, параллельно
+QVector<ShapeState> sample(const PositionSource& source, const Options& options, qint64 first, int count,
+                           QVector<double>* times = nullptr);
+
+// Выборка всех samples состояний с записью в options.output по мере готовности кусков
+bool write(const PositionSource& source, const Options& options, qint64* invalid = nullptr,
+           QString* error = nullptr);
+
+// Полный прогон с сообщениями в stderr; возвращает код завершения процесса
+int run(const Options& options);
+
+// Разбор аргументов командной строки (--batch ...) и запуск
+int runFromCommandLine(const QStringList& arguments);
+
+}
+
+#endif // BATCHEXPORT_H
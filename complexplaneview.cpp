@@ -4,9 +4,11 @@
 #include <QPainterPath>
 #include <QResizeEvent>
 #include <QDebug>
+#include "trajectoryspan.h"
+#include <cmath>
 
 ComplexPlaneView::ComplexPlaneView(QWidget *parent)
-    : QGraphicsView(parent), m_showTrajectory(false), m_drawingEnabled(true),
+    : AcceleratedGraphicsView(parent), m_showTrajectory(false), m_drawingEnabled(true),
     m_pointItem(nullptr), m_trajectoryItem(nullptr)
 {
     m_scene = new QGraphicsScene(this);
@@ -168,6 +170,95 @@ void ComplexPlaneView::drawForeground(QPainter* painter, const QRectF& rect)
 {
     QGraphicsView::drawForeground(painter, rect);
     // Больше не рисуем здесь систему координат - она создана как элементы сцены
+
+    // В фоновом режиме выводим только готовый кадр (он уже в координатах viewport)
+    if (m_renderThread && !m_frame.isNull()) {
+        painter->save();
+        painter->resetTransform();
+        painter->drawImage(QPointF(0, 0), m_frame);
+        painter->restore();
+    }
+
+    // Россыпь рисуется поверх кадра в координатах сцены
+    if (m_scatterTotal > 0) {
+        if (m_scatterDirty) updateScatterImage();
+        painter->drawImage(QRectF(m_minValue, m_minValue, m_maxValue - m_minValue, m_maxValue - m_minValue),
+                           m_scatterImage);
+
+        if (!m_scatterXLabel.isEmpty() || !m_scatterYLabel.isEmpty()) {
+            painter->save();
+            painter->resetTransform();
+            painter->setPen(QColor(20, 40, 140));
+            painter->drawText(QPointF(8, 16), QString("x: %1, y: %2, %3 points")
+                                                  .arg(m_scatterXLabel, m_scatterYLabel)
+                                                  .arg(m_scatterTotal));
+            painter->restore();
+        }
+    }
+}
+
+void ComplexPlaneView::appendScatter(const QPointF* points, int count)
+{
+    if (!points || count <= 0) return;
+
+    const int n = ScatterResolution;
+    if (m_scatterCounts.isEmpty()) m_scatterCounts.fill(0, n * n);
+
+    const double scale = n / (m_maxValue - m_minValue);
+    for (int i = 0; i < count; ++i) {
+        const int column = static_cast<int>((points[i].x() - m_minValue) * scale);
+        const int row = static_cast<int>((points[i].y() - m_minValue) * scale);
+        if (column < 0 || column >= n || row < 0 || row >= n) continue;
+
+        quint32& cell = m_scatterCounts[row * n + column];
+        ++cell;
+        m_scatterMax = qMax(m_scatterMax, cell);
+        ++m_scatterTotal;
+    }
+
+    m_scatterDirty = true;
+    viewport()->update();
+}
+
+void ComplexPlaneView::clearScatter()
+{
+    m_scatterCounts.clear();
+    m_scatterMax = 0;
+    m_scatterTotal = 0;
+    m_scatterImage = QImage();
+    m_scatterDirty = false;
+    viewport()->update();
+}
+
+void ComplexPlaneView::setScatterLabels(const QString& xLabel, const QString& yLabel)
+{
+    m_scatterXLabel = xLabel;
+    m_scatterYLabel = yLabel;
+    viewport()->update();
+}
+
+void ComplexPlaneView::updateScatterImage()
+{
+    const int n = ScatterResolution;
+    if (m_scatterImage.size() != QSize(n, n)) {
+        m_scatterImage = QImage(n, n, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    // Логарифмическая шкала: одиночные точки видны и рядом с плотными областями
+    const double norm = 1.0 / std::log1p(double(qMax<quint32>(1, m_scatterMax)));
+    for (int row = 0; row < n; ++row) {
+        QRgb* line = reinterpret_cast<QRgb*>(m_scatterImage.scanLine(row));
+        const quint32* counts = m_scatterCounts.constData() + row * n;
+        for (int column = 0; column < n; ++column) {
+            if (counts[column] == 0) {
+                line[column] = 0;
+                continue;
+            }
+            const int alpha = 80 + static_cast<int>(175.0 * std::log1p(double(counts[column])) * norm);
+            line[column] = qPremultiply(qRgba(20, 40, 140, qMin(alpha, 255)));
+        }
+    }
+    m_scatterDirty = false;
 }
 
 void ComplexPlaneView::resizeEvent(QResizeEvent* event)
@@ -175,6 +266,87 @@ void ComplexPlaneView::resizeEvent(QResizeEvent* event)
     QGraphicsView::resizeEvent(event);
     // Подгоняем вид при изменении размера
     fitInView(m_scene->sceneRect(), Qt::KeepAspectRatio);
+    requestFrame();
+}
+
+void ComplexPlaneView::setThreadedRendering(bool enabled)
+{
+    if (enabled == isThreadedRendering()) return;
+
+    if (enabled) {
+        m_renderThread = new PlaneRenderThread(this);
+        connect(m_renderThread, &PlaneRenderThread::frameReady, this,
+                [this](const QImage& frame, quint64) {
+            // Кадр мог прийти уже после выключения режима
+            if (!m_renderThread) return;
+            m_frame = frame;
+            viewport()->update();
+        });
+
+        // Элементы сцены больше не рисуются - их заменяет готовый кадр
+        for (QGraphicsItem* item : m_scene->items()) {
+            item->setVisible(false);
+        }
+
+        m_renderThread->start();
+        requestFrame();
+    } else {
+        m_renderThread->stop();
+        delete m_renderThread;
+        m_renderThread = nullptr;
+        m_frame = QImage();
+
+        // Возвращаем элементы сцены и синхронизируем их с текущим состоянием
+        for (QGraphicsItem* item : m_scene->items()) {
+            item->setVisible(true);
+        }
+        updatePoint();
+        updateTrajectory();
+        viewport()->update();
+    }
+}
+
+PlaneSnapshot ComplexPlaneView::makeSnapshot() const
+{
+    PlaneSnapshot snapshot;
+    snapshot.size = viewport()->size();
+    snapshot.devicePixelRatio = viewport()->devicePixelRatioF();
+    snapshot.transform = viewportTransform();
+    snapshot.background = Qt::white;
+
+    snapshot.gridMin = m_minValue;
+    snapshot.gridMax = m_maxValue;
+    snapshot.gridStep = 0.1;
+    snapshot.tickStep = 0.5;
+    snapshot.gridColor = QColor(220, 220, 220);
+    snapshot.xLabel = "ξ₂";
+    snapshot.yLabel = "ξ₃";
+
+    if (m_showTrajectory) {
+        PlaneSnapshot::Trail trail;
+        trail.color = QColor(0, 100, 200);
+        trail.width = 0.02;
+        trail.segments = m_trajectorySegments; // копия без копирования данных
+        snapshot.trails.append(trail);
+    }
+
+    if (!m_currentPoint.isNull()) {
+        PlaneSnapshot::Marker marker;
+        marker.pos = complexToScene(m_currentPoint);
+        marker.color = Qt::red;
+        snapshot.markers.append(marker);
+    }
+
+    return snapshot;
+}
+
+void ComplexPlaneView::requestFrame()
+{
+    if (!m_renderThread) return;
+
+    PlaneSnapshot snapshot = makeSnapshot();
+    snapshot.serial = ++m_frameSerial;
+    m_renderThread->submit(snapshot);
 }
 
 void ComplexPlaneView::setPoint(const QPointF& point)
@@ -185,6 +357,11 @@ void ComplexPlaneView::setPoint(const QPointF& point)
 
 void ComplexPlaneView::updatePoint()
 {
+    if (m_renderThread) {
+        requestFrame();
+        return;
+    }
+
     if (!m_pointItem) return;
 
     if (m_currentPoint.isNull()) {
@@ -217,16 +394,66 @@ void ComplexPlaneView::addToTrajectory(const QPointF& point)
 
     m_trajectorySegments.last().append(QPointF(xi2, xi3));
 
+    trimLiveTrajectory();
+    updateTrajectory();
+}
+
+void ComplexPlaneView::appendTrajectory(const QPointF* points, int count)
+{
+    if (!m_drawingEnabled || !points || count <= 0) return;
+
+    appendTrajectorySpan(points, count);
+    trimLiveTrajectory();
+    updateTrajectory();
+}
+
+void ComplexPlaneView::trimLiveTrajectory()
+{
     // Ограничиваем длину для производительности
-    if (m_trajectorySegments.last().size() > 1000) {
-        m_trajectorySegments.last().removeFirst();
+    QVector<QPointF>& segment = m_trajectorySegments.last();
+    if (segment.size() > LiveTrajectoryLimit) {
+        segment.remove(0, segment.size() - LiveTrajectoryLimit);
     }
+}
 
+void ComplexPlaneView::replaceTrajectory(const QPointF* points, int count)
+{
+    if (!m_drawingEnabled) return;
+
+    m_trajectorySegments.clear();
+    m_trajectorySegments.append(QVector<QPointF>());
+
+    if (points && count > 0) {
+        appendTrajectorySpan(points, count);
+    }
     updateTrajectory();
 }
 
+void ComplexPlaneView::appendTrajectorySpan(const QPointF* points, int count)
+{
+    if (m_trajectorySegments.isEmpty()) {
+        m_trajectorySegments.append(QVector<QPointF>());
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (isTrajectoryBreak(points[i])) {
+            if (!m_trajectorySegments.last().isEmpty()) {
+                m_trajectorySegments.append(QVector<QPointF>());
+            }
+            continue;
+        }
+        m_trajectorySegments.last().append(QPointF(qBound(m_minValue, points[i].x(), m_maxValue),
+                                                   qBound(m_minValue, points[i].y(), m_maxValue)));
+    }
+}
+
 void ComplexPlaneView::updateTrajectory()
 {
+    if (m_renderThread) {
+        requestFrame();
+        return;
+    }
+
     if (!m_trajectoryItem) return;
 
     QPainterPath path;
@@ -5,8 +5,11 @@
 #include <QGraphicsScene>
 #include <QPointF>
 #include <QVector>
+#include <QImage>
+#include "planerenderthread.h"
+#include "acceleratedgraphicsview.h"
 
-class ComplexPlaneView : public QGraphicsView
+class ComplexPlaneView : public AcceleratedGraphicsView
 {
     Q_OBJECT
 public:
@@ -14,12 +17,28 @@ public:
 
     void setPoint(const QPointF& point);
     void addToTrajectory(const QPointF& point);
+    // Пакетная загрузка ζ: NaN-точка (trajectoryBreakPoint) начинает новый сегмент.
+    // Путь перестраивается один раз на вызов.
+    void appendTrajectory(const QPointF* points, int count);
+    void replaceTrajectory(const QPointF* points, int count);
     void clearTrajectory();
     void setShowTrajectory(bool show);
     void breakTrajectory();
     void setDrawingEnabled(bool enabled) { m_drawingEnabled = enabled; }
     bool isDrawingEnabled() const { return m_drawingEnabled; }
 
+    // Плотная россыпь точек (например, сечение Пуанкаре) поверх плоскости:
+    // попадания копятся по пикселям, так что миллионы точек стоят как одна картинка.
+    // Точки вне [-1, 1]² отбрасываются.
+    void appendScatter(const QPointF* points, int count);
+    void clearScatter();
+    void setScatterLabels(const QString& xLabel, const QString& yLabel);
+    bool hasScatter() const { return m_scatterTotal > 0; }
+
+    // Растеризация плоскости в рабочем потоке: GUI только выводит готовый кадр
+    void setThreadedRendering(bool enabled);
+    bool isThreadedRendering() const { return m_renderThread != nullptr; }
+
 protected:
     void drawForeground(QPainter* painter, const QRectF& rect) override;
     void resizeEvent(QResizeEvent* event) override;
@@ -28,8 +47,15 @@ private:
     void createCoordinateSystem();
     void updatePoint();
     void updateTrajectory();
+    void appendTrajectorySpan(const QPointF* points, int count);
+    void trimLiveTrajectory();
+
+    static constexpr int LiveTrajectoryLimit = 1000;
     QPointF sceneToComplex(const QPointF& scenePoint) const;
     QPointF complexToScene(const QPointF& complexPoint) const;
+    void updateScatterImage();
+    PlaneSnapshot makeSnapshot() const;
+    void requestFrame();
 
     QGraphicsScene* m_scene;
     QPointF m_currentPoint;
@@ -42,6 +68,21 @@ private:
     QGraphicsEllipseItem* m_pointItem;
     QGraphicsPathItem* m_trajectoryItem;
 
+    // Фоновая растеризация
+    PlaneRenderThread* m_renderThread = nullptr;
+    QImage m_frame;
+    quint64 m_frameSerial = 0;
+
+    // Россыпь: счётчики попаданий и их раскраска (обновляется при отрисовке)
+    static constexpr int ScatterResolution = 512;
+    QVector<quint32> m_scatterCounts;
+    quint32 m_scatterMax = 0;
+    quint64 m_scatterTotal = 0;
+    QImage m_scatterImage;
+    bool m_scatterDirty = false;
+    QString m_scatterXLabel;
+    QString m_scatterYLabel;
+
     // Область отображения в комплексных координатах
     const double m_minValue = -1.0;
     const double m_maxValue = 1.0;
@@ -5,10 +5,11 @@
 #include <QPainterPath>
 #include <QResizeEvent>
 #include <QDebug>
+#include "trajectoryspan.h"
 #include <QGraphicsRectItem> // Для легенды
 
 ComplexPlaneView2::ComplexPlaneView2(QWidget *parent)
-    : QGraphicsView(parent), m_showTrajectory(false), m_drawingEnabled(true)
+    : AcceleratedGraphicsView(parent), m_showTrajectory(false), m_drawingEnabled(true)
 {
     m_scene = new QGraphicsScene(this);
     setScene(m_scene);
@@ -171,19 +172,79 @@ void ComplexPlaneView2::addToTrajectory(const QVector<ComplexSolution>& solution
             }
 
             m_trajectoryBranches[branch].last().append(solution.point);
+        }
+    }
 
-            // Ограничиваем длину траектории
-            if (m_trajectoryBranches[branch].last().size() > 500) {
-                m_trajectoryBranches[branch].last().removeFirst();
-            }
+    trimLiveTrajectories();
+    updateTrajectory();
+}
+
+void ComplexPlaneView2::appendTrajectories(const QPointF* const branches[4], int count)
+{
+    if (!m_drawingEnabled || !branches || count <= 0) return;
+
+    appendTrajectorySpans(branches, count);
+    trimLiveTrajectories();
+    updateTrajectory();
+}
+
+void ComplexPlaneView2::trimLiveTrajectories()
+{
+    // Ограничиваем длину траектории
+    for (int branch = 0; branch < 4; ++branch) {
+        if (m_trajectoryBranches[branch].isEmpty()) continue;
+        QVector<QPointF>& segment = m_trajectoryBranches[branch].last();
+        if (segment.size() > LiveTrajectoryLimit) {
+            segment.remove(0, segment.size() - LiveTrajectoryLimit);
         }
     }
+}
 
+void ComplexPlaneView2::replaceTrajectories(const QPointF* const branches[4], int count)
+{
+    if (!m_drawingEnabled) return;
+
+    for (int i = 0; i < 4; ++i) {
+        m_trajectoryBranches[i].clear();
+        m_trajectoryBranches[i].append(QVector<QPointF>());
+    }
+
+    if (branches && count > 0) {
+        appendTrajectorySpans(branches, count);
+    }
     updateTrajectory();
 }
 
+void ComplexPlaneView2::appendTrajectorySpans(const QPointF* const branches[4], int count)
+{
+    for (int branch = 0; branch < 4; ++branch) {
+        const QPointF* points = branches[branch];
+        if (!points) continue;
+
+        QVector<QVector<QPointF>>& segments = m_trajectoryBranches[branch];
+        if (segments.isEmpty()) {
+            segments.append(QVector<QPointF>());
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (isTrajectoryBreak(points[i])) {
+                if (!segments.last().isEmpty()) {
+                    segments.append(QVector<QPointF>());
+                }
+                continue;
+            }
+            segments.last().append(points[i]);
+        }
+    }
+}
+
 void ComplexPlaneView2::updatePoints()
 {
+    if (m_renderThread) {
+        requestFrame();
+        return;
+    }
+
     // Сначала скрываем все точки
     for (auto item : m_pointItems) {
         if (item) item->setVisible(false);
@@ -202,6 +263,11 @@ void ComplexPlaneView2::updatePoints()
 
 void ComplexPlaneView2::updateTrajectory()
 {
+    if (m_renderThread) {
+        requestFrame();
+        return;
+    }
+
     for (int branch = 0; branch < 4; ++branch) {
         if (!m_trajectoryItems[branch]) continue;
 
@@ -246,6 +312,14 @@ QPointF ComplexPlaneView2::complexToScene(const QPointF& complexPoint) const
 void ComplexPlaneView2::drawForeground(QPainter* painter, const QRectF& rect)
 {
     QGraphicsView::drawForeground(painter, rect);
+
+    // В фоновом режиме выводим только готовый кадр (он уже в координатах viewport)
+    if (m_renderThread && !m_frame.isNull()) {
+        painter->save();
+        painter->resetTransform();
+        painter->drawImage(QPointF(0, 0), m_frame);
+        painter->restore();
+    }
 }
 
 void ComplexPlaneView2::resizeEvent(QResizeEvent* event)
@@ -253,6 +327,91 @@ void ComplexPlaneView2::resizeEvent(QResizeEvent* event)
     QGraphicsView::resizeEvent(event);
     // Подгоняем вид при изменении размера
     fitInView(m_scene->sceneRect(), Qt::KeepAspectRatio);
+    requestFrame();
+}
+
+void ComplexPlaneView2::setThreadedRendering(bool enabled)
+{
+    if (enabled == isThreadedRendering()) return;
+
+    if (enabled) {
+        m_renderThread = new PlaneRenderThread(this);
+        connect(m_renderThread, &PlaneRenderThread::frameReady, this,
+                [this](const QImage& frame, quint64) {
+            // Кадр мог прийти уже после выключения режима
+            if (!m_renderThread) return;
+            m_frame = frame;
+            viewport()->update();
+        });
+
+        // Элементы сцены больше не рисуются - их заменяет готовый кадр
+        for (QGraphicsItem* item : m_scene->items()) {
+            item->setVisible(false);
+        }
+
+        m_renderThread->start();
+        requestFrame();
+    } else {
+        m_renderThread->stop();
+        delete m_renderThread;
+        m_renderThread = nullptr;
+        m_frame = QImage();
+
+        // Возвращаем элементы сцены и синхронизируем их с текущим состоянием
+        for (QGraphicsItem* item : m_scene->items()) {
+            item->setVisible(true);
+        }
+        updatePoints();
+        updateTrajectory();
+        viewport()->update();
+    }
+}
+
+PlaneSnapshot ComplexPlaneView2::makeSnapshot() const
+{
+    PlaneSnapshot snapshot;
+    snapshot.size = viewport()->size();
+    snapshot.devicePixelRatio = viewport()->devicePixelRatioF();
+    snapshot.transform = viewportTransform();
+    snapshot.background = QColor(0xFF, 0xF8, 0xDC);
+
+    snapshot.gridMin = m_minValue;
+    snapshot.gridMax = m_maxValue;
+    snapshot.gridStep = 0.5;
+    snapshot.tickStep = 1.0;
+    snapshot.gridColor = QColor(240, 240, 240);
+    snapshot.tickLabels = false;
+    snapshot.xLabel = "Re(z)";
+    snapshot.yLabel = "Im(z)";
+    snapshot.legend = m_branchColors;
+
+    if (m_showTrajectory) {
+        for (int branch = 0; branch < 4; ++branch) {
+            PlaneSnapshot::Trail trail;
+            trail.color = m_branchColors[branch];
+            trail.width = 0.015;
+            trail.segments = m_trajectoryBranches[branch]; // копия без копирования данных
+            snapshot.trails.append(trail);
+        }
+    }
+
+    for (const ComplexSolution& solution : m_currentSolutions) {
+        PlaneSnapshot::Marker marker;
+        marker.pos = complexToScene(solution.point);
+        marker.color = solution.color;
+        snapshot.markers.append(marker);
+    }
+
+    return snapshot;
+}
+
+void ComplexPlaneView2::requestFrame()
+{
+    if (!m_renderThread) return;
+
+    PlaneSnapshot snapshot = makeSnapshot();
+    snapshot.serial = ++m_frameSerial;
+    m_renderThread->submit(snapshot);
 }
 
 void ComplexPlaneView2::clearTrajectory()
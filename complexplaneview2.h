@@ -5,10 +5,13 @@
 #include <QGraphicsScene>
 #include <QPointF>
 #include <QVector>
+#include <QImage>
 #include <QColor>
 #include "coordtransform.h" // Включаем полное определение ComplexSolution
+#include "planerenderthread.h"
+#include "acceleratedgraphicsview.h"
 
-class ComplexPlaneView2 : public QGraphicsView
+class ComplexPlaneView2 : public AcceleratedGraphicsView
 {
     Q_OBJECT
 public:
@@ -16,12 +19,20 @@ public:
 
     void setSolutions(const QVector<ComplexSolution>& solutions);
     void addToTrajectory(const QVector<ComplexSolution>& solutions);
+    // Пакетная загрузка: branches[i] - буфер из count точек ветви i (или nullptr),
+    // NaN-точка (trajectoryBreakPoint) разрывает ветвь. Одна перестройка путей на вызов.
+    void appendTrajectories(const QPointF* const branches[4], int count);
+    void replaceTrajectories(const QPointF* const branches[4], int count);
     void clearTrajectory();
     void setShowTrajectory(bool show);
     void breakTrajectory();
     void setDrawingEnabled(bool enabled) { m_drawingEnabled = enabled; }
     bool isDrawingEnabled() const { return m_drawingEnabled; }
 
+    // Растеризация плоскости в рабочем потоке: GUI только выводит готовый кадр
+    void setThreadedRendering(bool enabled);
+    bool isThreadedRendering() const { return m_renderThread != nullptr; }
+
 protected:
     void drawForeground(QPainter* painter, const QRectF& rect) override;
     void resizeEvent(QResizeEvent* event) override;
@@ -30,8 +41,14 @@ private:
     void createCoordinateSystem();
     void updatePoints();
     void updateTrajectory();
+    void appendTrajectorySpans(const QPointF* const branches[4], int count);
+    void trimLiveTrajectories();
+
+    static constexpr int LiveTrajectoryLimit = 500;
     QPointF sceneToComplex(const QPointF& scenePoint) const;
     QPointF complexToScene(const QPointF& complexPoint) const;
+    PlaneSnapshot makeSnapshot() const;
+    void requestFrame();
 
     QGraphicsScene* m_scene;
     QVector<ComplexSolution> m_currentSolutions;
@@ -47,6 +64,11 @@ private:
     QVector<QGraphicsEllipseItem*> m_pointItems;
     QVector<QGraphicsPathItem*> m_trajectoryItems;
 
+    // Фоновая растеризация
+    PlaneRenderThread* m_renderThread = nullptr;
+    QImage m_frame;
+    quint64 m_frameSerial = 0;
+
     // Область отображения
     const double m_minValue = -3.0;
     const double m_maxValue = 3.0;
@@ -92,6 +92,53 @@ QVector3D CoordTransform::getRawSphereCoordinates(const QList<QPointF>& points,
     }
 }
 
+namespace {
+
+// Цикл пакетного getRawSphereCoordinates. Массивы не пересекаются, и __restrict
+// на параметрах говорит это компилятору: иначе GCC нужно 18 проверок
+// перекрытия на входе в цикл, больше его предела, и цикл остаётся скалярным
+void rawSphereBlock(int count,
+                    const double* __restrict x1, const double* __restrict y1,
+                    const double* __restrict x2, const double* __restrict y2,
+                    const double* __restrict x3, const double* __restrict y3,
+                    double mu1, double mu2, double a, double b, double cross,
+                    double* __restrict xi2, double* __restrict xi3, double* __restrict xi1)
+{
+    for (int n = 0; n < count; ++n) {
+        const double q1x = x2[n] - x1[n];
+        const double q1y = y2[n] - y1[n];
+        const double q2x = x3[n] - (a * x1[n] + b * x2[n]);
+        const double q2y = y3[n] - (a * y1[n] + b * y2[n]);
+
+        // ξ2 + iξ3 = 2√(μ1μ2) q1·conj(q2)
+        xi1[n] = mu1 * (q1x * q1x + q1y * q1y) - mu2 * (q2x * q2x + q2y * q2y);
+        xi2[n] = cross * (q1x * q2x + q1y * q2y);
+        xi3[n] = cross * (q1y * q2x - q1x * q2y);
+    }
+}
+
+} // namespace
+
+bool CoordTransform::getRawSphereCoordinates(int count, const double* const positions[6],
+                                             const QList<double>& masses, double* const coordinates[3]) {
+    if (masses.size() != 3) return false;
+    for (int i = 0; i < 3; ++i) {
+        if (!(masses[i] > 0) || !std::isfinite(masses[i])) return false;
+    }
+
+    // Те же формулы, что и для одного треугольника: q1 = r2 - r1, q2 = r3 - ц.м.(r1, r2)
+    const double m12 = masses[0] + masses[1];
+    const double mu1 = masses[0] * masses[1] / m12;
+    const double mu2 = masses[2] * m12 / (m12 + masses[2]);
+    const double a = masses[0] / m12;
+    const double b = masses[1] / m12;
+    const double cross = 2.0 * std::sqrt(mu1 * mu2);
+
+    rawSphereBlock(count, positions[0], positions[1], positions[2], positions[3], positions[4], positions[5],
+                   mu1, mu2, a, b, cross, coordinates[0], coordinates[1], coordinates[2]);
+    return true;
+}
+
 QVector<QPointF> CoordTransform::transformFromSphere(const QVector3D& spherePoint, const QList<double>& masses, double scale) {
     try {
         if (masses.size() != 3) {
@@ -185,8 +232,35 @@ QVector<QPointF> CoordTransform::transformFromSphere(const QVector3D& spherePoin
 
 QVector<ComplexSolution> CoordTransform::transformZetaToZ(const QPointF& zetaPoint)
 {
+    ComplexSolution buffer[4];
+    int count = transformZetaToZ(zetaPoint, buffer);
+
     QVector<ComplexSolution> solutions;
-    
+    solutions.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        solutions.append(buffer[i]);
+    }
+
+    qDebug() << "Found" << solutions.size() << "solutions for ζ =" << zetaPoint.x() << "+ i" << zetaPoint.y();
+
+    return solutions;
+}
+
+QColor CoordTransform::branchColor(int branch)
+{
+    static const QColor colors[4] = {
+        QColor(255, 0, 0),    // Красный - ветвь 0
+        QColor(0, 255, 0),    // Зеленый - ветвь 1
+        QColor(0, 0, 255),    // Синий - ветвь 2
+        QColor(255, 165, 0)   // Оранжевый - ветвь 3
+    };
+    return (branch >= 0 && branch < 4) ? colors[branch] : QColor(Qt::black);
+}
+
+int CoordTransform::transformZetaToZ(const QPointF& zetaPoint, ComplexSolution solutions[4])
+{
+    int count = 0;
+
     try {
         std::complex<double> zeta(zetaPoint.x(), zetaPoint.y());
         
@@ -195,23 +269,18 @@ QVector<ComplexSolution> CoordTransform::transformZetaToZ(const QPointF& zetaPoi
         std::complex<double> inner_sqrt = std::sqrt(zeta2 - zeta + 1.0);
         
         // 4 комбинации знаков
-        std::complex<double> signs[4][2] = {
+        static const double signs[4][2] = {
             {+1.0, -1.0}, // ветвь 0: +, -
             {+1.0, +1.0}, // ветвь 1: +, +
             {-1.0, -1.0}, // ветвь 2: -, -
             {-1.0, +1.0}  // ветвь 3: -, +
         };
         
-        QColor colors[4] = {
-            QColor(255, 0, 0),    // Красный - ветвь 0
-            QColor(0, 255, 0),    // Зеленый - ветвь 1  
-            QColor(0, 0, 255),    // Синий - ветвь 2
-            QColor(255, 165, 0)   // Оранжевый - ветвь 3
-        };
+        const double invSqrt2 = 1.0 / std::sqrt(2.0);
         
         for (int i = 0; i < 4; ++i) {
-            std::complex<double> sign1 = signs[i][0];
-            std::complex<double> sign2 = signs[i][1];
+            double sign1 = signs[i][0];
+            double sign2 = signs[i][1];
             
             // Вычисляем выражение под корнем в числителе
             std::complex<double> inner_expr = sign1 * 2.0 * (zeta + 1.0) * inner_sqrt + 2.0 * zeta2 + zeta - 1.0;
@@ -221,9 +290,9 @@ QVector<ComplexSolution> CoordTransform::transformZetaToZ(const QPointF& zetaPoi
                 std::complex<double> numerator_sqrt = std::sqrt(inner_expr);
                 
                 // Вычисляем z_i согласно формуле (4.6)
-                std::complex<double> z_i = (sign1 * numerator_sqrt / std::sqrt(2.0))
-                                         + (sign2 * inner_sqrt / std::sqrt(2.0))
-                                         - (zeta / std::sqrt(2.0));
+                std::complex<double> z_i = (sign1 * numerator_sqrt * invSqrt2)
+                                         + (sign2 * inner_sqrt * invSqrt2)
+                                         - (zeta * invSqrt2);
                 
                 // Фильтруем валидные решения (не NaN и не бесконечность)
                 if (!std::isnan(z_i.real()) && !std::isnan(z_i.imag()) &&
@@ -233,22 +302,16 @@ QVector<ComplexSolution> CoordTransform::transformZetaToZ(const QPointF& zetaPoi
                     double real_part = std::max(-5.0, std::min(5.0, z_i.real()));
                     double imag_part = std::max(-5.0, std::min(5.0, z_i.imag()));
                     
-                    ComplexSolution solution;
-                    solution.point = QPointF(real_part, imag_part);
-                    solution.color = colors[i];
-                    solution.branch = i;
-                    solutions.append(solution);
+                    solutions[count++] = ComplexSolution(QPointF(real_part, imag_part), branchColor(i), i);
                 }
             }
         }
         
-        qDebug() << "Found" << solutions.size() << "solutions for ζ =" << zetaPoint.x() << "+ i" << zetaPoint.y();
-        
     } catch (const std::exception& e) {
         qWarning() << "Exception in transformZetaToZ:" << e.what();
     }
     
-    return solutions;
+    return count;
 }
 
 QPointF CoordTransform::transformZToZeta(const QPointF& zPoint)
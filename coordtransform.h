@@ -22,10 +22,19 @@ public:
     static QVector3D transformToSphere(const QList<QPointF>& points, const QList<double>& masses);
     static QVector<QPointF> transformFromSphere(const QVector3D& spherePoint, const QList<double>& masses, double scale = 300.0);
     static QVector3D getRawSphereCoordinates(const QList<QPointF>& points, const QList<double>& masses);
+    // Пакетный вариант в SoA-раскладке: positions[k][n] - координата k (x1, y1, ..., y3)
+    // треугольника n, в coordinates[0..2][n] пишутся сырые (ξ2, ξ3, ξ1).
+    // Массы проверяются один раз; в цикле нет ветвлений, и он векторизуется
+    static bool getRawSphereCoordinates(int count, const double* const positions[6], const QList<double>& masses,
+                                        double* const coordinates[3]);
 
     // Новые методы для преобразования ζ -> z с несколькими решениями
     static QVector<ComplexSolution> transformZetaToZ(const QPointF& zetaPoint);
+    // Вариант без выделения памяти: пишет до 4 решений в solutions, возвращает их число
+    static int transformZetaToZ(const QPointF& zetaPoint, ComplexSolution solutions[4]);
     static QPointF transformZToZeta(const QPointF& zPoint);
+    // Цвет ветви корня (0-3), общий для всех представлений
+    static QColor branchColor(int branch);
 };
 
 #endif // COORDTRANSFORM_H
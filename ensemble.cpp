@@ -0,0 +1,324 @@
+#include "ensemble.h"
+#include "coordtransform.h"
+#include "parallelfor.h"
+#include "threebodylanes.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QColor>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+EnsembleRunner::EnsembleRunner(QObject* parent)
+    : QThread(parent)
+{
+}
+
+EnsembleRunner::~EnsembleRunner()
+{
+    stop();
+}
+
+void EnsembleRunner::launch(const EnsembleOptions& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.options = options;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_busy = true;
+    m_condition.wakeOne();
+}
+
+void EnsembleRunner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void EnsembleRunner::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+bool EnsembleRunner::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_busy;
+}
+
+std::shared_ptr<const EnsembleResult> EnsembleRunner::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+void EnsembleRunner::clearResult()
+{
+    QMutexLocker locker(&m_mutex);
+    m_result.reset();
+}
+
+bool EnsembleRunner::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+QVector3D EnsembleRunner::gridPoint(int i, int j, int width, int height)
+{
+    // Те же оси, что у сферы в SphereWidget: y - полярная ось
+    const double theta = 2.0 * M_PI * (i + 0.5) / width;
+    const double y = 1.0 - 2.0 * (j + 0.5) / height;
+    const double rho = std::sqrt(qMax(0.0, 1.0 - y * y));
+    return QVector3D(rho * std::cos(theta), y, rho * std::sin(theta));
+}
+
+bool EnsembleRunner::initialPositions(const QVector3D& spherePoint, const QList<double>& masses, double x[6])
+{
+    QVector<QPointF> points = CoordTransform::transformFromSphere(spherePoint, masses);
+    if (points.size() != 3) return false;
+
+    // Центр масс в начале координат
+    const double total = masses[0] + masses[1] + masses[2];
+    double cx = 0.0, cy = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        cx += masses[i] * points[i].x() / total;
+        cy += masses[i] * points[i].y() / total;
+    }
+
+    // Масштаб с U = 1: из покоя это даёт E = -1
+    double u = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i + 1; j < 3; ++j) {
+            double r = QLineF(points[i], points[j]).length();
+            if (!(r > 0)) return false;
+            u += masses[i] * masses[j] / r;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        x[2 * i] = (points[i].x() - cx) * u;
+        x[2 * i + 1] = (points[i].y() - cy) * u;
+    }
+    return std::isfinite(u);
+}
+
+quint64 EnsembleRunner::integrateBatch(const EnsembleOptions& options, const double initial[][6], int count,
+                                       EnsembleOutcome* outcomes, quint64 generation) const
+{
+    ThreeBodyLanes<Lanes> lanes;
+    lanes.setMasses(options.masses);
+
+    double area[Lanes], collisionRadius[Lanes], escapeRadius[Lanes];
+    bool wasObtuse[Lanes] = {};
+
+    auto signedArea = [&](int l) {
+        const auto& x = lanes.x;
+        return (x[2][l] - x[0][l]) * (x[5][l] - x[1][l]) - (x[3][l] - x[1][l]) * (x[4][l] - x[0][l]);
+    };
+
+    for (int l = 0; l < Lanes; ++l) {
+        // Пустые дорожки повторяют первую, но стоят
+        lanes.load(l, initial[l < count ? l : 0], nullptr);
+        lanes.binding[l] = 1.0; // E0 = -1 при нулевых скоростях и U = 1
+        if (l >= count) lanes.active[l] = 0.0;
+        area[l] = signedArea(l);
+
+        double size = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            size = std::max(size, std::hypot(lanes.x[2 * j][l] - lanes.x[2 * i][l],
+                                             lanes.x[2 * j + 1][l] - lanes.x[2 * i + 1][l]));
+        }
+        collisionRadius[l] = options.collisionFactor * size;
+        escapeRadius[l] = options.escapeFactor * size;
+        if (l < count) outcomes[l].valid = true;
+    }
+
+    auto finish = [&](int l) {
+        lanes.active[l] = 0.0;
+        outcomes[l].endTime = float(lanes.t[l]);
+    };
+
+    const quint64 maxSteps = 100000000ull;
+    quint64 steps = 0;
+    int running = count;
+    while (running > 0 && steps < maxSteps) {
+        lanes.step(options.step);
+        ++steps;
+
+        for (int l = 0; l < count; ++l) {
+            if (lanes.active[l] == 0.0) continue;
+            EnsembleOutcome& outcome = outcomes[l];
+
+            const double r01 = lanes.r01[l], r02 = lanes.r02[l], r12 = lanes.r12[l];
+            if (outcome.collisionPair < 0 && std::min(r01, std::min(r02, r12)) < collisionRadius[l]) {
+                outcome.collisionPair = (r01 <= r02 && r01 <= r12) ? 0 : (r02 <= r12 ? 1 : 2);
+            }
+
+            const double a = signedArea(l);
+            if (a * area[l] < 0 && outcome.syzygies < 0xffff) ++outcome.syzygies;
+            if (a != 0) area[l] = a;
+
+            // Тупой угол: квадрат наибольшей стороны больше суммы квадратов двух других -
+            // та же граница, что MassSystem::rightAngle, но по уже посчитанным расстояниям
+            const double s01 = r01 * r01, s02 = r02 * r02, s12 = r12 * r12;
+            const bool obtuse = s01 > s02 + s12 || s02 > s01 + s12 || s12 > s01 + s02;
+            if (obtuse && !wasObtuse[l] && steps > 1 && outcome.obtuseEntries < 0xffff) ++outcome.obtuseEntries;
+            wasObtuse[l] = obtuse;
+
+            if (lanes.t[l] >= options.maxTime) {
+                finish(l);
+                --running;
+            } else if ((steps & 31) == 0) {
+                int body = lanes.escapingBody(l, escapeRadius[l]);
+                if (body >= 0) {
+                    outcome.escaper = qint8(body);
+                    outcome.escapeTime = float(lanes.t[l]);
+                    finish(l);
+                    --running;
+                }
+            }
+        }
+
+        if ((steps & 4095) == 0 && isCancelled(generation)) break;
+    }
+    return steps * count;
+}
+
+void EnsembleRunner::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_busy = false;
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const EnsembleOptions& options = request.options;
+        auto result = std::make_shared<EnsembleResult>();
+        result->options = options;
+
+        const int members = options.width * options.height;
+        result->outcomes.resize(members);
+        EnsembleOutcome* outcomes = result->outcomes.data();
+
+        const int batches = (members + Lanes - 1) / Lanes;
+        const int progressStep = qMax(1, batches / 100);
+        std::atomic<int> done{0};
+        std::atomic<quint64> steps{0};
+
+        try {
+            parallelFor(0, batches, [&](int batch) {
+                if (isCancelled(request.generation)) return;
+
+                // Начальные условия пачки; особые точки (столкновения) пропускаются
+                double initial[Lanes][6];
+                EnsembleOutcome* targets[Lanes];
+                int count = 0;
+                for (int k = batch * Lanes; k < qMin(members, (batch + 1) * Lanes); ++k) {
+                    QVector3D point = gridPoint(k % options.width, k / options.width,
+                                                options.width, options.height);
+                    if (!initialPositions(point, options.masses, initial[count])) continue;
+                    targets[count++] = outcomes + k;
+                }
+
+                if (count > 0) {
+                    EnsembleOutcome local[Lanes];
+                    steps.fetch_add(integrateBatch(options, initial, count, local, request.generation),
+                                    std::memory_order_relaxed);
+                    for (int l = 0; l < count; ++l) *targets[l] = local[l];
+                }
+
+                int finished = done.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (finished % progressStep == 0) {
+                    emit progress(finished * 100 / batches);
+                }
+            }, 1);
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in EnsembleRunner:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in EnsembleRunner";
+            continue;
+        }
+
+        result->steps = steps.load();
+        result->elapsedMs = timer.elapsed();
+        {
+            QMutexLocker locker(&m_mutex);
+            if (isCancelled(request.generation)) continue;
+            m_result = result;
+        }
+        emit ready(members, result->elapsedMs);
+    }
+}
+
+QImage EnsembleRunner::paint(const EnsembleResult& result, ColorMode mode)
+{
+    const int width = result.options.width;
+    const int height = result.options.height;
+    QImage image(width, height, QImage::Format_RGBA8888);
+    image.fill(QColor(40, 40, 40));
+
+    int maxSyzygies = 1;
+    int maxObtuseEntries = 1;
+    for (const EnsembleOutcome& outcome : result.outcomes) {
+        maxSyzygies = qMax(maxSyzygies, int(outcome.syzygies));
+        maxObtuseEntries = qMax(maxObtuseEntries, int(outcome.obtuseEntries));
+    }
+
+    static const QColor pairColors[3] = {
+        QColor(230, 60, 60),   // 1-2
+        QColor(60, 200, 60),   // 1-3
+        QColor(70, 110, 240)   // 2-3
+    };
+
+    const double logMax = std::log1p(result.options.maxTime);
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            const EnsembleOutcome& outcome = result.outcomes[j * width + i];
+            if (!outcome.valid) continue;
+
+            QColor color(90, 90, 90);
+            switch (mode) {
+            case EscapeTime:
+                // Ранний вылет - красный, поздний - синий; без вылета - серый
+                if (outcome.escapeTime >= 0) {
+                    double f = std::log1p(outcome.escapeTime) / logMax;
+                    color = QColor::fromHsvF(0.66 * qBound(0.0, f, 1.0), 0.85, 0.95);
+                }
+                break;
+            case CollisionPair:
+                if (outcome.collisionPair >= 0) color = pairColors[outcome.collisionPair];
+                break;
+            case Syzygies:
+                color = QColor::fromHsvF(0.75 * (1.0 - double(outcome.syzygies) / maxSyzygies), 0.8, 0.95);
+                break;
+            case ObtuseEntries:
+                color = QColor::fromHsvF(0.75 * (1.0 - double(outcome.obtuseEntries) / maxObtuseEntries), 0.8, 0.95);
+                break;
+            }
+            image.setPixelColor(i, j, color);
+        }
+    }
+    return image;
+}
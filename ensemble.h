@@ -0,0 +1,110 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <QVector3D>
+#include <QImage>
+#include <atomic>
+#include <memory>
+
+// Ансамбль начальных условий: по одному на ячейку равновеликой сетки на сфере форм.
+// Ячейка (i, j) - долгота θ = 2π(i + ½)/width и полоса y = 1 - 2(j + ½)/height
+// (цилиндрическая равновеликая проекция Ламберта), так что карта исходов сразу
+// является текстурой сферы. Каждая форма переводится в треугольник через
+// CoordTransform::transformFromSphere и отпускается из покоя (задача Агекяна-Аносовой)
+// в масштабе, где энергия E = -1.
+struct EnsembleOptions {
+    QList<double> masses = {1.0, 1.0, 1.0};
+    int width = 256;
+    int height = 128;
+    double maxTime = 50.0;
+    double step = 2e-3;             // шаг по фиктивному времени s (регуляризованная схема)
+    double collisionFactor = 1e-3;  // сближение ближе доли начального размера - "столкновение"
+    double escapeFactor = 10.0;     // вылет дальше стольких начальных размеров с E > 0
+};
+
+struct EnsembleOutcome {
+    float escapeTime = -1.0f;   // < 0 - тело не вылетело до maxTime
+    float endTime = 0.0f;
+    qint8 escaper = -1;         // номер вылетевшего тела
+    qint8 collisionPair = -1;   // первая тесная пара: 0 - (1,2), 1 - (1,3), 2 - (2,3)
+    quint16 syzygies = 0;       // прохождения через коллинеарность (экватор сферы)
+    quint16 obtuseEntries = 0;  // переходы через прямоугольные окружности в тупоугольную область
+    bool valid = false;
+};
+
+struct EnsembleResult {
+    EnsembleOptions options;
+    QVector<EnsembleOutcome> outcomes; // строка за строкой, width × height
+    quint64 steps = 0;
+    qint64 elapsedMs = 0;
+};
+
+// Фоновый расчёт ансамбля на всех ядрах. Члены ансамбля идут пачками по Lanes
+// (ThreeBodyLanes: SoA-массивы и регуляризованный шаг, общий для дорожек);
+// пачки раздаются потокам через parallelFor.
+class EnsembleRunner : public QThread
+{
+    Q_OBJECT
+public:
+    enum ColorMode {
+        EscapeTime,
+        CollisionPair,
+        Syzygies,
+        ObtuseEntries
+    };
+
+    static constexpr int Lanes = 8;
+
+    explicit EnsembleRunner(QObject* parent = nullptr);
+    ~EnsembleRunner();
+
+    // Отменяет идущий расчёт и запускает новый
+    void launch(const EnsembleOptions& options);
+    void cancel();
+    void stop();
+
+    bool isBusy() const;
+    std::shared_ptr<const EnsembleResult> result() const;
+    void clearResult();
+
+    // Центр ячейки сетки на единичной сфере
+    static QVector3D gridPoint(int i, int j, int width, int height);
+    // Начальные положения (x1, y1, ..., y3) для точки сферы; false на особых точках
+    static bool initialPositions(const QVector3D& spherePoint, const QList<double>& masses, double x[6]);
+    // Карта исходов в выбранной раскраске (width × height, строка 0 - северный полюс y = 1)
+    static QImage paint(const EnsembleResult& result, ColorMode mode);
+
+signals:
+    void progress(int percent);
+    void ready(int members, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        EnsembleOptions options;
+        quint64 generation = 0;
+    };
+
+    bool isCancelled(quint64 generation) const;
+    quint64 integrateBatch(const EnsembleOptions& options, const double initial[][6], int count,
+                           EnsembleOutcome* outcomes, quint64 generation) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_busy = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const EnsembleResult> m_result; // под m_mutex
+};
+
+#endif // ENSEMBLE_H
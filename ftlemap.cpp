@@ -0,0 +1,276 @@
+#include "ftlemap.h"
+#include "ensemble.h"
+#include "parallelfor.h"
+#include "threebodylanes.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QColor>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Детерминированное начальное направление касательного вектора для ячейки:
+// карта не зависит от числа потоков и порядка пачек
+void tangentDirection(int index, double direction[12])
+{
+    quint64 state = 0x9e3779b97f4a7c15ull * quint64(index + 1);
+    for (int k = 0; k < 12; ++k) {
+        // splitmix64
+        quint64 z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        direction[k] = 2.0 * double(z >> 11) / double(1ull << 53) - 1.0;
+    }
+}
+
+}
+
+FtleRunner::FtleRunner(QObject* parent)
+    : QThread(parent)
+{
+}
+
+FtleRunner::~FtleRunner()
+{
+    stop();
+}
+
+bool FtleRunner::sameRun(const FtleOptions& a, const FtleOptions& b)
+{
+    return a.masses == b.masses && a.width == b.width && a.height == b.height &&
+           a.horizon == b.horizon && a.step == b.step &&
+           a.renormalizeEvery == b.renormalizeEvery && a.escapeFactor == b.escapeFactor;
+}
+
+bool FtleRunner::launch(const FtleOptions& options)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_cache.size(); ++i) {
+        if (!sameRun(m_cache[i]->options, options)) continue;
+        m_generation.fetch_add(1); // идущий расчёт больше не нужен
+        m_hasPending = false;
+        m_result = m_cache[i];
+        m_cache.move(i, 0);
+        return true;
+    }
+
+    m_pending.options = options;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+    return false;
+}
+
+void FtleRunner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void FtleRunner::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+std::shared_ptr<const FtleResult> FtleRunner::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+void FtleRunner::clearResult()
+{
+    // Кэш остаётся: он привязан к массам, а не к текущей сцене
+    QMutexLocker locker(&m_mutex);
+    m_result.reset();
+}
+
+bool FtleRunner::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+quint64 FtleRunner::integrateBatch(const FtleOptions& options, const double initial[][6], const int index[],
+                                   int count, FtleCell* cells, quint64 generation) const
+{
+    ThreeBodyLanes<Lanes> lanes;
+    ThreeBodyTangent<Lanes> tangent;
+    lanes.setMasses(options.masses);
+
+    double escapeRadius[Lanes];
+    for (int l = 0; l < Lanes; ++l) {
+        // Пустые дорожки повторяют первую, но стоят
+        const int source = l < count ? l : 0;
+        lanes.load(l, initial[source], nullptr);
+        lanes.binding[l] = 1.0; // E0 = -1 при нулевых скоростях и U = 1
+        if (l >= count) lanes.active[l] = 0.0;
+
+        double direction[12];
+        tangentDirection(index[source], direction);
+        tangent.load(l, direction, lanes.m);
+
+        double size = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            size = std::max(size, std::hypot(lanes.x[2 * j][l] - lanes.x[2 * i][l],
+                                             lanes.x[2 * j + 1][l] - lanes.x[2 * i + 1][l]));
+        }
+        escapeRadius[l] = options.escapeFactor * size;
+    }
+
+    auto finish = [&](int l, bool escaped) {
+        lanes.active[l] = 0.0;
+        FtleCell& cell = cells[l];
+        cell.endTime = float(lanes.t[l]);
+        cell.escaped = escaped;
+        cell.exponent = lanes.t[l] > 0 ? float(tangent.logGrowth[l] / lanes.t[l]) : 0.0f;
+        cell.valid = std::isfinite(cell.exponent);
+    };
+
+    const int renormalizeEvery = qMax(1, options.renormalizeEvery);
+    const quint64 maxSteps = 100000000ull;
+    quint64 steps = 0;
+    int running = count;
+    while (running > 0 && steps < maxSteps) {
+        tangent.step(lanes, options.step);
+        ++steps;
+        if ((steps & 4095) == 0 && isCancelled(generation)) break;
+        if (steps % renormalizeEvery != 0) continue;
+
+        // Нормировка перед проверками: logGrowth должен быть полным к моменту finish
+        tangent.renormalize();
+        for (int l = 0; l < count; ++l) {
+            if (lanes.active[l] == 0.0) continue;
+            if (lanes.t[l] >= options.horizon) {
+                finish(l, false);
+                --running;
+            } else if (lanes.escapingBody(l, escapeRadius[l]) >= 0) {
+                finish(l, true);
+                --running;
+            }
+        }
+    }
+    return steps * count;
+}
+
+void FtleRunner::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const FtleOptions& options = request.options;
+        auto result = std::make_shared<FtleResult>();
+        result->options = options;
+
+        const int members = options.width * options.height;
+        result->cells.resize(members);
+        FtleCell* cells = result->cells.data();
+
+        const int batches = (members + Lanes - 1) / Lanes;
+        const int progressStep = qMax(1, batches / 100);
+        std::atomic<int> done{0};
+        std::atomic<quint64> steps{0};
+
+        try {
+            parallelFor(0, batches, [&](int batch) {
+                if (isCancelled(request.generation)) return;
+
+                double initial[Lanes][6];
+                int index[Lanes];
+                int count = 0;
+                for (int k = batch * Lanes; k < qMin(members, (batch + 1) * Lanes); ++k) {
+                    QVector3D point = EnsembleRunner::gridPoint(k % options.width, k / options.width,
+                                                                options.width, options.height);
+                    if (!EnsembleRunner::initialPositions(point, options.masses, initial[count])) continue;
+                    index[count++] = k;
+                }
+
+                if (count > 0) {
+                    FtleCell local[Lanes];
+                    steps.fetch_add(integrateBatch(options, initial, index, count, local, request.generation),
+                                    std::memory_order_relaxed);
+                    for (int l = 0; l < count; ++l) cells[index[l]] = local[l];
+                }
+
+                int finished = done.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (finished % progressStep == 0) {
+                    emit progress(finished * 100 / batches);
+                }
+            }, 1);
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in FtleRunner:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in FtleRunner";
+            continue;
+        }
+
+        result->steps = steps.load();
+        result->elapsedMs = timer.elapsed();
+        {
+            QMutexLocker locker(&m_mutex);
+            if (isCancelled(request.generation)) continue;
+            m_result = result;
+            m_cache.prepend(result);
+            while (m_cache.size() > CacheSize) m_cache.removeLast();
+        }
+        emit ready(members, result->elapsedMs);
+    }
+}
+
+QImage FtleRunner::paint(const FtleResult& result)
+{
+    const int width = result.options.width;
+    const int height = result.options.height;
+    QImage image(width, height, QImage::Format_RGBA8888);
+    image.fill(QColor(40, 40, 40));
+
+    // Шкала по 98-му процентилю: редкие тесные сближения не гасят остальную карту
+    QVector<float> exponents;
+    exponents.reserve(result.cells.size());
+    for (const FtleCell& cell : result.cells) {
+        if (cell.valid) exponents.append(cell.exponent);
+    }
+    if (exponents.isEmpty()) return image;
+
+    auto top = exponents.begin() + (exponents.size() - 1) * 98 / 100;
+    std::nth_element(exponents.begin(), top, exponents.end());
+    const double scale = *top > 0 ? 1.0 / *top : 1.0;
+
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            const FtleCell& cell = result.cells[j * width + i];
+            if (!cell.valid) continue;
+
+            const double f = qBound(0.0, cell.exponent * scale, 1.0);
+            image.setPixelColor(i, j, QColor::fromHsvF(0.66 * (1.0 - f), 0.85, cell.escaped ? 0.55 : 0.95));
+        }
+    }
+    return image;
+}
@@ -0,0 +1,98 @@
+#ifndef FTLEMAP_H
+#define FTLEMAP_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <QImage>
+#include <atomic>
+#include <memory>
+
+// Карта конечновременных показателей Ляпунова (FTLE) на сфере форм.
+// Сетка и начальные условия те же, что у ансамбля (EnsembleRunner::gridPoint,
+// initialPositions): форма отпускается из покоя при E = -1. Вдоль орбиты
+// интегрируются вариационные уравнения (ThreeBodyTangent), и
+// λ = ln(|δ(T)| / |δ(0)|) / T, где T - горизонт или момент вылета.
+struct FtleOptions {
+    QList<double> masses = {1.0, 1.0, 1.0};
+    int width = 128;
+    int height = 64;
+    double horizon = 20.0;          // горизонт интегрирования T
+    double step = 2e-3;             // шаг по фиктивному времени s
+    int renormalizeEvery = 8;       // шагов между нормировками касательного вектора
+    double escapeFactor = 10.0;     // вылет дальше стольких начальных размеров кончает орбиту
+};
+
+struct FtleCell {
+    float exponent = 0.0f;
+    float endTime = 0.0f;   // < horizon, если тело вылетело раньше
+    bool escaped = false;
+    bool valid = false;
+};
+
+struct FtleResult {
+    FtleOptions options;
+    QVector<FtleCell> cells; // строка за строкой, width × height
+    quint64 steps = 0;
+    qint64 elapsedMs = 0;
+};
+
+// Фоновый расчёт карты FTLE на всех ядрах, пачками по Lanes орбит.
+// Готовые карты кэшируются по тройке масс, горизонту и сетке: повторный
+// запуск с теми же параметрами (например, после смены масс туда и обратно)
+// отдаёт карту сразу, без расчёта.
+class FtleRunner : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int Lanes = 8;
+    static constexpr int CacheSize = 8;
+
+    explicit FtleRunner(QObject* parent = nullptr);
+    ~FtleRunner();
+
+    // Отменяет идущий расчёт и запускает новый. true - карта уже есть в кэше
+    // и доступна через result(), сигнал ready не придёт.
+    bool launch(const FtleOptions& options);
+    void cancel();
+    void stop();
+
+    std::shared_ptr<const FtleResult> result() const;
+    void clearResult();
+
+    // Текстура сферы: холодные цвета - регулярные орбиты, тёплые - хаотические;
+    // вылетевшие орбиты притемнены
+    static QImage paint(const FtleResult& result);
+
+signals:
+    void progress(int percent);
+    void ready(int members, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        FtleOptions options;
+        quint64 generation = 0;
+    };
+
+    static bool sameRun(const FtleOptions& a, const FtleOptions& b);
+    bool isCancelled(quint64 generation) const;
+    quint64 integrateBatch(const FtleOptions& options, const double initial[][6], const int index[],
+                           int count, FtleCell* cells, quint64 generation) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const FtleResult> m_result;              // под m_mutex
+    QList<std::shared_ptr<const FtleResult>> m_cache;        // под m_mutex, свежие в начале
+};
+
+#endif // FTLEMAP_H
@@ -0,0 +1,74 @@
+#include "functionfile.h"
+#include <QFile>
+#include <QTextStream>
+
+namespace FunctionFile {
+
+QStringList parse(QTextStream& in)
+{
+    QStringList functions;
+    static const char* names[6] = {"x1", "y1", "x2", "y2", "x3", "y3"};
+
+    // Читаем файл и ищем функции
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+
+        // Пропускаем пустые строки и комментарии
+        if (line.isEmpty() || line.startsWith("#") || line.startsWith("//")) {
+            continue;
+        }
+
+        // Пытаемся найти функции в формате: x1(t) = ... или просто x1 = ...
+        if (!line.contains("=")) continue;
+        for (const char* name : names) {
+            if (line.contains(name)) {
+                functions.append(extractFunction(line));
+                break;
+            }
+        }
+    }
+
+    return functions;
+}
+
+bool load(const QString& fileName, QStringList& functions, QString* error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = "Cannot open file: " + fileName;
+        return false;
+    }
+
+    QTextStream in(&file);
+    QStringList parsed = parse(in);
+    file.close();
+
+    if (parsed.size() < 6) {
+        if (error) {
+            *error = "Could not find all required functions in the file.\n"
+                     "Required functions: x1, y1, x2, y2, x3, y3";
+        }
+        return false;
+    }
+
+    functions = parsed.mid(0, 6);
+    return true;
+}
+
+QString extractFunction(const QString& line)
+{
+    // Извлекаем выражение после знака '='
+    int equalsPos = line.indexOf('=');
+    if (equalsPos == -1) return "";
+
+    QString expression = line.mid(equalsPos + 1).trimmed();
+
+    // Убираем возможные точки с запятой в конце
+    if (expression.endsWith(';')) {
+        expression.chop(1);
+    }
+
+    return expression.trimmed();
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef FUNCTIONFILE_H
+#define FUNCTIONFILE_H
+
+#include <QString>
+#include <QStringList>
+
+class QTextStream;
+
+// Разбор текстового файла с функциями положения:
+//   x1(t) = 50 + 20*cos(t)
+//   y1 = 50 + 20*sin(t);
+//   ...
+// Пустые строки и комментарии (# или //) пропускаются.
+// Используется и диалогом ввода функций, и пакетным режимом.
+namespace FunctionFile {
+
+// Функции в порядке появления в файле (ожидается x1, y1, x2, y2, x3, y3)
+QStringList parse(QTextStream& in);
+
+// false и текст ошибки, если файл не открылся или функций меньше шести
+bool load(const QString& fileName, QStringList& functions, QString* error = nullptr);
+
+// Выражение после знака '=' без завершающей ';'
+QString extractFunction(const QString& line);
+
+}
+
+#endif // FUNCTIONFILE_H
@@ -5,9 +5,8 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QFileDialog>
-#include <QFile>
-#include <QTextStream>
 #include <QMessageBox>
+#include "functionfile.h"
 
 FunctionInputDialog::FunctionInputDialog(QWidget *parent) : QDialog(parent)
 {
@@ -112,71 +111,13 @@ void FunctionInputDialog::importFromFile()
 
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Import Error",
-                             "Cannot open file: " + fileName);
-        return;
-    }
-
-    QTextStream in(&file);
     QStringList functions;
-
-    // Читаем файл и ищем функции
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-
-        // Пропускаем пустые строки и комментарии
-        if (line.isEmpty() || line.startsWith("#") || line.startsWith("//")) {
-            continue;
-        }
-
-        // Пытаемся найти функции в формате: x1(t) = ... или просто x1 = ...
-        if (line.contains("x1") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        } else if (line.contains("y1") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        } else if (line.contains("x2") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        } else if (line.contains("y2") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        } else if (line.contains("x3") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        } else if (line.contains("y3") && line.contains("=")) {
-            functions.append(extractFunction(line));
-        }
-    }
-
-    file.close();
-
-    if (functions.size() >= 6) {
-        x1Edit->setText(functions[0]);
-        y1Edit->setText(functions[1]);
-        x2Edit->setText(functions[2]);
-        y2Edit->setText(functions[3]);
-        x3Edit->setText(functions[4]);
-        y3Edit->setText(functions[5]);
+    QString error;
+    if (FunctionFile::load(fileName, functions, &error)) {
+        setFunctions(functions);
         QMessageBox::information(this, "Import Successful",
                                  "Functions imported successfully from: " + fileName);
     } else {
-        QMessageBox::warning(this, "Import Error",
-                             "Could not find all required functions in the file.\n"
-                             "Required functions: x1, y1, x2, y2, x3, y3");
-    }
-}
-
-QString FunctionInputDialog::extractFunction(const QString& line)
-{
-    // Извлекаем выражение после знака '='
-    int equalsPos = line.indexOf('=');
-    if (equalsPos == -1) return "";
-
-    QString expression = line.mid(equalsPos + 1).trimmed();
-
-    // Убираем возможные точки с запятой в конце
-    if (expression.endsWith(';')) {
-        expression.chop(1);
+        QMessageBox::warning(this, "Import Error", error);
     }
-
-    return expression.trimmed();
 }
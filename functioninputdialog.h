@@ -29,7 +29,6 @@ public:
     void setFunctions(const QStringList &functions);
 
 private:
-    QString extractFunction(const QString& line);
     QPushButton* importButton;
     QLineEdit *x1Edit, *y1Edit, *x2Edit, *y2Edit, *x3Edit, *y3Edit;
 };
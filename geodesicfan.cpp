@@ -0,0 +1,189 @@
+#include "geodesicfan.h"
+#include "masssystem.h"
+#include "parallelfor.h"
+#include "trajectoryspan.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+// L геодезических в SoA-раскладке: точка сферы x и единичная касательная t
+// в порядке SphereWidget (ξ2, ξ3, ξ1)
+template <int L>
+struct GeodesicLanes {
+    double c0[3], c1[3], c2[3];     // квадраты сторон c0 + c1·ξ1 + c2·ξ2
+    double w[3];                    // mᵢmⱼ тех же пар
+    double x[3][L];
+    double t[3][L];
+    double active[L];               // 1 - идёт, 0 - остановлена
+    double collided[L];             // остановлена у соударения
+
+    void setMasses(const MassSystem& system)
+    {
+        const double weight[3] = {system.m1 * system.m2, system.m1 * system.m3, system.m2 * system.m3};
+        for (int k = 0; k < 3; ++k) {
+            c0[k] = system.sideSquared[k].c0;
+            c1[k] = system.sideSquared[k].c1;
+            c2[k] = system.sideSquared[k].c2;
+            w[k] = weight[k];
+        }
+    }
+
+    void load(int l, const QVector3D& point, const QVector3D& direction)
+    {
+        x[0][l] = point.x(); x[1][l] = point.y(); x[2][l] = point.z();
+        t[0][l] = direction.x(); t[1][l] = direction.y(); t[2][l] = direction.z();
+        active[l] = 1.0;
+        collided[l] = 0.0;
+    }
+
+    // Поворот касательной на h·(∇φ)⊥: нормальная к кривой часть градиента φ = ½ ln Ũ.
+    // Тело цикла - прямолинейная арифметика по дорожке: три пары расписаны явно,
+    // остановка - выбор active[l] или 0 без перехода, из вызовов остаются fabs и sqrt,
+    // которые с -fno-math-errno встраиваются инструкциями (см. TS.pro)
+    void kick(double h)
+    {
+        for (int l = 0; l < L; ++l) {
+            const double px = x[0][l], py = x[1][l], pz = x[2][l];
+
+            // Квадраты сторон у соударения уходят в ноль и от округления
+            // бывают чуть отрицательны; |s| + 1e-300 вместо отсечки по max,
+            // которую GCC разворачивает в ветвление
+            const double s0 = std::fabs(c0[0] + c1[0] * pz + c2[0] * px) + 1e-300;
+            const double s1 = std::fabs(c0[1] + c1[1] * pz + c2[1] * px) + 1e-300;
+            const double s2 = std::fabs(c0[2] + c1[2] * pz + c2[2] * px) + 1e-300;
+            const double i0 = 1.0 / std::sqrt(s0);
+            const double i1 = 1.0 / std::sqrt(s1);
+            const double i2 = 1.0 / std::sqrt(s2);
+            const double u = w[0] * i0 + w[1] * i1 + w[2] * i2;
+            const double d0 = w[0] * i0 / s0, d1 = w[1] * i1 / s1, d2 = w[2] * i2 / s2;
+
+            // ∇φ = ∇Ũ/(2Ũ), ∂Ũ/∂s = -½ w s^(-3/2); Ũ не зависит от ξ3
+            const double scale = -0.25 / u;
+            double gx = scale * (d0 * c2[0] + d1 * c2[1] + d2 * c2[2]);
+            double gz = scale * (d0 * c1[0] + d1 * c1[1] + d2 * c1[2]);
+            double gy = 0.0;
+
+            // Касательная к сфере и нормальная к кривой часть
+            const double radial = gx * px + gz * pz;
+            gx -= radial * px; gy -= radial * py; gz -= radial * pz;
+            const double along = gx * t[0][l] + gy * t[1][l] + gz * t[2][l];
+            gx -= along * t[0][l]; gy -= along * t[1][l]; gz -= along * t[2][l];
+
+            // active - 0 или 1, так что остановка только у ещё идущей кривой
+            const double turn = h * std::sqrt(gx * gx + gy * gy + gz * gz);
+            const double stop = turn > GeodesicFan::MaxTurn ? active[l] : 0.0;
+            collided[l] += stop;
+            active[l] -= stop;
+
+            const double a = active[l] * h;
+            double tx = t[0][l] + a * gx, ty = t[1][l] + a * gy, tz = t[2][l] + a * gz;
+            const double normal = tx * px + ty * py + tz * pz;
+            tx -= normal * px; ty -= normal * py; tz -= normal * pz;
+            const double inverse = 1.0 / std::sqrt(tx * tx + ty * ty + tz * tz);
+            t[0][l] = tx * inverse; t[1][l] = ty * inverse; t[2][l] = tz * inverse;
+        }
+    }
+
+    // Точный сдвиг по большому кругу на длину h
+    void drift(double h)
+    {
+        const double c = std::cos(h), s = std::sin(h);
+        for (int l = 0; l < L; ++l) {
+            const double a = active[l];
+            double nx[3], nt[3];
+            for (int k = 0; k < 3; ++k) {
+                nx[k] = x[k][l] * c + t[k][l] * s;
+                nt[k] = t[k][l] * c - x[k][l] * s;
+            }
+            const double inverse = 1.0 / std::sqrt(nx[0] * nx[0] + nx[1] * nx[1] + nx[2] * nx[2]);
+            for (int k = 0; k < 3; ++k) {
+                x[k][l] += a * (nx[k] * inverse - x[k][l]);
+                t[k][l] += a * (nt[k] - t[k][l]);
+            }
+        }
+    }
+};
+
+}
+
+GeodesicFanResult GeodesicFan::compute(const GeodesicFanOptions& options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    GeodesicFanResult result;
+    const MassSystem system = MassSystem::fromMasses(options.masses);
+    if (!system.valid || options.directions <= 0 || !(options.step > 0) || !(options.length > 0)) {
+        return result;
+    }
+    if (!(options.start.length() > 0)) return result;
+    const QVector3D start = options.start.normalized();
+    if (!std::isfinite(system.shapePotential(start))) return result;
+
+    // Ортонормированный базис касательной плоскости в начальной точке
+    const QVector3D axis = std::abs(start.y()) < 0.9f ? QVector3D(0.0f, 1.0f, 0.0f) : QVector3D(1.0f, 0.0f, 0.0f);
+    const QVector3D e1 = QVector3D::crossProduct(axis, start).normalized();
+    const QVector3D e2 = QVector3D::crossProduct(start, e1);
+
+    const int directions = options.directions;
+    const int steps = std::max(1, static_cast<int>(std::ceil(options.length / options.step)));
+    const double h = options.length / steps;
+    const int batches = (directions + Lanes - 1) / Lanes;
+
+    QVector<QVector<QVector3D>> curves(directions);
+    std::atomic<int> collisions{0};
+
+    parallelFor(0, batches, [&](int batch) {
+        GeodesicLanes<Lanes> lanes;
+        lanes.setMasses(system);
+
+        // Лишние дорожки последней пачки повторяют её последнее направление
+        const int first = batch * Lanes;
+        const int count = std::min(Lanes, directions - first);
+        for (int l = 0; l < Lanes; ++l) {
+            const double angle = 2.0 * M_PI * (first + std::min(l, count - 1)) / directions;
+            lanes.load(l, start, std::cos(angle) * e1 + std::sin(angle) * e2);
+        }
+        for (int l = 0; l < count; ++l) {
+            curves[first + l].reserve(steps + 1);
+            curves[first + l].append(start);
+        }
+
+        // Чехарда с объединёнными полутолчками: kick(h/2) [drift(h) kick(h)]... kick(h/2)
+        lanes.kick(0.5 * h);
+        for (int step = 0; step < steps; ++step) {
+            lanes.drift(h);
+            lanes.kick(step + 1 < steps ? h : 0.5 * h);
+
+            bool any = false;
+            for (int l = 0; l < count; ++l) {
+                if (lanes.active[l] <= 0.0) continue;
+                curves[first + l].append(QVector3D(lanes.x[0][l], lanes.x[1][l], lanes.x[2][l]));
+                any = true;
+            }
+            if (!any) break;
+        }
+
+        int stopped = 0;
+        for (int l = 0; l < count; ++l) {
+            if (lanes.collided[l] > 0.0) ++stopped;
+        }
+        collisions.fetch_add(stopped, std::memory_order_relaxed);
+    }, 1);
+
+    int total = 0;
+    for (const QVector<QVector3D>& curve : curves) total += curve.size() + 1;
+    result.points.reserve(total);
+    for (const QVector<QVector3D>& curve : curves) {
+        if (curve.size() < 2) continue;
+        if (!result.points.isEmpty()) result.points.append(trajectoryBreakVertex());
+        result.points += curve;
+        ++result.curves;
+    }
+    result.collisions = collisions.load();
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
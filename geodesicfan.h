@@ -0,0 +1,42 @@
+#ifndef GEODESICFAN_H
+#define GEODESICFAN_H
+
+#include <QVector>
+#include <QList>
+#include <QVector3D>
+#include <cmath>
+
+struct GeodesicFanOptions {
+    QList<double> masses = {1.0, 1.0, 1.0};
+    QVector3D start;                // точка сферы (ξ2, ξ3, ξ1)
+    int directions = 64;            // направлений, равномерно по углу
+    double length = M_PI;           // длина каждой кривой по круглой метрике
+    double step = 0.01;
+};
+
+struct GeodesicFanResult {
+    QVector<QVector3D> points;      // кривые подряд, разделены trajectoryBreakVertex()
+    int curves = 0;
+    int collisions = 0;             // кривых, оборванных у точки соударения
+    qint64 elapsedMs = 0;
+};
+
+// Веер геодезических метрики Якоби-Мопертюи на сфере форм.
+// Размер замороженный (I = 1), и при E = 0 метрика конформна круглой:
+// g = Ũ·dσ², Ũ = U·√I. Геодезическая такой метрики с параметром - длиной
+// по круглой метрике - поворачивает с геодезической кривизной ∂φ/∂n,
+// φ = ½ ln Ũ, поэтому шаг - точный дрейф по большому кругу между
+// полутолчками касательной на ∇φ. Ũ и ∇Ũ считаются через квадраты сторон,
+// аффинные по ξ (MassSystem::sideSquared), по пачкам из Lanes направлений.
+// Кривая обрывается у соударения, когда один толчок повернул бы её больше
+// чем на MaxTurn радиан.
+class GeodesicFan
+{
+public:
+    static constexpr int Lanes = 8;
+    static constexpr double MaxTurn = 0.5;
+
+    static GeodesicFanResult compute(const GeodesicFanOptions& options);
+};
+
+#endif // GEODESICFAN_H
@@ -0,0 +1,79 @@
+#include "healpix.h"
+#include <algorithm>
+#include <cmath>
+
+Healpix::Healpix(int nside)
+    : m_nside(std::max(1, nside))
+{
+}
+
+Healpix::Ring Healpix::ring(int r) const
+{
+    const int n = m_nside;
+    const int index = r + 1;    // 1 .. 4n - 1 от северного полюса
+    Ring ring;
+    if (index < n || index > 3 * n) {
+        // Полярная шапка: k-е кольцо от ближайшего полюса, 4k пикселей со сдвигом на полшага
+        const int k = index < n ? index : 4 * n - index;
+        const double y = 1.0 - double(k) * k / (3.0 * n * n);
+        ring.count = 4 * k;
+        ring.first = index < n ? 2 * k * (k - 1) : pixelCount() - 2 * k * (k + 1);
+        ring.y = index < n ? y : -y;
+        ring.theta0 = M_PI / (4.0 * k);
+    } else {
+        // Пояс: 4n пикселей, сдвиг на полшага через кольцо
+        ring.count = 4 * n;
+        ring.first = 2 * n * (n - 1) + (index - n) * 4 * n;
+        ring.y = (2 * n - index) * 2.0 / (3.0 * n);
+        ring.theta0 = ((index + n) & 1) ? 0.0 : M_PI / (4.0 * n);
+    }
+    return ring;
+}
+
+int Healpix::pixelOf(const QVector3D& p) const
+{
+    return pixelOf(p.x(), p.y(), p.z());
+}
+
+int Healpix::pixelOf(double x, double y, double z) const
+{
+    const double length = std::sqrt(x * x + y * y + z * z);
+    if (!(length > 0) || !std::isfinite(length)) return -1;
+
+    const int n = m_nside;
+    const double height = y / length;
+    const double absolute = std::fabs(height);
+    double theta = std::atan2(z, x);
+    if (theta < 0) theta += 2.0 * M_PI;
+    double tt = theta / (0.5 * M_PI);   // четверть оборота, [0, 4)
+    if (!(tt < 4.0)) tt = 0.0;
+
+    if (absolute <= 2.0 / 3.0) {
+        // Пояс: номера восходящей и нисходящей граничных линий
+        const double t1 = n * (0.5 + tt);
+        const double t2 = n * height * 0.75;
+        const int jp = static_cast<int>(t1 - t2);
+        const int jm = static_cast<int>(t1 + t2);
+        const int ir = n + 1 + jp - jm;         // 1 .. 2n + 1 от y = 2/3
+        const int shift = 1 - (ir & 1);
+        const int ip = ((jp + jm - n + shift + 1 + 8 * n) / 2) % (4 * n);
+        return 2 * n * (n - 1) + (ir - 1) * 4 * n + ip;
+    }
+
+    // Шапка; 1 - |y| через x² + z², чтобы у полюса не терять разряды
+    const double tp = tt - std::floor(tt);
+    const double rest = (x * x + z * z) / (length * (length + std::fabs(y)));
+    const double scale = n * std::sqrt(3.0 * rest);
+    const int jp = static_cast<int>(tp * scale);
+    const int jm = static_cast<int>((1.0 - tp) * scale);
+    const int ir = std::min(jp + jm + 1, n);    // кольцо от ближайшего полюса
+    const int ip = std::min(static_cast<int>(tt * ir), 4 * ir - 1);
+    return height > 0 ? 2 * ir * (ir - 1) + ip : pixelCount() - 2 * ir * (ir + 1) + ip;
+}
+
+QVector3D Healpix::center(const Ring& ring, int i)
+{
+    const double theta = ring.theta0 + 2.0 * M_PI * i / ring.count;
+    const double s = std::sqrt(std::max(0.0, 1.0 - ring.y * ring.y));
+    return QVector3D(s * std::cos(theta), ring.y, s * std::sin(theta));
+}
@@ -0,0 +1,44 @@
+#ifndef HEALPIX_H
+#define HEALPIX_H
+
+#include <QVector3D>
+
+// Разбиение сферы HEALPix (Górski и др., 2005) в кольцевой нумерации:
+// 12·nside² пикселей одной площади на 4·nside - 1 кольцах постоянной широты.
+// Полярная ось - y, азимут θ = atan2(z, x) ∈ [0, 2π), как у равновеликой
+// сетки ансамбля и текстур SphereWidget. Кольца нумеруются с северного
+// полюса (y = 1), пиксели внутри кольца - по возрастанию θ.
+// В полярных шапках в кольце r (r < nside) 4r пикселей, в поясе |y| ≤ 2/3 -
+// по 4·nside; за счёт колец одинаковой широты гармонический анализ сводится
+// к БПФ вдоль колец, как на обычной сетке, но без сгущения у полюсов.
+class Healpix
+{
+public:
+    struct Ring {
+        int first = 0;      // номер первого пикселя
+        int count = 0;      // пикселей в кольце
+        double y = 0.0;     // широта кольца
+        double theta0 = 0.0; // азимут центра первого пикселя; шаг 2π/count
+    };
+
+    explicit Healpix(int nside);
+
+    int nside() const { return m_nside; }
+    int pixelCount() const { return 12 * m_nside * m_nside; }
+    int ringCount() const { return 4 * m_nside - 1; }
+
+    // Кольцо r = 0 .. ringCount() - 1
+    Ring ring(int r) const;
+
+    // Номер пикселя или -1 для нулевой или нечисловой точки
+    int pixelOf(const QVector3D& p) const;
+    int pixelOf(double x, double y, double z) const;
+
+    // Центр пикселя i кольца на единичной сфере
+    static QVector3D center(const Ring& ring, int i);
+
+private:
+    int m_nside;
+};
+
+#endif // HEALPIX_H
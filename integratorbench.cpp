@@ -0,0 +1,117 @@
+#include "integratorbench.h"
+#include "threebody.h"
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QString>
+#include <QList>
+#include <cmath>
+
+namespace IntegratorBench {
+
+namespace {
+
+struct Problem {
+    const char* name;
+    QList<double> masses;
+    ThreeBodySystem::State initial;
+};
+
+struct Setup {
+    ThreeBodySystem::Integrator integrator;
+    double step;
+};
+
+// Задача Бурау (пифагорова): массы 3, 4, 5 в покое в вершинах треугольника 3-4-5;
+// несколько очень тесных двойных сближений до t ≈ 20
+Problem pythagorean()
+{
+    Problem problem{"Pythagorean", {3.0, 4.0, 5.0}, {}};
+    const double x[6] = {1.0, 3.0, -2.0, -1.0, 1.0, -1.0};
+    std::copy(x, x + 6, problem.initial.x);
+    return problem;
+}
+
+// Двойная с эксцентриситетом 0.999 (перицентр 0.002) и далёкое лёгкое третье тело
+Problem eccentricBinary()
+{
+    Problem problem{"Eccentric binary", {1.0, 1.0, 0.1}, {}};
+    ThreeBodySystem::State& s = problem.initial;
+    const double e = 0.999;
+    const double apocenter = 1.0 + e;                     // a = 1
+    const double v = std::sqrt(2.0 * (1.0 - e) / apocenter); // относительная скорость в апоцентре
+    s.x[0] = -0.5 * apocenter; s.v[1] = -0.5 * v;
+    s.x[2] = 0.5 * apocenter;  s.v[3] = 0.5 * v;
+    s.x[5] = 10.0;             s.v[4] = -std::sqrt(2.1 / 10.0);
+
+    // Центр масс в начале координат, суммарный импульс нулевой
+    const double total = 2.1;
+    double cy = 0.1 * s.x[5] / total, vx = 0.1 * s.v[4] / total;
+    for (int i = 0; i < 3; ++i) {
+        s.x[2 * i + 1] -= cy;
+        s.v[2 * i] -= vx;
+    }
+    return problem;
+}
+
+}
+
+int run(QTextStream& out, double tEnd)
+{
+    const QList<Problem> problems = {pythagorean(), eccentricBinary()};
+    const QList<Setup> setups = {
+        {ThreeBodySystem::Leapfrog, 1e-4},
+        {ThreeBodySystem::Yoshida4, 1e-4},
+        {ThreeBodySystem::DormandPrince5, 1e-3},
+        {ThreeBodySystem::LogH4, 1e-2},
+    };
+    const qint64 wallLimitMs = 30000; // на один прогон
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+               .arg("problem", -18).arg("integrator", -22).arg("steps", 12).arg("forces", 12)
+               .arg("ms", 8).arg("Msteps/s", 9).arg("t reached", 10).arg("|dE/E|", 10)
+               .arg("min r", 10).arg("min dt", 10);
+
+    for (const Problem& problem : problems) {
+        for (const Setup& setup : setups) {
+            ThreeBodySystem system(problem.masses, problem.initial, setup.integrator, setup.step);
+            const double energy0 = system.energy();
+            double minimum = ThreeBodySystem::minimumSeparation(system.state());
+            double minimumStep = setup.step;
+            quint64 steps = 0;
+
+            QElapsedTimer timer;
+            timer.start();
+            bool timedOut = false;
+            while (system.state().t < tEnd) {
+                if (!system.advance()) break;
+                ++steps;
+                minimum = std::min(minimum, ThreeBodySystem::minimumSeparation(system.state()));
+                minimumStep = std::min(minimumStep, system.lastStep());
+                if ((steps & 0xffff) == 0 && timer.elapsed() > wallLimitMs) {
+                    timedOut = true;
+                    break;
+                }
+            }
+            const qint64 ns = qMax<qint64>(1, timer.nsecsElapsed());
+
+            const double error = std::abs((system.energy() - energy0) / energy0);
+            QString status = system.failed() ? " (failed)" : (timedOut ? " (time limit)" : "");
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10%11\n")
+                       .arg(problem.name, -18)
+                       .arg(ThreeBodySystem::integratorName(setup.integrator), -22)
+                       .arg(steps, 12)
+                       .arg(system.forceEvaluations(), 12)
+                       .arg(ns / 1000000, 8)
+                       .arg(steps * 1e3 / ns, 9, 'f', 2)
+                       .arg(system.state().t, 10, 'f', 3)
+                       .arg(error, 10, 'e', 2)
+                       .arg(minimum, 10, 'e', 2)
+                       .arg(minimumStep, 10, 'e', 2)
+                       .arg(status);
+            out.flush();
+        }
+    }
+    return 0;
+}
+
+}
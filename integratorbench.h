@@ -0,0 +1,16 @@
+#ifndef INTEGRATORBENCH_H
+#define INTEGRATORBENCH_H
+
+class QTextStream;
+
+// Сравнение интеграторов задачи трёх тел на орбитах с тесными сближениями
+// (пакетный режим, --bench-integrators): шаги, вычисления сил, время,
+// достигнутое t, ошибка энергии и наименьшее расстояние между телами.
+namespace IntegratorBench {
+
+// Возвращает код завершения процесса
+int run(QTextStream& out, double tEnd);
+
+}
+
+#endif // INTEGRATORBENCH_H
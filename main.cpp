@@ -1,5 +1,9 @@
 #include "mainwindow.h"
+#include "batchexport.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QStringList>
+#include <cstring>
 #include <QDebug>
 #include <csignal>
 #include <cstdlib>
@@ -11,7 +15,27 @@ void signalHandler(int signal)
     std::exit(signal);
 }
 
+static bool isBatchMode(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) return true;
+    }
+    return false;
+}
+
 int main(int argc, char* argv[]) {
+    // Пакетный режим: без окна и без графической подсистемы
+    if (isBatchMode(argc, argv)) {
+        try {
+            QCoreApplication app(argc, argv);
+            return BatchExport::runFromCommandLine(app.arguments());
+        }
+        catch (const std::exception& e) {
+            qCritical() << "Exception caught in batch mode: " << e.what();
+            return 1;
+        }
+    }
+
     // Устанавливаем атрибуты ДО создания QApplication
     QCoreApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
@@ -9,120 +9,28 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QDoubleValidator>
+#include <QIntValidator>
 #include <QFrame>
 #include <QGroupBox>
 #include <QCheckBox>
+#include <QStatusBar>
+#include <QSignalBlocker>
+#include <QFileDialog>
+#include <QElapsedTimer>
 #include <cmath>
 #include <QRegularExpression>
 #include "coordtransform.h"
 #include "functioninputdialog.h"
-
-// Простой математический парсер
-namespace MathParser {
-double parseExpression(const QString& expr);
-double evaluateExpression(const QString& expr);
-
-double evaluate(const QString& expression, double t) {
-    if (expression.isEmpty()) return 0.0;
-
-    QString expr = expression;
-    expr = expr.replace("t", QString::number(t, 'f', 6));
-    expr = expr.replace("pi", "3.14159265358979323846");
-    expr = expr.replace("e", "2.71828182845904523536");
-
-    // Добавляем поддержку математических констант из ваших уравнений
-    expr = expr.replace("0.8660254", "0.8660254037844386"); // sqrt(3)/2
-
-    // Упрощённая замена функций
-    expr = expr.replace("sin", "s");
-    expr = expr.replace("cos", "c");
-    expr = expr.replace("tan", "t");
-    expr = expr.replace("exp", "e");
-    expr = expr.replace("log", "l");
-    expr = expr.replace("sqrt", "q");
-
-    // Удаляем пробелы
-    expr = expr.remove(" ");
-
-    return evaluateExpression(expr);
-}
-
-double evaluateExpression(const QString& expr) {
-    try {
-        return parseExpression(expr);
-    } catch (const std::exception&) {
-        return 0.0;
-    }
-}
-
-double parseExpression(const QString& expr) {
-    int len = expr.length();
-    if (len == 0) return 0.0;
-
-    // Обработка скобок
-    if (expr[0] == '(' && expr[len-1] == ')') {
-        return parseExpression(expr.mid(1, len-2));
-    }
-
-    // Поиск операторов с низким приоритетом (+, -)
-    int parenCount = 0;
-    for (int i = len-1; i >= 0; --i) {
-        QChar c = expr[i];
-        if (c == ')') parenCount++;
-        else if (c == '(') parenCount--;
-
-        if (parenCount == 0 && (c == '+' || c == '-') && i > 0) {
-            double left = parseExpression(expr.left(i));
-            double right = parseExpression(expr.mid(i+1));
-            return (c == '+') ? left + right : left - right;
-        }
-    }
-
-    // Поиск операторов (*, /)
-    parenCount = 0;
-    for (int i = len-1; i >= 0; --i) {
-        QChar c = expr[i];
-        if (c == ')') parenCount++;
-        else if (c == '(') parenCount--;
-
-        if (parenCount == 0 && (c == '*' || c == '/') && i > 0) {
-            double left = parseExpression(expr.left(i));
-            double right = parseExpression(expr.mid(i+1));
-            if (c == '/' && right == 0.0) return 0.0; // Защита от деления на ноль
-            return (c == '*') ? left * right : left / right;
-        }
-    }
-
-    // Обработка функций
-    if (expr.length() > 1 && (expr[0] == 's' || expr[0] == 'c' || expr[0] == 't' ||
-                              expr[0] == 'e' || expr[0] == 'l' || expr[0] == 'q')) {
-        double arg = parseExpression(expr.mid(1));
-        switch (expr[0].toLatin1()) {
-        case 's': return std::sin(arg); // sin
-        case 'c': return std::cos(arg); // cos
-        case 't': return std::tan(arg); // tan
-        case 'e': return std::exp(arg); // exp
-        case 'l': return std::log(arg); // log
-        case 'q': return std::sqrt(arg); // sqrt
-        }
-    }
-
-    // Числа
-    bool ok;
-    double result = expr.toDouble(&ok);
-    if (ok) return result;
-
-    return 0.0;
-}
-}
+#include "tabulatedsource.h"
+#include "parallelfor.h"
 
 MainWindow::MainWindow() :
     blockSceneUpdates(false),
     lastSpherePoint(0, 0, 0),
     isAnimationMode(false),
     currentTime(0.0),
-    timeStep(0.1),
-    maxTime(10.0)
+    maxTime(20.0),
+    speedFactor(1.0)
 {
     qDebug() << "MainWindow constructor started";
 
@@ -188,7 +96,7 @@ MainWindow::MainWindow() :
         triangleLayout->addWidget(animationModeContainer);
 
         // Создаем graphics view и scene для треугольника
-        view = new QGraphicsView;
+        view = new AcceleratedGraphicsView;
         scene = new TriangleScene(this);
 
         qDebug() << "Scene and view created";
@@ -309,18 +217,45 @@ MainWindow::MainWindow() :
         animationToggleButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
         animationToggleButton->setEnabled(false);
 
+        loadTableButton = new QPushButton("Load Table");
+        loadTableButton->setFixedHeight(35);
+        loadTableButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        loadTableButton->setToolTip("Загрузить положения из таблицы t, x1, y1, ..., y3 (CSV или бинарный вывод пакетного режима)");
+        loadTableButton->setEnabled(false);
+
         animationResetButton = new QPushButton("Reset");
         animationResetButton->setFixedHeight(35);
         animationResetButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
         animationResetButton->setEnabled(false);
 
+        loadTimelineButton = new QPushButton("Full Trail");
+        loadTimelineButton->setFixedHeight(35);
+        loadTimelineButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        loadTimelineButton->setToolTip("Показать траекторию за весь интервал из предвычисленной шкалы");
+        loadTimelineButton->setEnabled(false);
+
+        recordButton = new QPushButton("Record");
+        recordButton->setFixedHeight(35);
+        recordButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; } QPushButton:checked { background-color: #f0b0b0; }");
+        recordButton->setToolTip("Записывать все выборки анимации в файл");
+        recordButton->setCheckable(true);
+
+        openRecordingButton = new QPushButton("Open Recording");
+        openRecordingButton->setFixedHeight(35);
+        openRecordingButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        openRecordingButton->setToolTip("Открыть запись и перематывать её слайдером");
+
         QPushButton* stopDrawingButton = new QPushButton("Stop Drawing");
         stopDrawingButton->setFixedHeight(35);
         stopDrawingButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
 
         animationButtonLayout->addWidget(animationModeButton);
+        animationButtonLayout->addWidget(loadTableButton);
         animationButtonLayout->addWidget(animationToggleButton);
         animationButtonLayout->addWidget(animationResetButton);
+        animationButtonLayout->addWidget(loadTimelineButton);
+        animationButtonLayout->addWidget(recordButton);
+        animationButtonLayout->addWidget(openRecordingButton);
         animationButtonLayout->addWidget(stopDrawingButton);
         animationButtonLayout->addStretch();
 
@@ -345,24 +280,143 @@ MainWindow::MainWindow() :
         speedEdit->setMaximumWidth(60);
         speedEdit->setEnabled(true);
 
+        QLabel* sampleRateLabel = new QLabel("Samples/s:");
+        sampleRateEdit = new QLineEdit("100");
+        QDoubleValidator* sampleRateValidator = new QDoubleValidator(1.0, 2000.0, 1, this);
+        sampleRateValidator->setLocale(QLocale::C);
+        sampleRateEdit->setValidator(sampleRateValidator);
+        sampleRateEdit->setMaximumWidth(60);
+        sampleRateEdit->setToolTip("Частота выборки потока симуляции (не зависит от частоты кадров)");
+
+        QLabel* timelineLabel = new QLabel("Timeline:");
+        timelineResolutionEdit = new QLineEdit(QString::number(timelineResolution));
+        timelineResolutionEdit->setValidator(new QIntValidator(100, 1000000, this));
+        timelineResolutionEdit->setMaximumWidth(70);
+        timelineResolutionEdit->setToolTip("Число предвычисленных выборок для перемотки слайдером");
+
         showTrajectoryCheckbox = new QCheckBox("Show Trajectory");
         showTrajectoryCheckbox->setEnabled(true);
 
+        threadedPlanesCheckbox = new QCheckBox("Background Plane Rendering");
+        threadedPlanesCheckbox->setToolTip("Рисовать комплексные плоскости в отдельном потоке");
+        threadedPlanesCheckbox->setChecked(false);
+
+        openGLViewportsCheckbox = new QCheckBox("OpenGL Viewports");
+        openGLViewportsCheckbox->setToolTip("Рисовать треугольник и плоскости через QOpenGLWidget");
+        openGLViewportsCheckbox->setChecked(false);
+
         animationParamsLayout->addWidget(maxTimeLabel);
         animationParamsLayout->addWidget(maxTimeEdit);
         animationParamsLayout->addWidget(speedLabel);
         animationParamsLayout->addWidget(speedEdit);
+        animationParamsLayout->addWidget(sampleRateLabel);
+        animationParamsLayout->addWidget(sampleRateEdit);
+        animationParamsLayout->addWidget(timelineLabel);
+        animationParamsLayout->addWidget(timelineResolutionEdit);
         animationParamsLayout->addWidget(showTrajectoryCheckbox);
+        animationParamsLayout->addWidget(threadedPlanesCheckbox);
+        animationParamsLayout->addWidget(openGLViewportsCheckbox);
         animationParamsLayout->addStretch();
 
         animationFrameLayout->addLayout(animationParamsLayout);
 
+        // Динамика: численное решение задачи трёх тел вместо заданных функций
+        QHBoxLayout* dynamicsLayout = new QHBoxLayout;
+
+        threeBodyPresetCombo = new QComboBox;
+        threeBodyPresetCombo->addItem("Figure-eight");
+        threeBodyPresetCombo->addItem("Rotating triangle");
+        threeBodyPresetCombo->addItem("Triangle at rest");
+        threeBodyPresetCombo->setToolTip("Начальные условия; треугольник берётся из сцены вместе с массами");
+
+        integratorCombo = new QComboBox;
+        integratorCombo->addItem(ThreeBodySystem::integratorName(ThreeBodySystem::Yoshida4), ThreeBodySystem::Yoshida4);
+        integratorCombo->addItem(ThreeBodySystem::integratorName(ThreeBodySystem::Leapfrog), ThreeBodySystem::Leapfrog);
+        integratorCombo->addItem(ThreeBodySystem::integratorName(ThreeBodySystem::DormandPrince5), ThreeBodySystem::DormandPrince5);
+        integratorCombo->addItem(ThreeBodySystem::integratorName(ThreeBodySystem::LogH4), ThreeBodySystem::LogH4);
+        integratorCombo->setToolTip("Регуляризованная схема проходит тесные сближения без дробления шага по s");
+
+        integratorStepEdit = new QLineEdit("0.001");
+        QDoubleValidator* stepValidator = new QDoubleValidator(1e-7, 0.1, 7, this);
+        stepValidator->setLocale(QLocale::C);
+        integratorStepEdit->setValidator(stepValidator);
+        integratorStepEdit->setMaximumWidth(70);
+        integratorStepEdit->setToolTip("Шаг симплектических схем; начальный шаг адаптивной; шаг по s регуляризованной (≈0.01)");
+
+        threeBodyButton = new QPushButton("Integrate");
+        threeBodyButton->setFixedHeight(35);
+        threeBodyButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        threeBodyButton->setToolTip("Двигать треугольник по решению ньютоновской задачи трёх тел");
+        threeBodyButton->setEnabled(false);
+
+        dynamicsLayout->addWidget(new QLabel("Three-body:"));
+        dynamicsLayout->addWidget(threeBodyPresetCombo);
+        dynamicsLayout->addWidget(integratorCombo);
+        dynamicsLayout->addWidget(new QLabel("Step:"));
+        dynamicsLayout->addWidget(integratorStepEdit);
+        dynamicsLayout->addWidget(threeBodyButton);
+        dynamicsLayout->addStretch();
+
+        animationFrameLayout->addLayout(dynamicsLayout);
+
+        // Периодические орбиты: стрельба от затравки и продолжение по m3
+        QHBoxLayout* orbitLayout = new QHBoxLayout;
+
+        orbitSeedCombo = new QComboBox;
+        orbitSeedCombo->addItem("Figure-eight seed");
+        orbitSeedCombo->addItem("Current animation");
+        orbitSeedCombo->setToolTip("Затравка: восьмёрка или состояние текущей анимации в момент слайдера "
+                                   "(формулы, таблица, интегратор), растянутое до 2K = U");
+
+        orbitPeriodEdit = new QLineEdit(QString::number(ThreeBodySystem::figureEightPeriod({1.0, 1.0, 1.0}), 'f', 4));
+        QDoubleValidator* periodValidator = new QDoubleValidator(1e-3, 1e4, 6, this);
+        periodValidator->setLocale(QLocale::C);
+        orbitPeriodEdit->setValidator(periodValidator);
+        orbitPeriodEdit->setMaximumWidth(70);
+        orbitPeriodEdit->setToolTip("Начальное приближение периода");
+
+        orbitMassEdit = new QLineEdit;
+        QDoubleValidator* orbitMassValidator = new QDoubleValidator(0.001, 1000.0, 4, this);
+        orbitMassValidator->setLocale(QLocale::C);
+        orbitMassEdit->setValidator(orbitMassValidator);
+        orbitMassEdit->setMaximumWidth(60);
+        orbitMassEdit->setPlaceholderText("none");
+        orbitMassEdit->setToolTip("Продолжить семейство орбит до этой m3 (m1 и m2 не меняются)");
+
+        orbitButton = new QPushButton("Find Orbit");
+        orbitButton->setFixedHeight(35);
+        orbitButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        orbitButton->setToolTip("Довести затравку до периодической орбиты и анимировать её");
+        orbitButton->setEnabled(false);
+
+        saveOrbitButton = new QPushButton("Save Orbit...");
+        saveOrbitButton->setFixedHeight(35);
+        saveOrbitButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        saveOrbitButton->setToolTip("Таблица одного периода; открывается через Load Table");
+        saveOrbitButton->setEnabled(false);
+
+        orbitStatusLabel = new QLabel;
+        orbitStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        orbitLayout->addWidget(new QLabel("Periodic orbit:"));
+        orbitLayout->addWidget(orbitSeedCombo);
+        orbitLayout->addWidget(new QLabel("T:"));
+        orbitLayout->addWidget(orbitPeriodEdit);
+        orbitLayout->addWidget(new QLabel("to m3:"));
+        orbitLayout->addWidget(orbitMassEdit);
+        orbitLayout->addWidget(orbitButton);
+        orbitLayout->addWidget(saveOrbitButton);
+        orbitLayout->addWidget(orbitStatusLabel);
+        orbitLayout->addStretch();
+
+        animationFrameLayout->addLayout(orbitLayout);
+
         // Слайдер времени
         QHBoxLayout* timeLayout = new QHBoxLayout;
         timeLayout->addWidget(new QLabel("Time:"));
 
         timeSlider = new QSlider(Qt::Horizontal);
-        timeSlider->setRange(0, 100);
+        timeSlider->setRange(0, SliderResolution);
         timeSlider->setValue(0);
         timeSlider->setEnabled(false);
         timeLayout->addWidget(timeSlider);
@@ -411,6 +465,270 @@ MainWindow::MainWindow() :
         sphereWidget->setMinimumSize(400, 300);
         sphereLayout->addWidget(sphereWidget);
 
+        // Ансамбль: исходы свободного падения для каждой формы, раскрашенные на сфере
+        QFrame* ensembleFrame = new QFrame;
+        ensembleFrame->setFrameStyle(QFrame::Box);
+        ensembleFrame->setLineWidth(1);
+        QVBoxLayout* ensembleFrameLayout = new QVBoxLayout(ensembleFrame);
+
+        QLabel* ensembleTitle = new QLabel("Ensemble");
+        ensembleTitle->setStyleSheet("QLabel { font-weight: bold; }");
+        ensembleFrameLayout->addWidget(ensembleTitle);
+
+        QHBoxLayout* ensembleLayout = new QHBoxLayout;
+
+        ensembleModeCombo = new QComboBox;
+        ensembleModeCombo->addItem("Escape time", EnsembleRunner::EscapeTime);
+        ensembleModeCombo->addItem("Collision pair", EnsembleRunner::CollisionPair);
+        ensembleModeCombo->addItem("Syzygies", EnsembleRunner::Syzygies);
+        ensembleModeCombo->addItem("Obtuse entries", EnsembleRunner::ObtuseEntries);
+        ensembleModeCombo->setToolTip("Раскраска карты; смена не пересчитывает ансамбль");
+
+        ensembleResolutionEdit = new QLineEdit("128");
+        ensembleResolutionEdit->setValidator(new QIntValidator(8, 2048, this));
+        ensembleResolutionEdit->setMaximumWidth(60);
+        ensembleResolutionEdit->setToolTip("Число ячеек по долготе; по высоте вдвое меньше");
+
+        ensembleTimeEdit = new QLineEdit("50");
+        QDoubleValidator* ensembleTimeValidator = new QDoubleValidator(0.1, 10000.0, 2, this);
+        ensembleTimeValidator->setLocale(QLocale::C);
+        ensembleTimeEdit->setValidator(ensembleTimeValidator);
+        ensembleTimeEdit->setMaximumWidth(60);
+        ensembleTimeEdit->setToolTip("Предельное время интегрирования (E = -1)");
+
+        ensembleButton = new QPushButton("Run Ensemble");
+        ensembleButton->setFixedHeight(35);
+        ensembleButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        ensembleButton->setToolTip("Отпустить из покоя все формы сетки и отметить, кто и когда вылетел");
+
+        clearEnsembleButton = new QPushButton("Clear Map");
+        clearEnsembleButton->setFixedHeight(35);
+        clearEnsembleButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+
+        ensembleStatusLabel = new QLabel;
+        ensembleStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        ensembleLayout->addWidget(ensembleModeCombo);
+        ensembleLayout->addWidget(new QLabel("Cells:"));
+        ensembleLayout->addWidget(ensembleResolutionEdit);
+        ensembleLayout->addWidget(new QLabel("t max:"));
+        ensembleLayout->addWidget(ensembleTimeEdit);
+        ensembleLayout->addWidget(ensembleButton);
+        ensembleLayout->addWidget(clearEnsembleButton);
+        ensembleLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(ensembleLayout);
+        ensembleFrameLayout->addWidget(ensembleStatusLabel);
+
+        // Показатели Ляпунова: та же сетка, горизонт задаётся отдельно
+        QHBoxLayout* ftleLayout = new QHBoxLayout;
+
+        ftleHorizonEdit = new QLineEdit("20");
+        QDoubleValidator* ftleHorizonValidator = new QDoubleValidator(0.1, 10000.0, 2, this);
+        ftleHorizonValidator->setLocale(QLocale::C);
+        ftleHorizonEdit->setValidator(ftleHorizonValidator);
+        ftleHorizonEdit->setMaximumWidth(60);
+        ftleHorizonEdit->setToolTip("Горизонт T для λ = ln(|δ(T)|/|δ(0)|)/T");
+
+        ftleButton = new QPushButton("Run FTLE");
+        ftleButton->setFixedHeight(35);
+        ftleButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        ftleButton->setToolTip("Карта показателей Ляпунова; посчитанные карты запоминаются для каждой тройки масс");
+
+        ftleStatusLabel = new QLabel;
+        ftleStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        ftleLayout->addWidget(new QLabel("FTLE horizon:"));
+        ftleLayout->addWidget(ftleHorizonEdit);
+        ftleLayout->addWidget(ftleButton);
+        ftleLayout->addWidget(ftleStatusLabel);
+        ftleLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(ftleLayout);
+
+        // Сечение Пуанкаре по большому кругу при заданных E и L
+        QHBoxLayout* sectionLayout = new QHBoxLayout;
+
+        sectionCombo = new QComboBox;
+        sectionCombo->addItem("Section: equator", QVector3D(0.0f, 1.0f, 0.0f));
+        sectionCombo->addItem("Section: ξ₂ = 0", QVector3D(1.0f, 0.0f, 0.0f));
+        sectionCombo->addItem("Section: ξ₁ = 0", QVector3D(0.0f, 0.0f, 1.0f));
+        sectionCombo->setToolTip("Большой круг на сфере форм; точки берутся при пересечении в одну сторону");
+
+        QDoubleValidator* sectionValidator = new QDoubleValidator(-1000.0, 1000.0, 4, this);
+        sectionValidator->setLocale(QLocale::C);
+        sectionEnergyEdit = new QLineEdit("-1");
+        sectionEnergyEdit->setValidator(sectionValidator);
+        sectionEnergyEdit->setMaximumWidth(50);
+        sectionEnergyEdit->setToolTip("Энергия (только E < 0)");
+        sectionMomentumEdit = new QLineEdit("0.5");
+        sectionMomentumEdit->setValidator(sectionValidator);
+        sectionMomentumEdit->setMaximumWidth(50);
+        sectionMomentumEdit->setToolTip("Момент импульса");
+        sectionPointsEdit = new QLineEdit("1000000");
+        sectionPointsEdit->setValidator(new QIntValidator(1000, 100000000, this));
+        sectionPointsEdit->setMaximumWidth(80);
+
+        sectionButton = new QPushButton("Run Section");
+        sectionButton->setFixedHeight(35);
+        sectionButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+        sectionButton->setToolTip("Точки (ψ/π, v∥) появляются в исходной плоскости по мере расчёта");
+
+        clearSectionButton = new QPushButton("Clear Section");
+        clearSectionButton->setFixedHeight(35);
+        clearSectionButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+
+        sectionStatusLabel = new QLabel;
+        sectionStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        sectionLayout->addWidget(sectionCombo);
+        sectionLayout->addWidget(new QLabel("E:"));
+        sectionLayout->addWidget(sectionEnergyEdit);
+        sectionLayout->addWidget(new QLabel("L:"));
+        sectionLayout->addWidget(sectionMomentumEdit);
+        sectionLayout->addWidget(new QLabel("Points:"));
+        sectionLayout->addWidget(sectionPointsEdit);
+        sectionLayout->addWidget(sectionButton);
+        sectionLayout->addWidget(clearSectionButton);
+        sectionLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(sectionLayout);
+        ensembleFrameLayout->addWidget(sectionStatusLabel);
+
+        // Потенциал формы: фон сферы с линиями уровня и границей области Хилла
+        QHBoxLayout* potentialLayout = new QHBoxLayout;
+
+        potentialCheckbox = new QCheckBox("Shape potential Ũ = U√I");
+        potentialCheckbox->setToolTip("Линии уровня Ũ; белая линия - граница области Хилла Ũ = √(-2EL²) для E и L сечения");
+
+        potentialStatusLabel = new QLabel;
+        potentialStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        potentialLayout->addWidget(potentialCheckbox);
+        potentialLayout->addWidget(potentialStatusLabel);
+        potentialLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(potentialLayout);
+
+        // Геодезические метрики Якоби: веер строится заново при каждом щелчке по сфере
+        QHBoxLayout* geodesicLayout = new QHBoxLayout;
+
+        geodesicCheckbox = new QCheckBox("Geodesic fan");
+        geodesicCheckbox->setToolTip("Геодезические метрики Ũ·dσ² из выбранной точки сферы (заменяют траекторию)");
+
+        geodesicDirectionsEdit = new QLineEdit("64");
+        geodesicDirectionsEdit->setValidator(new QIntValidator(1, 4096, this));
+        geodesicDirectionsEdit->setMaximumWidth(50);
+        geodesicDirectionsEdit->setToolTip("Число направлений");
+
+        QDoubleValidator* geodesicLengthValidator = new QDoubleValidator(0.01, 100.0, 3, this);
+        geodesicLengthValidator->setLocale(QLocale::C);
+        geodesicLengthEdit = new QLineEdit("3.14");
+        geodesicLengthEdit->setValidator(geodesicLengthValidator);
+        geodesicLengthEdit->setMaximumWidth(50);
+        geodesicLengthEdit->setToolTip("Длина кривых по круглой метрике сферы");
+
+        geodesicStatusLabel = new QLabel;
+        geodesicStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        geodesicLayout->addWidget(geodesicCheckbox);
+        geodesicLayout->addWidget(new QLabel("Directions:"));
+        geodesicLayout->addWidget(geodesicDirectionsEdit);
+        geodesicLayout->addWidget(new QLabel("Length:"));
+        geodesicLayout->addWidget(geodesicLengthEdit);
+        geodesicLayout->addWidget(geodesicStatusLabel);
+        geodesicLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(geodesicLayout);
+
+        // Плотность посещений: накапливается всё время, показывается по флажку
+        QHBoxLayout* densityLayout = new QHBoxLayout;
+
+        densityCheckbox = new QCheckBox("Visit density");
+        densityCheckbox->setToolTip("Доля времени в каждой равновеликой ячейке сферы относительно равномерной");
+
+        clearDensityButton = new QPushButton("Clear Density");
+        clearDensityButton->setFixedHeight(35);
+        clearDensityButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+
+        densityStatusLabel = new QLabel;
+        densityStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        densityLayout->addWidget(densityCheckbox);
+        densityLayout->addWidget(clearDensityButton);
+        densityLayout->addWidget(densityStatusLabel);
+        densityLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(densityLayout);
+
+        // Сферические гармоники: спектр мощности и гладкое восстановление карты
+        QHBoxLayout* spectrumLayout = new QHBoxLayout;
+
+        spectrumSourceCombo = new QComboBox;
+        spectrumSourceCombo->addItem("Spectrum: visit density");
+        spectrumSourceCombo->addItem("Spectrum: log Ũ");
+
+        // Верхняя граница - по сетке HEALPix, на которой анализируются оба источника
+        spectrumDegreeEdit = new QLineEdit("16");
+        spectrumDegreeValidator = new QIntValidator(0, 16, this);
+        spectrumDegreeEdit->setValidator(spectrumDegreeValidator);
+        spectrumDegreeEdit->setMaximumWidth(40);
+
+        spectrumSmoothCheckbox = new QCheckBox("Smooth");
+        spectrumSmoothCheckbox->setToolTip("Показать на сфере восстановление по гармоникам до ℓmax");
+
+        spectrumButton = new QPushButton("Spectrum");
+        spectrumButton->setFixedHeight(35);
+        spectrumButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+
+        spectrumStatusLabel = new QLabel;
+        spectrumStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        spectrumLayout->addWidget(spectrumSourceCombo);
+        spectrumLayout->addWidget(new QLabel("ℓmax:"));
+        spectrumLayout->addWidget(spectrumDegreeEdit);
+        spectrumLayout->addWidget(spectrumSmoothCheckbox);
+        spectrumLayout->addWidget(spectrumButton);
+        spectrumLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(spectrumLayout);
+        ensembleFrameLayout->addWidget(spectrumStatusLabel);
+
+        QHBoxLayout* monteCarloLayout = new QHBoxLayout;
+
+        monteCarloMeasureCombo = new QComboBox;
+        monteCarloMeasureCombo->addItem("Gaussian vertices", MonteCarloOptions::GaussianVertices);
+        monteCarloMeasureCombo->addItem("Uniform disk", MonteCarloOptions::UniformDisk);
+        monteCarloMeasureCombo->addItem("Uniform square", MonteCarloOptions::UniformSquare);
+        monteCarloMeasureCombo->setToolTip("Распределение вершин случайного треугольника");
+
+        monteCarloSamplesEdit = new QLineEdit("100000000");
+        monteCarloSamplesEdit->setMaximumWidth(100);
+        monteCarloSamplesEdit->setToolTip("Число треугольников");
+
+        monteCarloSeedEdit = new QLineEdit("1");
+        monteCarloSeedEdit->setMaximumWidth(60);
+        monteCarloSeedEdit->setToolTip("Один и тот же seed даёт один и тот же результат при любом числе ядер");
+
+        monteCarloButton = new QPushButton("Run Monte Carlo");
+        monteCarloButton->setFixedHeight(35);
+        monteCarloButton->setStyleSheet("QPushButton { padding: 8px; background-color: #e0e0e0; color: black; border: 1px solid #aaa; }");
+
+        monteCarloStatusLabel = new QLabel;
+        monteCarloStatusLabel->setStyleSheet("QLabel { font-family: monospace; }");
+
+        monteCarloLayout->addWidget(monteCarloMeasureCombo);
+        monteCarloLayout->addWidget(new QLabel("Triangles:"));
+        monteCarloLayout->addWidget(monteCarloSamplesEdit);
+        monteCarloLayout->addWidget(new QLabel("Seed:"));
+        monteCarloLayout->addWidget(monteCarloSeedEdit);
+        monteCarloLayout->addWidget(monteCarloButton);
+        monteCarloLayout->addStretch();
+
+        ensembleFrameLayout->addLayout(monteCarloLayout);
+        ensembleFrameLayout->addWidget(monteCarloStatusLabel);
+        sphereLayout->addWidget(ensembleFrame);
+
         // Добавляем сферу в правый сплиттер
         rightSplitter->addWidget(sphereContainer);
 
@@ -444,16 +762,207 @@ MainWindow::MainWindow() :
         setWindowTitle("Triangle-Sphere Projection System with 4-Branch Inverse Transform");
         resize(1400, 900);
 
-        // СОЗДАЕМ ТАЙМЕР АНИМАЦИИ
-        animationTimer = new QTimer(this);
-        animationTimer->setInterval(50); // 20 FPS
+        // Время отрисовки кадра для растрового и OpenGL viewport
+        frameStatsLabel = new QLabel;
+        frameStatsLabel->setStyleSheet("QLabel { font-family: monospace; }");
+        statusBar()->addPermanentWidget(frameStatsLabel, 1);
+        frameStatsTimer = new QTimer(this);
+        frameStatsTimer->setInterval(1000);
+        connect(frameStatsTimer, &QTimer::timeout, this, &MainWindow::updateFrameStats);
+        frameStatsTimer->start();
+
+        // ПЛАНИРОВЩИК ОБНОВЛЕНИЙ: каждый этап выполняется не чаще раза за проход цикла событий
+        updateScheduler = new UpdateScheduler(this);
+        geometryStage = updateScheduler->addStage("geometry", [this]() { scene->updateTriangle(); });
+        coordinatesStage = updateScheduler->addStage("coords", [this]() { updatePointCoordinates(); });
+        shapeStage = updateScheduler->addStage("shape", [this]() { updateSpherePoint(); });
+        scene->setUpdateScheduler(updateScheduler, geometryStage);
+
+        // Счётчики схлопнутых обновлений
+        schedulerStatsLabel = new QLabel;
+        schedulerStatsLabel->setStyleSheet("QLabel { font-family: monospace; }");
+        statusBar()->addPermanentWidget(schedulerStatsLabel);
+        connect(frameStatsTimer, &QTimer::timeout, this, [this]() {
+            schedulerStatsLabel->setText(updateScheduler->statsSummary());
+        });
+
+        // ПОТОК СИМУЛЯЦИИ: шагает по времени и считает формы треугольника
+        simulationWorker = new SimulationWorker(this);
+        simulationWorker->setMasses(scene->getMasses());
+        simulationWorker->setMaxTime(maxTime);
+        simulationWorker->setSpeed(speedFactor);
+        simulationWorker->start();
+
+        // ШКАЛА ВРЕМЕНИ: строится в фоне на всех ядрах
+        timelineCache = new TimelineCache(this);
+        timelineCache->start();
+
+        timelineStatusLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(timelineStatusLabel);
+        connect(timelineCache, &TimelineCache::progress, this, [this](int percent) {
+            timelineStatusLabel->setText(QString("timeline: %1%").arg(percent));
+        });
+        connect(timelineCache, &TimelineCache::ready, this, [this](int samples, qint64 elapsedMs) {
+            timelineStatusLabel->setText(QString("timeline: %1 samples (%2 ms)").arg(samples).arg(elapsedMs));
+            if (loadTimelineButton) loadTimelineButton->setEnabled(isAnimationMode);
+        });
+        connect(loadTimelineButton, &QPushButton::clicked, this, &MainWindow::loadTimelineTrajectory);
+
+        // АНСАМБЛЬ: свой поток, пачки раздаются на все ядра
+        ensembleRunner = new EnsembleRunner(this);
+        ensembleRunner->start();
+        connect(ensembleRunner, &EnsembleRunner::progress, this, [this](int percent) {
+            if (ensembleButton->text() != "Cancel") return; // запоздавший сигнал отменённого расчёта
+            ensembleStatusLabel->setText(QString("ensemble: %1%").arg(percent));
+        });
+        connect(ensembleRunner, &EnsembleRunner::ready, this, [this](int members, qint64 elapsedMs) {
+            ensembleButton->setText("Run Ensemble");
+            ensembleStatusLabel->setText(QString("ensemble: %1 shapes (%2 ms)").arg(members).arg(elapsedMs));
+            showEnsembleResult();
+        });
+        connect(ensembleButton, &QPushButton::clicked, this, &MainWindow::startEnsemble);
+        connect(clearEnsembleButton, &QPushButton::clicked, this, &MainWindow::clearEnsemble);
+        connect(ensembleModeCombo, &QComboBox::currentIndexChanged, this, [this]() {
+            // Смена раскраски не должна закрывать чужую карту (FTLE, плотность)
+            if (overlayOwner == Overlay::Ensemble) showEnsembleResult();
+        });
+
+        // КАРТА FTLE
+        ftleRunner = new FtleRunner(this);
+        ftleRunner->start();
+        connect(ftleRunner, &FtleRunner::progress, this, [this](int percent) {
+            if (ftleButton->text() != "Cancel") return;
+            ftleStatusLabel->setText(QString("FTLE: %1%").arg(percent));
+        });
+        connect(ftleRunner, &FtleRunner::ready, this, [this](int members, qint64 elapsedMs) {
+            ftleButton->setText("Run FTLE");
+            ftleStatusLabel->setText(QString("FTLE: %1 shapes (%2 ms)").arg(members).arg(elapsedMs));
+            showFtleResult();
+        });
+        connect(ftleButton, &QPushButton::clicked, this, &MainWindow::startFtle);
+
+        // СЕЧЕНИЕ ПУАНКАРЕ: точки забираются порциями, пока идёт расчёт
+        poincareRunner = new PoincareRunner(this);
+        poincareRunner->start();
+        connect(poincareRunner, &PoincareRunner::pointsAvailable, this, &MainWindow::drainPoincarePoints);
+        connect(poincareRunner, &PoincareRunner::progress, this, [this](int percent) {
+            if (sectionButton->text() != "Cancel") return;
+            sectionStatusLabel->setText(QString("section: %1%").arg(percent));
+        });
+        connect(poincareRunner, &PoincareRunner::ready, this, [this](quint64 points, int orbits, qint64 elapsedMs) {
+            drainPoincarePoints();
+            sectionButton->setText("Run Section");
+            sectionStatusLabel->setText(QString("section: %1 points from %2 orbits (%3 ms)")
+                                            .arg(points).arg(orbits).arg(elapsedMs));
+        });
+        connect(sectionButton, &QPushButton::clicked, this, &MainWindow::startPoincareSection);
+        connect(clearSectionButton, &QPushButton::clicked, this, &MainWindow::clearPoincareSection);
+
+        // ПОТЕНЦИАЛ ФОРМЫ: каждый проход присылает более подробную карту
+        potentialRunner = new ShapePotentialRunner(this);
+        potentialRunner->start();
+        connect(potentialRunner, &ShapePotentialRunner::ready, this, &MainWindow::showShapePotential);
+        connect(potentialCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
+            if (checked) {
+                requestShapePotential();
+                return;
+            }
+            potentialRunner->cancel();
+            sphereWidget->clearPotentialMap();
+            potentialStatusLabel->clear();
+        });
+        connect(sectionEnergyEdit, &QLineEdit::editingFinished, this, &MainWindow::updateHillBoundary);
+        connect(sectionMomentumEdit, &QLineEdit::editingFinished, this, &MainWindow::updateHillBoundary);
+
+        // ГЕОДЕЗИЧЕСКИЙ ВЕЕР
+        auto refreshGeodesicFan = [this]() {
+            if (geodesicCheckbox->isChecked()) showGeodesicFan(sphereWidget->getPoint());
+        };
+        connect(geodesicCheckbox, &QCheckBox::toggled, this, [this, refreshGeodesicFan](bool checked) {
+            if (checked) {
+                refreshGeodesicFan();
+                return;
+            }
+            sphereWidget->clearTrajectory();
+            geodesicStatusLabel->clear();
+        });
+        connect(geodesicDirectionsEdit, &QLineEdit::editingFinished, this, refreshGeodesicFan);
+        connect(geodesicLengthEdit, &QLineEdit::editingFinished, this, refreshGeodesicFan);
+
+        // ПЛОТНОСТЬ ПОСЕЩЕНИЙ: раз в секунду вместе со статистикой кадров
+        connect(frameStatsTimer, &QTimer::timeout, this, &MainWindow::updateVisitDensity);
+        connect(densityCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
+            if (checked) {
+                updateVisitDensity();
+                showOverlay(Overlay::VisitDensity, visitDensity.paint());
+                return;
+            }
+            // Карта делит текстуру с ансамблем и FTLE - убираем только свою
+            if (overlayOwner == Overlay::VisitDensity) clearOverlay();
+            densityStatusLabel->clear();
+        });
+        connect(clearDensityButton, &QPushButton::clicked, this, &MainWindow::clearVisitDensity);
+        connect(spectrumButton, &QPushButton::clicked, this, &MainWindow::analyzeSpectrum);
+        updateSpectrumDegreeLimit();
+
+        // МОНТЕ-КАРЛО ТРЕУГОЛЬНИКОВ: куски по всем ядрам, плотность - поверх сферы
+        monteCarlo = new TriangleMonteCarlo(this);
+        monteCarlo->start();
+        connect(monteCarlo, &TriangleMonteCarlo::progress, this, [this](int percent) {
+            if (monteCarloButton->text() != "Cancel") return;
+            monteCarloStatusLabel->setText(QString("Monte Carlo: %1%").arg(percent));
+        });
+        connect(monteCarlo, &TriangleMonteCarlo::ready, this, [this](quint64, qint64) {
+            monteCarloButton->setText("Run Monte Carlo");
+            showMonteCarloResult();
+        });
+        connect(monteCarloButton, &QPushButton::clicked, this, &MainWindow::startMonteCarlo);
+
+        connect(recordButton, &QPushButton::toggled, this, &MainWindow::setRecording);
+        connect(openRecordingButton, &QPushButton::clicked, this, &MainWindow::openRecording);
+
+        simulationStatsLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(simulationStatsLabel);
+        syzygyLabel = new QLabel(this);
+        syzygyLabel->setStyleSheet("QLabel { font-family: monospace; }");
+        syzygyLabel->setToolTip("Последние сизигии: номер тела, оказавшегося между двумя другими");
+        statusBar()->addPermanentWidget(syzygyLabel);
+
+        // Переходы через прямоугольные окружности и равнобедренные кривые
+        shapeEventsLabel = new QLabel(this);
+        shapeEventsLabel->setStyleSheet("QLabel { font-family: monospace; }");
+        statusBar()->addPermanentWidget(shapeEventsLabel);
+        connect(frameStatsTimer, &QTimer::timeout, this, [this]() {
+            ShapeEventStats stats;
+            if (!simulationWorker->shapeEventStats(stats)) return;
+            double total = stats.acuteTime + stats.obtuseTime;
+            shapeEventsLabel->setText(QString("obtuse: %1 in (t = %2), %3 out (t = %4), %5% of time; isosceles: %6")
+                                          .arg(stats.obtuseEntryCount())
+                                          .arg(stats.lastObtuseEntry, 0, 'f', 3)
+                                          .arg(stats.acuteEntries)
+                                          .arg(stats.lastAcuteEntry, 0, 'f', 3)
+                                          .arg(total > 0 ? 100.0 * stats.obtuseTime / total : 0.0, 0, 'f', 1)
+                                          .arg(stats.isoscelesCrossings[0] + stats.isoscelesCrossings[1] +
+                                               stats.isoscelesCrossings[2]));
+        });
+        connect(frameStatsTimer, &QTimer::timeout, this, [this]() {
+            simulationStatsLabel->setText(QString("sim: %1 samples, %2 refined, %3 skipped, %4 dropped")
+                                              .arg(simulationWorker->producedCount())
+                                              .arg(simulationWorker->refinedCount())
+                                              .arg(simulationWorker->skippedCount())
+                                              .arg(simulationWorker->droppedCount()));
+        });
 
         // ПОДКЛЮЧАЕМ СИГНАЛЫ И СЛОТЫ
         connect(scene, &TriangleScene::dragFinished, this, &MainWindow::onDragFinished);
-        connect(scene, &TriangleScene::triangleUpdated, this, &MainWindow::updatePointCoordinates);
-        connect(scene, &TriangleScene::pointPositionChanging, this, &MainWindow::updateSpherePoint);
+        connect(scene, &TriangleScene::triangleUpdated, this, [this]() {
+            updateScheduler->markDirty(coordinatesStage);
+            updateScheduler->markDirty(shapeStage);
+        });
+        connect(scene, &TriangleScene::pointPositionChanging, this, [this]() {
+            updateScheduler->markDirty(shapeStage);
+        });
         connect(sphereWidget, &SphereWidget::spherePointClicked, this, &MainWindow::handleSpherePointClicked);
-        connect(scene, &TriangleScene::triangleUpdated, this, &MainWindow::updateSpherePoint);
 
         // Подключаем сигналы для изменения курсора
         connect(scene, &TriangleScene::sceneDragStarted, this, [this]() {
@@ -514,16 +1023,29 @@ MainWindow::MainWindow() :
 
         // Подключаем анимацию
         connect(animationModeButton, &QPushButton::clicked, this, &MainWindow::onAnimationModeClicked);
+        connect(loadTableButton, &QPushButton::clicked, this, &MainWindow::loadPositionTable);
+        connect(threeBodyButton, &QPushButton::clicked, this, &MainWindow::startThreeBody);
+        connect(orbitButton, &QPushButton::clicked, this, &MainWindow::startOrbitSearch);
+        connect(saveOrbitButton, &QPushButton::clicked, this, &MainWindow::saveOrbit);
         connect(animationToggleButton, &QPushButton::clicked, this, &MainWindow::onAnimationToggle);
         connect(animationResetButton, &QPushButton::clicked, this, &MainWindow::onAnimationReset);
         connect(timeSlider, &QSlider::valueChanged, this, &MainWindow::onTimeSliderChanged);
-        connect(animationTimer, &QTimer::timeout, this, &MainWindow::updateAnimation);
+        // Кадры анимации идут в такт показу сферы: пока окно не видно,
+        // frameSwapped не приходит и выборки не разбираются
+        connect(sphereWidget, &QOpenGLWidget::frameSwapped, this, &MainWindow::onSphereFrameSwapped);
 
         // Подключаем чекбокс траектории к обоим виджетам
         connect(showTrajectoryCheckbox, &QCheckBox::toggled, sphereWidget, &SphereWidget::setShowTrajectory);
         connect(showTrajectoryCheckbox, &QCheckBox::toggled, complexPlaneView1, &ComplexPlaneView::setShowTrajectory);
         connect(showTrajectoryCheckbox, &QCheckBox::toggled, complexPlaneView2, &ComplexPlaneView2::setShowTrajectory);
 
+        // Фоновая растеризация комплексных плоскостей
+        connect(threadedPlanesCheckbox, &QCheckBox::toggled, complexPlaneView1, &ComplexPlaneView::setThreadedRendering);
+        connect(threadedPlanesCheckbox, &QCheckBox::toggled, complexPlaneView2, &ComplexPlaneView2::setThreadedRendering);
+
+        // Переключение viewport на OpenGL
+        connect(openGLViewportsCheckbox, &QCheckBox::toggled, this, &MainWindow::setOpenGLViewports);
+
         // Подключаем кнопку остановки рисования
         connect(stopDrawingButton, &QPushButton::clicked, this, [this, stopDrawingButton]() {
             bool drawingEnabled = sphereWidget->isDrawingEnabled();
@@ -541,6 +1063,40 @@ MainWindow::MainWindow() :
         // Подключаем обработчики для полей ввода
         connect(maxTimeEdit, &QLineEdit::editingFinished, this, &MainWindow::fixMaxTimeInput);
         connect(speedEdit, &QLineEdit::editingFinished, this, &MainWindow::fixSpeedInput);
+        connect(sampleRateEdit, &QLineEdit::editingFinished, this, [this]() {
+            bool ok;
+            double rate = sampleRateEdit->text().replace(',', '.').toDouble(&ok);
+            if (ok && rate > 0) simulationWorker->setSampleRate(rate);
+        });
+        connect(timelineResolutionEdit, &QLineEdit::editingFinished, this, [this]() {
+            bool ok;
+            int resolution = timelineResolutionEdit->text().toInt(&ok);
+            if (!ok || resolution == timelineResolution) return;
+            timelineResolution = resolution;
+            rebuildTimeline();
+        });
+
+        threeBodyStatsLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(threeBodyStatsLabel);
+        connect(frameStatsTimer, &QTimer::timeout, this, &MainWindow::updateThreeBodyStats);
+
+        // ПЕРИОДИЧЕСКИЕ ОРБИТЫ
+        orbitFinder = new PeriodicOrbitFinder(this);
+        orbitFinder->start();
+        connect(orbitFinder, &PeriodicOrbitFinder::progress, this, [this](int member, int iteration, double residual) {
+            if (orbitButton->text() != "Cancel") return;
+            orbitStatusLabel->setText(QString("orbit %1: iteration %2, |r| = %3")
+                                          .arg(member).arg(iteration).arg(residual, 0, 'e', 1));
+        });
+        connect(orbitFinder, &PeriodicOrbitFinder::ready, this, [this](int orbits, bool converged, qint64 elapsedMs) {
+            orbitButton->setText("Find Orbit");
+            if (!converged) {
+                orbitStatusLabel->setText(QString("orbit: no convergence (%1 ms)").arg(elapsedMs));
+                return;
+            }
+            showPeriodicOrbit();
+            orbitStatusLabel->setText(orbitStatusLabel->text() + QString(", %1 in family (%2 ms)").arg(orbits).arg(elapsedMs));
+        });
 
         // ПОДКЛЮЧАЕМ ЧЕКБОКС ANIMATION MODE
         connect(animationModeCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
@@ -548,9 +1104,13 @@ MainWindow::MainWindow() :
 
             // Включаем/выключаем элементы управления анимацией
             animationModeButton->setEnabled(checked);
+            loadTableButton->setEnabled(checked);
+            threeBodyButton->setEnabled(checked);
+            orbitButton->setEnabled(checked);
             animationToggleButton->setEnabled(checked);
             animationResetButton->setEnabled(checked);
             timeSlider->setEnabled(checked);
+            loadTimelineButton->setEnabled(checked && timelineCache->isReady());
 
             // ВКЛЮЧАЕМ ПОЛЯ ВВОДА ДАЖЕ В РЕЖИМЕ АНИМАЦИИ
             maxTimeEdit->setEnabled(true);
@@ -559,14 +1119,11 @@ MainWindow::MainWindow() :
 
             if (checked) {
                 // Включаем режим анимации
-                if (x1Func.isEmpty()) {
+                if (!positionSource) {
                     // Если функции не установлены, устанавливаем значения по умолчанию
-                    x1Func = "50 + 20*cos(t)";
-                    y1Func = "50 + 20*sin(t)";
-                    x2Func = "100 + 15*cos(2*t)";
-                    y2Func = "50 + 15*sin(2*t)";
-                    x3Func = "75 + 25*cos(0.5*t)";
-                    y3Func = "100 + 25*sin(0.5*t)";
+                    setPositionFunctions({"50 + 20*cos(t)", "50 + 20*sin(t)",
+                                          "100 + 15*cos(2*t)", "50 + 15*sin(2*t)",
+                                          "75 + 25*cos(0.5*t)", "100 + 25*sin(0.5*t)"});
                 }
                 currentTime = 0.0;
                 timeSlider->setValue(0);
@@ -576,7 +1133,7 @@ MainWindow::MainWindow() :
                 animationToggleButton->setText("Start");
             } else {
                 // Выключаем режим анимации
-                animationTimer->stop();
+                simulationWorker->setPlaying(false);
                 isAnimationRunning = false;
                 animationToggleButton->setText("Start");
             }
@@ -607,6 +1164,34 @@ MainWindow::MainWindow() :
 
 MainWindow::~MainWindow()
 {
+    if (timelineCache) {
+        timelineCache->stop();
+    }
+    if (ensembleRunner) {
+        ensembleRunner->stop();
+    }
+    if (ftleRunner) {
+        ftleRunner->stop();
+    }
+    if (orbitFinder) {
+        orbitFinder->stop();
+    }
+    if (poincareRunner) {
+        poincareRunner->stop();
+    }
+    if (potentialRunner) {
+        potentialRunner->stop();
+    }
+    if (monteCarlo) {
+        monteCarlo->stop();
+    }
+    if (simulationWorker) {
+        simulationWorker->stop();
+    }
+    if (tableLoader) {
+        // Чтение не прерывается; дожидаемся его, чтобы поток не удалялся работающим
+        tableLoader->wait();
+    }
     if (sphereWidget) {
         delete sphereWidget;
     }
@@ -637,71 +1222,211 @@ void MainWindow::updateSpherePoint()
         auto masses = scene->getMasses();
 
         if (points.size() == 3 && masses.size() == 3) {
-            // Получаем сырые координаты (до нормализации)
-            QVector3D rawCoords = CoordTransform::getRawSphereCoordinates(points, masses);
-            QVector3D rawCoordsnorm = CoordTransform::transformToSphere(points, masses);
-            if (!rawCoords.isNull()) {
-                double radius = rawCoords.length();
-
-                // Обновляем метку радиуса
-                if (radiusLabel) {
-                    QString radiusStr;
-                    if (radius > 1000 || (radius < 0.001 && radius > 0)) {
-                        radiusStr = QString::number(radius, 'e', 3);
-                    } else {
-                        radiusStr = QString::number(radius, 'f', 3);
-                    }
-                    radiusLabel->setText("Radius: " + radiusStr);
-                }
+            // При ручном перемещении след на сфере не рисуется - только на плоскостях
+            applyShapeState(ShapeState::compute(points, masses), false);
+        }
+    }
+    catch (const std::exception& e) {
+        qWarning() << "Exception in updateSpherePoint:" << e.what();
+    }
 
-                // Обновляем комплексную плоскость (ξ₂, ξ₃)
-                if (complexPlaneView1) {
-                    QPointF xiPoint(rawCoordsnorm.x(), rawCoordsnorm.y());
-                    complexPlaneView1->setPoint(xiPoint);
+    updatingFromTriangle = false;
+}
 
-                    if (showTrajectoryCheckbox->isChecked() && complexPlaneView1->isDrawingEnabled()) {
-                        complexPlaneView1->addToTrajectory(xiPoint);
-                    }
-                }
+void MainWindow::applyShapeState(const ShapeState& state, bool appendSphereTrajectory)
+{
+    if (!state.valid) return;
 
-                if (complexPlaneView2) {
-                    QPointF xiPoint(rawCoordsnorm.x(), rawCoordsnorm.y());
-                    QVector<ComplexSolution> solutions = CoordTransform::transformZetaToZ(xiPoint);
-                    complexPlaneView2->setSolutions(solutions);
+    showShapeState(state);
+    appendShapeTrajectory(state, appendSphereTrajectory);
+}
 
-                    if (showTrajectoryCheckbox->isChecked() && complexPlaneView2->isDrawingEnabled()) {
-                        complexPlaneView2->addToTrajectory(solutions);
-                    }
-                }
+void MainWindow::showShapeState(const ShapeState& state)
+{
+    if (!state.valid) return;
+
+    // Обновляем метку радиуса
+    if (radiusLabel) {
+        QString radiusStr;
+        if (state.radius > 1000 || (state.radius < 0.001 && state.radius > 0)) {
+            radiusStr = QString::number(state.radius, 'e', 3);
+        } else {
+            radiusStr = QString::number(state.radius, 'f', 3);
+        }
+        radiusLabel->setText("Radius: " + radiusStr);
+    }
 
-                // Обновляем метку комплексных координат
-                if (complexCoordsLabel) {
-                    complexCoordsLabel->setText(QString("Complex: (%1, %2)")
-                                                    .arg(rawCoordsnorm.x(), 0, 'f', 3)
-                                                    .arg(rawCoordsnorm.y(), 0, 'f', 3));
-                }
-            }
+    // Обновляем комплексную плоскость (ξ₂, ξ₃)
+    if (complexPlaneView1) {
+        complexPlaneView1->setPoint(state.zeta);
+    }
 
-            // Получаем нормализованную точку для отображения на сфере
-            QVector3D spherePoint = CoordTransform::transformToSphere(points, masses);
-            if (!spherePoint.isNull()) {
-                sphereWidget->setPoint(spherePoint);
-                lastSpherePoint = spherePoint;
-
-                if (sphereCoordsLabel) {
-                    sphereCoordsLabel->setText(QString("Sphere point: (%1, %2, %3)")
-                                                   .arg(spherePoint.x(), 0, 'f', 3)
-                                                   .arg(spherePoint.y(), 0, 'f', 3)
-                                                   .arg(spherePoint.z(), 0, 'f', 3));
-                }
-            }
-        }
+    // Обновляем преобразованную плоскость
+    if (complexPlaneView2) {
+        complexPlaneView2->setSolutions(state.solutions());
     }
-    catch (const std::exception& e) {
-        qWarning() << "Exception in updateSpherePoint:" << e.what();
+
+    if (complexCoordsLabel) {
+        complexCoordsLabel->setText(QString("Complex: (%1, %2)")
+                                        .arg(state.zeta.x(), 0, 'f', 3)
+                                        .arg(state.zeta.y(), 0, 'f', 3));
     }
 
-    updatingFromTriangle = false;
+    // Точка на сфере
+    if (sphereWidget) {
+        sphereWidget->setPoint(state.normalized);
+        lastSpherePoint = state.normalized;
+    }
+
+    if (sphereCoordsLabel) {
+        sphereCoordsLabel->setText(QString("Sphere point: (%1, %2, %3)")
+                                       .arg(state.normalized.x(), 0, 'f', 3)
+                                       .arg(state.normalized.y(), 0, 'f', 3)
+                                       .arg(state.normalized.z(), 0, 'f', 3));
+    }
+}
+
+void MainWindow::appendShapeTrajectory(const ShapeState& state, bool includeSphere)
+{
+    if (!state.valid) return;
+    if (!showTrajectoryCheckbox || !showTrajectoryCheckbox->isChecked()) return;
+
+    if (complexPlaneView1 && complexPlaneView1->isDrawingEnabled()) {
+        complexPlaneView1->addToTrajectory(state.zeta);
+    }
+    if (complexPlaneView2 && complexPlaneView2->isDrawingEnabled()) {
+        complexPlaneView2->addToTrajectory(state.solutions());
+    }
+    if (includeSphere && sphereWidget) {
+        sphereWidget->addToTrajectory(state.normalized);
+    }
+}
+
+void MainWindow::appendTrajectoryBatch(const TrajectoryBatch& batch, bool replace)
+{
+    if (batch.isEmpty() && !replace) return;
+    if (!showTrajectoryCheckbox || !showTrajectoryCheckbox->isChecked()) return;
+
+    const QPointF* roots[4];
+    batch.rootBuffers(roots);
+
+    if (sphereWidget) {
+        if (replace) sphereWidget->replaceTrajectory(batch.sphere.constData(), batch.size());
+        else sphereWidget->appendTrajectory(batch.sphere.constData(), batch.size());
+    }
+    if (complexPlaneView1 && complexPlaneView1->isDrawingEnabled()) {
+        if (replace) complexPlaneView1->replaceTrajectory(batch.zeta.constData(), batch.size());
+        else complexPlaneView1->appendTrajectory(batch.zeta.constData(), batch.size());
+    }
+    if (complexPlaneView2 && complexPlaneView2->isDrawingEnabled()) {
+        if (replace) complexPlaneView2->replaceTrajectories(roots, batch.size());
+        else complexPlaneView2->appendTrajectories(roots, batch.size());
+    }
+}
+
+void MainWindow::loadTimelineTrajectory()
+{
+    if (!timelineCache) return;
+
+    QVector<ShapeState> samples = timelineCache->samples();
+    if (samples.isEmpty()) return;
+
+    TrajectoryBatch batch;
+    batch.reserve(samples.size());
+    for (const ShapeState& state : samples) {
+        batch.append(state);
+    }
+
+    // Траектория за весь интервал видна только при включённом следе
+    if (showTrajectoryCheckbox) showTrajectoryCheckbox->setChecked(true);
+    appendTrajectoryBatch(batch, true);
+}
+
+void MainWindow::setRecording(bool enabled)
+{
+    if (!simulationWorker) return;
+
+    if (!enabled) {
+        // Файл закроется, когда поток симуляции отпустит последнюю ссылку
+        simulationWorker->setRecorder(nullptr);
+        statusBar()->showMessage("Recording stopped", 3000);
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Record Trajectory", "",
+                                                    "Trajectory recordings (*.tsrec);;All Files (*)");
+    if (fileName.isEmpty()) {
+        QSignalBlocker blocker(recordButton);
+        recordButton->setChecked(false);
+        return;
+    }
+
+    auto recorder = std::make_shared<TrajectoryRecorder>();
+    QStringList functions = {x1Func, y1Func, x2Func, y2Func, x3Func, y3Func};
+    if (!recorder->open(fileName, scene->getMasses(), functions)) {
+        QMessageBox::warning(this, "Recording Error", recorder->errorString());
+        QSignalBlocker blocker(recordButton);
+        recordButton->setChecked(false);
+        return;
+    }
+
+    simulationWorker->setRecorder(recorder);
+    statusBar()->showMessage("Recording to " + fileName, 3000);
+}
+
+void MainWindow::openRecording()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Recording", "",
+                                                    "Trajectory recordings (*.tsrec);;All Files (*)");
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    std::shared_ptr<TrajectoryReplay> opened = TrajectoryReplay::open(fileName, &error);
+    if (!opened) {
+        QMessageBox::warning(this, "Open Recording", error);
+        return;
+    }
+
+    // Воспроизведение записи заменяет анимацию
+    if (isAnimationRunning) onAnimationToggle();
+    replay = opened;
+
+    QList<double> masses = replay->masses();
+    mass1Edit->setText(QString::number(masses.value(0, 1.0)));
+    mass2Edit->setText(QString::number(masses.value(1, 1.0)));
+    mass3Edit->setText(QString::number(masses.value(2, 1.0)));
+    scene->setMasses(masses);
+    sphereWidget->setMasses(masses);
+    simulationWorker->setMasses(masses);
+    rebuildTimeline();
+    clearEnsemble();
+    clearPoincareSection();
+    clearVisitDensity();
+    requestShapePotential();
+
+    // Траектория целиком - из обзорных блоков, без чтения всех выборок
+    TrajectoryBatch batch;
+    replay->overview(batch);
+    if (showTrajectoryCheckbox) showTrajectoryCheckbox->setChecked(true);
+    appendTrajectoryBatch(batch, true);
+
+    timeSlider->setEnabled(true);
+    if (timeSlider->value() == 0) onTimeSliderChanged(0);
+    else timeSlider->setValue(0);
+
+    statusBar()->showMessage(QString("Replaying %1: %2 samples, t = %3..%4")
+                                 .arg(fileName)
+                                 .arg(replay->sampleCount())
+                                 .arg(replay->startTime(), 0, 'f', 2)
+                                 .arg(replay->endTime(), 0, 'f', 2));
+}
+
+void MainWindow::closeReplay()
+{
+    if (!replay) return;
+    replay.reset();
+    if (timeSlider) timeSlider->setEnabled(isAnimationMode);
+    statusBar()->clearMessage();
 }
 
 void MainWindow::updatePointCoordinates()
@@ -767,6 +1492,10 @@ void MainWindow::handleSpherePointClicked(const QVector3D& point)
         }
 
         updatePointCoordinates();
+
+        if (geodesicCheckbox && geodesicCheckbox->isChecked()) {
+            showGeodesicFan(point);
+        }
     }
     catch (const std::exception& e) {
         qWarning() << "Exception in handleSpherePointClicked:" << e.what();
@@ -780,8 +1509,8 @@ void MainWindow::handleSpherePointClicked(const QVector3D& point)
 
 void MainWindow::onDragFinished()
 {
-    updateSpherePoint();
-    updatePointCoordinates();
+    updateScheduler->markDirty(shapeStage);
+    updateScheduler->markDirty(coordinatesStage);
 }
 
 void MainWindow::zoomIn()
@@ -835,6 +1564,13 @@ void MainWindow::setMasses()
     // Устанавливаем массы
     QList<double> masses = {mass1, mass2, mass3};
     scene->setMasses(masses);
+    if (simulationWorker) simulationWorker->setMasses(masses);
+    rebuildTimeline();
+    clearEnsemble(); // карта и сечение посчитаны для старых масс
+    clearPoincareSection();
+    clearVisitDensity();
+    requestShapePotential();
+    if (geodesicCheckbox->isChecked()) showGeodesicFan(sphereWidget->getPoint());
 
     // ПРИНУДИТЕЛЬНО ОБНОВЛЯЕМ SPHERE WIDGET
     sphereWidget->setMasses(masses);
@@ -869,12 +1605,8 @@ void MainWindow::onAnimationModeClicked()
     }
 
     if (dialog.exec() == QDialog::Accepted) {
-        x1Func = dialog.getX1();
-        y1Func = dialog.getY1();
-        x2Func = dialog.getX2();
-        y2Func = dialog.getY2();
-        x3Func = dialog.getX3();
-        y3Func = dialog.getY3();
+        setPositionFunctions({dialog.getX1(), dialog.getY1(), dialog.getX2(),
+                              dialog.getY2(), dialog.getX3(), dialog.getY3()});
 
         animationToggleButton->setEnabled(true); // ИСПРАВЛЕНО: было animationStartButton
         animationResetButton->setEnabled(true);
@@ -892,8 +1624,11 @@ void MainWindow::onAnimationModeClicked()
 
 void MainWindow::onAnimationReset()
 {
-    if (animationTimer) {
-        animationTimer->stop();
+    closeReplay();
+
+    if (simulationWorker) {
+        simulationWorker->setPlaying(false);
+        simulationWorker->setTime(0.0);
     }
 
     currentTime = 0.0;
@@ -921,199 +1656,865 @@ void MainWindow::onAnimationReset()
 
 void MainWindow::onTimeSliderChanged(int value)
 {
-    if (!maxTimeEdit) return;
-
-    bool ok;
-    maxTime = maxTimeEdit->text().toDouble(&ok);
-    if (!ok || maxTime <= 0) {
-        maxTime = 20.0;
+    if (replay) {
+        // Запись читается из отображённого файла, симуляцию не трогаем
+        currentTime = replay->startTime() +
+                      (value / double(SliderResolution)) * (replay->endTime() - replay->startTime());
+        ShapeState state;
+        if (replay->stateAt(currentTime, state)) {
+            showTrianglePoints(state.points);
+            applyShapeState(state, false);
+            updatePointCoordinates();
+        }
+        updateTimeLabel();
+        return;
     }
 
-    currentTime = (value / 100.0) * maxTime;
-    evaluateFunctions(currentTime);
+    currentTime = (value / double(SliderResolution)) * maxTime;
+    if (simulationWorker) simulationWorker->setTime(currentTime);
+
+    // Готовая шкала времени: поиск и интерполяция вместо полного пересчёта
+    ShapeState state;
+    if (isAnimationMode && scene && timelineCache && timelineCache->lookup(currentTime, state)) {
+        showTrianglePoints(state.points);
+        applyShapeState(state, true);
+        updatePointCoordinates();
+    } else {
+        evaluateFunctions(currentTime);
+    }
     updateTimeLabel();
 }
 
 void MainWindow::updateAnimation()
 {
-    if (!maxTimeEdit || !speedEdit) return;
-
-    bool ok;
-    maxTime = maxTimeEdit->text().toDouble(&ok);
-    if (!ok || maxTime <= 0) {
-        maxTime = 20.0;
-    }
+    if (!simulationWorker) return;
 
-    double speedFactor = speedEdit->text().toDouble(&ok);
-    if (!ok || speedFactor <= 0) {
-        speedFactor = 1.0;
-    }
-
-    double previousTime = currentTime;
-    currentTime += timeStep * speedFactor;
+    updateTrailTolerance();
 
-    // Если время перескочило с максимума на минимум, разрываем траектории
-    if (previousTime > maxTime * 0.9 && currentTime < maxTime * 0.1) {
-        if (sphereWidget && sphereWidget->isDrawingEnabled()) {
-            sphereWidget->breakTrajectory();
+    // Все выборки с прошлого кадра идут в траектории одним пакетом
+    frameTrail.clear();
+    ShapeSample sample;
+    while (simulationWorker->popSample(sample)) {
+        if (sample.wrapped) {
+            frameTrail.appendBreak();
         }
-        if (complexPlaneView1 && complexPlaneView1->isDrawingEnabled()) {
-            complexPlaneView1->breakTrajectory();
+        frameTrail.append(sample.state);
+    }
+    appendTrajectoryBatch(frameTrail, false);
+
+    // Символьная последовательность сизигий; после перемотки начинается заново
+    SyzygyEvent syzygy;
+    bool newSyzygies = false;
+    while (simulationWorker->popSyzygy(syzygy)) {
+        if (syzygy.epoch != syzygyEpoch) {
+            syzygyEpoch = syzygy.epoch;
+            syzygySequence.clear();
         }
-        if (complexPlaneView2 && complexPlaneView2->isDrawingEnabled()) {
-            complexPlaneView2->breakTrajectory();
+        if (syzygySequence.size() >= MaxSyzygySymbols) {
+            syzygySequence.remove(0, MaxSyzygySymbols / 2);
         }
+        syzygySequence.append(SyzygyDetector::symbol(syzygy.middle));
+        lastSyzygyTime = syzygy.time;
+        newSyzygies = true;
     }
-
-    if (currentTime > maxTime) {
-        currentTime = 0.0;
+    if (newSyzygies && syzygyLabel) {
+        syzygyLabel->setText(QString("syzygies: %1 (t = %2)")
+                                 .arg(QString::fromLatin1(syzygySequence.right(32)))
+                                 .arg(lastSyzygyTime, 0, 'f', 4));
     }
 
-    int sliderValue = static_cast<int>((currentTime / maxTime) * 100);
+    // Точки и метки - только по самой свежей выборке
+    if (!simulationWorker->latestSample(sample)) return;
+
+    currentTime = sample.time;
     if (timeSlider) {
-        timeSlider->setValue(sliderValue);
+        // Без сигнала, иначе слайдер перемотает симуляцию
+        QSignalBlocker blocker(timeSlider);
+        timeSlider->setValue(static_cast<int>((currentTime / maxTime) * SliderResolution));
     }
 
-    evaluateFunctions(currentTime);
+    showTrianglePoints(sample.state.points);
+    showShapeState(sample.state);
+    updatePointCoordinates();
     updateTimeLabel();
 }
 
+void MainWindow::updateTrailTolerance()
+{
+    if (!simulationWorker || !sphereWidget || !complexPlaneView1) return;
+
+    // Шаг следа не должен превышать примерно пиксель на экране
+    const double pixelTolerance = 1.5;
+    double sphereScale = sphereWidget->pixelsPerUnit();
+    double zetaScale = complexPlaneView1->transform().m11();
+    if (sphereScale <= 0 || zetaScale <= 0) return;
+
+    double sphereAngle = pixelTolerance / sphereScale;
+    double zetaStep = pixelTolerance / zetaScale;
+    if (qFuzzyCompare(sphereAngle, lastTrailTolerance.x()) &&
+        qFuzzyCompare(zetaStep, lastTrailTolerance.y())) {
+        return;
+    }
+
+    lastTrailTolerance = QPointF(sphereAngle, zetaStep);
+    simulationWorker->setTrailTolerance(sphereAngle, zetaStep);
+}
+
+void MainWindow::onSphereFrameSwapped()
+{
+    if (!isAnimationRunning) return;
+
+    updateAnimation();
+
+    // Просим следующий кадр; частоту ограничивает vsync
+    if (sphereWidget) sphereWidget->update();
+}
+
 void MainWindow::updateTimeLabel()
 {
     timeLabel->setText(QString("t = %1").arg(currentTime, 0, 'f', 2));
 }
 
-double MainWindow::evaluateExpression(const QString& expression, double t) {
-    if (expression.isEmpty()) return 0.0;
+void MainWindow::evaluateFunctions(double t)
+{
+    if (!isAnimationMode || !scene || !positionSource) return;
 
-    try {
-        return MathParser::evaluate(expression, t);
-    } catch (const std::exception& e) {
-        qWarning() << "Expression evaluation error:" << expression << "->" << e.what();
-        return 0.0;
+    QPointF points[3];
+    if (!positionSource->positionsAt(t, points)) {
+        qWarning() << "Invalid point in animation at t =" << t;
+        return;
     }
+
+    // ПРОВЕРЯЕМ РАЗМЕР ТРЕУГОЛЬНИКА И МАСШТАБИРУЕМ ТОЛЬКО МАЛЕНЬКИЕ
+    PositionSource::fitToScene(points);
+
+    showTrianglePoints(points);
+
+    // ОБНОВЛЯЕМ СФЕРУ, РАДИУС И КОМПЛЕКСНЫЕ ПЛОСКОСТИ
+    applyShapeState(ShapeState::compute({points[0], points[1], points[2]}, scene->getMasses()), true);
+
+    updatePointCoordinates();
 }
 
-void MainWindow::evaluateFunctions(double t)
+void MainWindow::showTrianglePoints(const QPointF points[3])
+{
+    blockSceneUpdates = true;
+    scene->setPoints({points[0], points[1], points[2]});
+    blockSceneUpdates = false;
+
+    // Автоматически масштабируем вид
+    autoScaleTriangleView();
+}
+
+void MainWindow::setPositionFunctions(const QStringList& functions)
+{
+    if (functions.size() != 6) return;
+    closeReplay();
+
+    x1Func = functions[0];
+    y1Func = functions[1];
+    x2Func = functions[2];
+    y2Func = functions[3];
+    x3Func = functions[4];
+    y3Func = functions[5];
+
+    auto source = std::make_shared<ExpressionSource>(functions);
+    setPositionSource(source->isValid() ? source : nullptr);
+}
+
+void MainWindow::setPositionSource(std::shared_ptr<const PositionSource> source)
+{
+    positionSource = std::move(source);
+    threeBodySource = std::dynamic_pointer_cast<const ThreeBodySource>(positionSource);
+    if (!threeBodySource && threeBodyStatsLabel) threeBodyStatsLabel->clear();
+    periodicSource = std::dynamic_pointer_cast<const PeriodicOrbitSource>(positionSource);
+    if (saveOrbitButton) saveOrbitButton->setEnabled(periodicSource != nullptr);
+    if (simulationWorker) simulationWorker->setSource(positionSource);
+    rebuildTimeline();
+}
+
+void MainWindow::startThreeBody()
+{
+    if (!scene) return;
+
+    bool ok;
+    double step = integratorStepEdit->text().replace(',', '.').toDouble(&ok);
+    if (!ok || step <= 0) {
+        QMessageBox::warning(this, "Three-body", "Please enter a positive integration step.");
+        return;
+    }
+
+    const QList<double> masses = scene->getMasses();
+    const QList<QPointF> scenePoints = scene->getPoints();
+    const QPointF points[3] = {scenePoints.value(0), scenePoints.value(1), scenePoints.value(2)};
+
+    ThreeBodySystem::State initial;
+    switch (threeBodyPresetCombo->currentIndex()) {
+    case 1: initial = ThreeBodySystem::rotatingTriangle(points, masses); break;
+    case 2: initial = ThreeBodySystem::triangleAtRest(points, masses); break;
+    default: initial = ThreeBodySystem::figureEight(masses); break;
+    }
+    auto integrator = static_cast<ThreeBodySystem::Integrator>(integratorCombo->currentData().toInt());
+
+    closeReplay();
+    if (isAnimationRunning) onAnimationToggle();
+
+    // Функции больше не описывают движение
+    x1Func.clear(); y1Func.clear(); x2Func.clear();
+    y2Func.clear(); x3Func.clear(); y3Func.clear();
+
+    setPositionSource(std::make_shared<ThreeBodySource>(masses, initial, integrator, step));
+
+    animationToggleButton->setEnabled(true);
+    animationResetButton->setEnabled(true);
+    timeSlider->setEnabled(true);
+    onAnimationReset();
+}
+
+void MainWindow::updateThreeBodyStats()
+{
+    if (!threeBodySource || !threeBodyStatsLabel) return;
+
+    ThreeBodySource::Diagnostics d = threeBodySource->diagnostics();
+    threeBodyStatsLabel->setText(QString("3-body: t = %1, %2 Msteps/s, dE/E = %3, dL = %4%5")
+                                     .arg(d.time, 0, 'f', 1)
+                                     .arg(d.stepsPerSecond * 1e-6, 0, 'f', 2)
+                                     .arg(d.energyDrift, 0, 'e', 1)
+                                     .arg(d.angularMomentumDrift, 0, 'e', 1)
+                                     .arg(d.failed ? QString(", collision") : QString()));
+}
+
+void MainWindow::startOrbitSearch()
 {
-    if (!isAnimationMode || !scene) return;
+    if (!orbitFinder || !scene) return;
 
-    // ДОБАВЛЯЕМ ПРОВЕРКИ НА ПУСТЫЕ ФУНКЦИИ
-    if (x1Func.isEmpty() || y1Func.isEmpty() || x2Func.isEmpty() ||
-        y2Func.isEmpty() || x3Func.isEmpty() || y3Func.isEmpty()) {
+    if (orbitButton->text() == "Cancel") {
+        orbitFinder->cancel();
+        orbitButton->setText("Find Orbit");
+        orbitStatusLabel->setText("orbit: cancelled");
         return;
     }
 
-    double x1 = evaluateExpression(x1Func, t);
-    double y1 = evaluateExpression(y1Func, t);
-    double x2 = evaluateExpression(x2Func, t);
-    double y2 = evaluateExpression(y2Func, t);
-    double x3 = evaluateExpression(x3Func, t);
-    double y3 = evaluateExpression(y3Func, t);
+    bool ok;
+    double period = orbitPeriodEdit->text().replace(',', '.').toDouble(&ok);
+    if (!ok || period <= 0) {
+        QMessageBox::warning(this, "Periodic Orbit", "Please enter a positive period guess.");
+        return;
+    }
+    double targetMass = -1.0;
+    if (!orbitMassEdit->text().trimmed().isEmpty()) {
+        targetMass = orbitMassEdit->text().replace(',', '.').toDouble(&ok);
+        if (!ok || targetMass <= 0) {
+            QMessageBox::warning(this, "Periodic Orbit", "The continuation mass must be positive.");
+            return;
+        }
+    }
 
-    QList<QPointF> points = {
-        QPointF(x1, y1),
-        QPointF(x2, y2),
-        QPointF(x3, y3)
-    };
+    PeriodicOrbitOptions options;
+    options.masses = scene->getMasses();
+    options.period = period;
+    options.continuationMass = targetMass;
 
-    // Проверяем валидность точек
-    for (const QPointF& point : points) {
-        if (std::isnan(point.x()) || std::isinf(point.x()) ||
-            std::isnan(point.y()) || std::isinf(point.y())) {
-            qWarning() << "Invalid point in animation:" << point;
+    if (orbitSeedCombo->currentIndex() == 1) {
+        if (!positionSource || !PeriodicOrbitFinder::seedFromSource(*positionSource, currentTime,
+                                                                    options.masses, options.seed)) {
+            QMessageBox::warning(this, "Periodic Orbit", "The current animation does not define a usable state at this time.");
             return;
         }
+    } else {
+        options.seed = ThreeBodySystem::figureEight(options.masses);
     }
 
-    // ПРОВЕРЯЕМ РАЗМЕР ТРЕУГОЛЬНИКА И МАСШТАБИРУЕМ ТОЛЬКО МАЛЕНЬКИЕ
-    double triangleSize = calculateTriangleSize(points);
-    const double smallTriangleThreshold = 50.0;
+    orbitFinder->launch(options);
+    orbitButton->setText("Cancel");
+    orbitStatusLabel->setText("orbit: shooting...");
+}
+
+void MainWindow::showPeriodicOrbit()
+{
+    std::shared_ptr<const PeriodicOrbitResult> result = orbitFinder ? orbitFinder->result() : nullptr;
+    if (!result || result->family.isEmpty()) return;
+
+    // Анимируем последнюю орбиту семейства: при продолжении у неё уже другая m3
+    const PeriodicOrbit& orbit = result->family.last();
+    if (orbit.masses != scene->getMasses()) {
+        mass1Edit->setText(QString::number(orbit.masses.value(0)));
+        mass2Edit->setText(QString::number(orbit.masses.value(1)));
+        mass3Edit->setText(QString::number(orbit.masses.value(2)));
+        setMasses();
+    }
 
-    if (triangleSize < smallTriangleThreshold) {
-        const double scale = 50.0;
-        const double center = 100.0;
+    auto source = std::make_shared<PeriodicOrbitSource>(orbit);
+    if (!source->isValid()) return;
 
-        for (int i = 0; i < points.size(); ++i) {
-            points[i] = QPointF(points[i].x() * scale + center,
-                                points[i].y() * scale + center);
-        }
+    closeReplay();
+    if (isAnimationRunning) onAnimationToggle();
+
+    // Функции больше не описывают движение
+    x1Func.clear(); y1Func.clear(); x2Func.clear();
+    y2Func.clear(); x3Func.clear(); y3Func.clear();
+
+    orbitPeriodEdit->setText(QString::number(orbit.period, 'f', 6));
+    setPositionSource(source);
+
+    animationToggleButton->setEnabled(true);
+    animationResetButton->setEnabled(true);
+    timeSlider->setEnabled(true);
+    onAnimationReset();
+
+    orbitStatusLabel->setText(QString("orbit: T = %1, E = %2, |r| = %3")
+                                  .arg(orbit.period, 0, 'f', 6)
+                                  .arg(orbit.energy, 0, 'f', 6)
+                                  .arg(orbit.residual, 0, 'e', 1));
+}
+
+void MainWindow::saveOrbit()
+{
+    if (!periodicSource) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Periodic Orbit", "",
+                                                    "CSV Files (*.csv);;All Files (*)");
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!periodicSource->save(fileName, 1, &error)) {
+        QMessageBox::warning(this, "Save Orbit", error);
+        return;
     }
+    statusBar()->showMessage("Orbit saved to " + fileName, 5000);
+}
 
-    blockSceneUpdates = true;
-    scene->setPoints(points);
-    blockSceneUpdates = false;
+void MainWindow::showOverlay(Overlay owner, const QImage& image)
+{
+    // Чужая карта снимает флажок плотности, иначе таймер тут же перерисовал бы её
+    if (owner != Overlay::VisitDensity && densityCheckbox && densityCheckbox->isChecked()) {
+        QSignalBlocker blocker(densityCheckbox);
+        densityCheckbox->setChecked(false);
+        densityStatusLabel->clear();
+    }
+    overlayOwner = owner;
+    sphereWidget->setOutcomeOverlay(image);
+}
 
-    // Автоматически масштабируем вид
-    autoScaleTriangleView();
+void MainWindow::clearOverlay()
+{
+    overlayOwner = Overlay::None;
+    sphereWidget->clearOutcomeOverlay();
+}
 
-    // ОБНОВЛЯЕМ РАДИУС И КОМПЛЕКСНЫЕ ПЛОСКОСТИ
-    auto masses = scene->getMasses();
-    QVector3D rawCoords = CoordTransform::getRawSphereCoordinates(points, masses);
-    QVector3D rawCoordsnorm = CoordTransform::transformToSphere(points, masses);
+void MainWindow::startEnsemble()
+{
+    if (!ensembleRunner) return;
 
-    if (!rawCoords.isNull()) {
-        double radius = rawCoords.length();
+    // Повторное нажатие во время расчёта отменяет его
+    if (ensembleButton->text() == "Cancel") {
+        ensembleRunner->cancel();
+        ensembleButton->setText("Run Ensemble");
+        ensembleStatusLabel->setText("ensemble: cancelled");
+        return;
+    }
 
-        if (radiusLabel) {
-            QString radiusStr;
-            if (radius > 1000 || (radius < 0.001 && radius > 0)) {
-                radiusStr = QString::number(radius, 'e', 3);
-            } else {
-                radiusStr = QString::number(radius, 'f', 3);
-            }
-            radiusLabel->setText("Radius: " + radiusStr);
-        }
+    bool ok1 = false, ok2 = false;
+    int width = ensembleResolutionEdit->text().toInt(&ok1);
+    double tmax = ensembleTimeEdit->text().replace(',', '.').toDouble(&ok2);
+    if (!ok1 || !ok2 || width < 8 || tmax <= 0) {
+        QMessageBox::warning(this, "Invalid Input", "Please enter a grid width of at least 8 and a positive time limit.");
+        return;
+    }
 
-        // Обновляем исходную комплексную плоскость
-        if (complexPlaneView1) {
-            complexPlaneView1->setPoint(QPointF(rawCoordsnorm.x(), rawCoordsnorm.y()));
+    EnsembleOptions options;
+    options.masses = scene->getMasses();
+    options.width = width;
+    options.height = qMax(4, width / 2);
+    options.maxTime = tmax;
 
-            if (showTrajectoryCheckbox && showTrajectoryCheckbox->isChecked() && complexPlaneView1->isDrawingEnabled()) {
-                complexPlaneView1->addToTrajectory(QPointF(rawCoordsnorm.x(), rawCoordsnorm.y()));
-            }
-        }
+    ensembleRunner->launch(options);
+    ensembleButton->setText("Cancel");
+    ensembleStatusLabel->setText(QString("ensemble: %1 shapes...").arg(options.width * options.height));
+}
 
-        // Обновляем преобразованную плоскость
-        if (complexPlaneView2) {
-            QPointF xiPoint(rawCoordsnorm.x(), rawCoordsnorm.y());
-            QVector<ComplexSolution> solutions = CoordTransform::transformZetaToZ(xiPoint);
-            complexPlaneView2->setSolutions(solutions);
+void MainWindow::showEnsembleResult()
+{
+    if (!ensembleRunner) return;
 
-            if (showTrajectoryCheckbox && showTrajectoryCheckbox->isChecked() && complexPlaneView2->isDrawingEnabled()) {
-                complexPlaneView2->addToTrajectory(solutions);
-            }
-        }
+    std::shared_ptr<const EnsembleResult> result = ensembleRunner->result();
+    if (!result) return;
 
-        if (complexCoordsLabel) {
-            complexCoordsLabel->setText(QString("Complex: (%1, %2)")
-                                            .arg(rawCoords.x(), 0, 'f', 3)
-                                            .arg(rawCoords.y(), 0, 'f', 3));
-        }
+    auto mode = static_cast<EnsembleRunner::ColorMode>(ensembleModeCombo->currentData().toInt());
+    showOverlay(Overlay::Ensemble, EnsembleRunner::paint(*result, mode));
+}
+
+void MainWindow::clearEnsemble()
+{
+    if (!ensembleRunner) return;
+
+    ensembleRunner->cancel();
+    ensembleRunner->clearResult();
+    ensembleButton->setText("Run Ensemble");
+    ensembleStatusLabel->clear();
+
+    // Карта FTLE делит с ансамблем текстуру сферы; её кэш при этом не трогаем
+    if (ftleRunner) {
+        ftleRunner->cancel();
+        ftleRunner->clearResult();
+        ftleButton->setText("Run FTLE");
+        ftleStatusLabel->clear();
+    }
+    if (overlayOwner == Overlay::Ensemble || overlayOwner == Overlay::Ftle) clearOverlay();
+}
+
+void MainWindow::startFtle()
+{
+    if (!ftleRunner) return;
+
+    if (ftleButton->text() == "Cancel") {
+        ftleRunner->cancel();
+        ftleButton->setText("Run FTLE");
+        ftleStatusLabel->setText("FTLE: cancelled");
+        return;
+    }
+
+    bool ok1 = false, ok2 = false;
+    int width = ensembleResolutionEdit->text().toInt(&ok1);
+    double horizon = ftleHorizonEdit->text().replace(',', '.').toDouble(&ok2);
+    if (!ok1 || !ok2 || width < 8 || horizon <= 0) {
+        QMessageBox::warning(this, "Invalid Input", "Please enter a grid width of at least 8 and a positive horizon.");
+        return;
+    }
+
+    FtleOptions options;
+    options.masses = scene->getMasses();
+    options.width = width;
+    options.height = qMax(4, width / 2);
+    options.horizon = horizon;
+
+    if (ftleRunner->launch(options)) {
+        ftleStatusLabel->setText("FTLE: cached");
+        showFtleResult();
+        return;
+    }
+    ftleButton->setText("Cancel");
+    ftleStatusLabel->setText(QString("FTLE: %1 shapes...").arg(options.width * options.height));
+}
+
+void MainWindow::showFtleResult()
+{
+    if (!ftleRunner) return;
+
+    std::shared_ptr<const FtleResult> result = ftleRunner->result();
+    if (!result) return;
+
+    // Текстура загружается один раз; вращение сферы её не пересчитывает
+    showOverlay(Overlay::Ftle, FtleRunner::paint(*result));
+}
+
+void MainWindow::requestShapePotential()
+{
+    if (!potentialRunner || !potentialCheckbox->isChecked()) return;
+
+    // Старая карта остаётся на сфере, пока не придёт первый проход для новых масс
+    if (potentialRunner->request(scene->getMasses())) {
+        showShapePotential();
+        return;
+    }
+    potentialStatusLabel->setText("Ũ: computing...");
+}
+
+void MainWindow::showShapePotential()
+{
+    if (!potentialRunner || !potentialCheckbox->isChecked()) return;
+
+    std::shared_ptr<const ShapePotentialMap> map = potentialRunner->result();
+    if (!map || map->masses != scene->getMasses()) return;
+
+    sphereWidget->setPotentialMap(map->image, map->contours, hillBoundary(*map));
+    potentialStatusLabel->setText(QString("Ũ: %1 ... %2, %3x%4 (%5 ms)")
+                                      .arg(map->minimum, 0, 'g', 4).arg(map->maximum, 0, 'g', 4)
+                                      .arg(map->width).arg(map->height).arg(map->elapsedMs));
+}
+
+void MainWindow::updateHillBoundary()
+{
+    if (!potentialRunner || !potentialCheckbox->isChecked()) return;
+
+    std::shared_ptr<const ShapePotentialMap> map = potentialRunner->result();
+    if (!map || map->masses != scene->getMasses()) return;
+
+    // Граница - одна линия уровня уже посчитанной карты, пересчёт карты не нужен
+    sphereWidget->setHillBoundary(hillBoundary(*map));
+}
+
+QVector<QVector3D> MainWindow::hillBoundary(const ShapePotentialMap& map) const
+{
+    bool ok1, ok2;
+    double energy = sectionEnergyEdit->text().replace(',', '.').toDouble(&ok1);
+    double momentum = sectionMomentumEdit->text().replace(',', '.').toDouble(&ok2);
+    if (!ok1 || !ok2) return {};
+
+    // Ниже минимума Ũ ограничения нет: достижима вся сфера
+    const double level = ShapePotentialRunner::hillLevel(energy, momentum);
+    if (level <= map.minimum) return {};
+    return ShapePotentialRunner::contour(map, level);
+}
+
+void MainWindow::showGeodesicFan(const QVector3D& start)
+{
+    bool ok1, ok2;
+    int directions = geodesicDirectionsEdit->text().toInt(&ok1);
+    double length = geodesicLengthEdit->text().replace(',', '.').toDouble(&ok2);
+    if (!ok1 || !ok2 || directions <= 0 || length <= 0) {
+        geodesicStatusLabel->setText("geodesics: invalid parameters");
+        return;
+    }
+
+    GeodesicFanOptions options;
+    options.masses = scene->getMasses();
+    options.start = start;
+    options.directions = directions;
+    options.length = length;
+
+    // Пачка направлений считается за миллисекунды - прямо в потоке интерфейса
+    GeodesicFanResult fan;
+    try {
+        fan = GeodesicFan::compute(options);
+    }
+    catch (const std::exception& e) {
+        qWarning() << "Exception in showGeodesicFan:" << e.what();
+        return;
+    }
+    if (fan.curves == 0) {
+        geodesicStatusLabel->setText("geodesics: start point is a collision");
+        return;
     }
 
-    // ВЫЧИСЛЯЕМ ТОЧКУ НА СФЕРЕ
-    QVector3D spherePoint = CoordTransform::transformToSphere(points, masses);
+    if (showTrajectoryCheckbox) showTrajectoryCheckbox->setChecked(true);
+    sphereWidget->replaceTrajectory(fan.points.constData(), fan.points.size());
+    geodesicStatusLabel->setText(QString("geodesics: %1 curves, %2 to collision (%3 ms)")
+                                     .arg(fan.curves).arg(fan.collisions).arg(fan.elapsedMs));
+}
+
+void MainWindow::updateVisitDensity()
+{
+    if (!simulationWorker || !densityCheckbox) return;
+
+    // Забираем всегда, чтобы поток не копил; текстура - только пока карта наша
+    const bool changed = simulationWorker->takeVisits(visitDensity);
+    if (!densityCheckbox->isChecked() || overlayOwner != Overlay::VisitDensity) return;
+
+    if (changed) showOverlay(Overlay::VisitDensity, visitDensity.paint());
+    densityStatusLabel->setText(QString("visits: %1 samples, %2% of cells")
+                                    .arg(visitDensity.total())
+                                    .arg(100.0 * visitDensity.visitedCells() / visitDensity.pixelCount(), 0, 'f', 1));
+}
+
+void MainWindow::clearVisitDensity()
+{
+    if (!simulationWorker || !densityCheckbox) return;
+
+    simulationWorker->clearVisits();
+    visitDensity.clear();
+    if (densityCheckbox->isChecked() && overlayOwner == Overlay::VisitDensity) {
+        showOverlay(Overlay::VisitDensity, visitDensity.paint());
+        densityStatusLabel->clear();
+    }
+}
+
+int MainWindow::spectrumDegreeLimit() const
+{
+    // Оба источника анализируются на пикселях HEALPix гистограммы посещений
+    return SphericalHarmonics::maxDegree(visitDensity.nside());
+}
+
+void MainWindow::updateSpectrumDegreeLimit()
+{
+    const int limit = spectrumDegreeLimit();
+    spectrumDegreeValidator->setTop(limit);
+    spectrumDegreeEdit->setToolTip(QString("Наибольшая степень ℓ: на сетке HEALPix nside = %1 не больше %2 (2.5·nside)")
+                                       .arg(visitDensity.nside()).arg(limit));
+    if (spectrumDegreeEdit->text().toInt() > limit) spectrumDegreeEdit->setText(QString::number(limit));
+}
 
-    if (!spherePoint.isNull() && sphereWidget) {
-        // Обновляем точку на сфере
-        sphereWidget->setPoint(spherePoint);
+void MainWindow::analyzeSpectrum()
+{
+    bool ok;
+    int degree = spectrumDegreeEdit->text().toInt(&ok);
+    if (!ok || degree < 0) {
+        spectrumStatusLabel->setText("spectrum: invalid degree");
+        return;
+    }
+    const int limit = spectrumDegreeLimit();
+    if (degree > limit) {
+        spectrumStatusLabel->setText(QString("spectrum: ℓmax is at most %1 on this grid").arg(limit));
+        return;
+    }
 
-        // Добавляем в траекторию если включено отображение
-        if (showTrajectoryCheckbox && showTrajectoryCheckbox->isChecked()) {
-            sphereWidget->addToTrajectory(spherePoint);
+    // Плотность - относительно равномерной, потенциал - в логарифме (у соударений Ũ → ∞);
+    // оба - по пикселям HEALPix. Карта потенциала нужна только для шкалы раскраски
+    const int source = spectrumSourceCombo->currentIndex();
+    const Healpix& grid = visitDensity.grid();
+    QVector<double> values;
+    std::shared_ptr<const ShapePotentialMap> map;
+    if (source == 0) {
+        updateVisitDensity();
+        if (visitDensity.isEmpty()) {
+            spectrumStatusLabel->setText("spectrum: no visits yet - run the animation");
+            return;
         }
+        values = visitDensity.relativeDensity();
+    } else {
+        map = potentialRunner ? potentialRunner->result() : nullptr;
+        if (!map || map->masses != scene->getMasses()) {
+            spectrumStatusLabel->setText("spectrum: no potential map - enable Shape potential");
+            return;
+        }
+        values.resize(grid.pixelCount());
+        const QList<double> masses = map->masses;
+        parallelFor(0, grid.ringCount(), [&](int r) {
+            const Healpix::Ring ring = grid.ring(r);
+            for (int i = 0; i < ring.count; ++i) {
+                values[ring.first + i] = std::log(ShapePotentialRunner::potentialAt(Healpix::center(ring, i), masses));
+            }
+        }, 8);
+    }
 
-        // Обновляем label
-        if (sphereCoordsLabel) {
-            sphereCoordsLabel->setText(QString("Sphere point: (%1, %2, %3)")
-                                           .arg(spherePoint.x(), 0, 'f', 3)
-                                           .arg(spherePoint.y(), 0, 'f', 3)
-                                           .arg(spherePoint.z(), 0, 'f', 3));
+    QElapsedTimer timer;
+    timer.start();
+    SphericalSpectrum spectrum;
+    QVector<double> smooth;
+    try {
+        spectrum = SphericalHarmonics::analyze(values, grid, degree);
+        if (spectrum.isValid() && spectrumSmoothCheckbox->isChecked()) {
+            // Гладкая карта - сразу на сетке текстуры
+            smooth = source == 0
+                ? SphericalHarmonics::synthesize(spectrum, ShapeHistogram::TextureWidth, ShapeHistogram::TextureHeight)
+                : SphericalHarmonics::synthesize(spectrum, map->width, map->height);
         }
     }
+    catch (const std::exception& e) {
+        qWarning() << "Exception in analyzeSpectrum:" << e.what();
+        return;
+    }
+    if (!spectrum.isValid()) {
+        spectrumStatusLabel->setText("spectrum: grid too small");
+        return;
+    }
 
-    updatePointCoordinates();
+    // Cℓ/C0 первых степеней; полный спектр - во всплывающей подсказке
+    const QVector<double> power = spectrum.power();
+    QStringList shown, all;
+    for (int l = 1; l < power.size(); ++l) {
+        const QString entry = QString("%1").arg(power[0] > 0 ? power[l] / power[0] : 0.0, 0, 'e', 2);
+        all << QString("C%1/C0 = %2").arg(l).arg(entry);
+        if (l <= 6) shown << entry;
+    }
+    QString text = QString("ℓmax %1: Cℓ/C0 = %2").arg(spectrum.degree).arg(shown.join(' '));
+    if (previousSpectrumSource == source && previousSpectrum.isValid()) {
+        text += QString("; Δ vs previous %1").arg(spectrum.distance(previousSpectrum), 0, 'f', 3);
+    }
+    spectrumStatusLabel->setText(text + QString(" (%1 ms)").arg(timer.elapsed()));
+    spectrumStatusLabel->setToolTip(all.join('\n'));
+    previousSpectrum = spectrum;
+    previousSpectrumSource = source;
+
+    if (smooth.isEmpty()) return;
+    if (source == 0) {
+        showOverlay(Overlay::Spectrum, ShapeHistogram::paint(smooth, ShapeHistogram::TextureWidth,
+                                                             ShapeHistogram::TextureHeight));
+    } else {
+        QVector<float> potential(smooth.size());
+        for (int k = 0; k < smooth.size(); ++k) potential[k] = float(std::exp(smooth[k]));
+        showOverlay(Overlay::Spectrum, ShapePotentialRunner::paint(potential, map->width, map->height,
+                                                                   map->minimum, map->maximum));
+    }
+}
+
+void MainWindow::startMonteCarlo()
+{
+    if (!monteCarlo) return;
+
+    if (monteCarloButton->text() == "Cancel") {
+        monteCarlo->cancel();
+        monteCarloButton->setText("Run Monte Carlo");
+        monteCarloStatusLabel->setText("Monte Carlo: cancelled");
+        return;
+    }
+
+    bool ok1 = false, ok2 = false;
+    quint64 samples = monteCarloSamplesEdit->text().toULongLong(&ok1);
+    quint64 seed = monteCarloSeedEdit->text().toULongLong(&ok2);
+    if (!ok1 || !ok2 || samples == 0) {
+        QMessageBox::warning(this, "Invalid Input", "Please enter a positive number of triangles and an integer seed.");
+        return;
+    }
+
+    MonteCarloOptions options;
+    options.measure = static_cast<MonteCarloOptions::Measure>(monteCarloMeasureCombo->currentData().toInt());
+    options.masses = scene->getMasses();
+    options.samples = samples;
+    options.seed = seed;
+
+    monteCarlo->launch(options);
+    monteCarloButton->setText("Cancel");
+    monteCarloStatusLabel->setText(QString("Monte Carlo: %1 triangles...").arg(samples));
+}
+
+void MainWindow::showMonteCarloResult()
+{
+    if (!monteCarlo) return;
+
+    std::shared_ptr<const MonteCarloResult> result = monteCarlo->result();
+    if (!result || result->samples == 0) return;
+
+    auto interval = [](const MonteCarloProportion& p) {
+        return QString("%1 [%2, %3]").arg(p.estimate, 0, 'f', 5).arg(p.low, 0, 'f', 5).arg(p.high, 0, 'f', 5);
+    };
+    const double rate = result->elapsedMs > 0 ? result->samples / (result->elapsedMs * 1000.0) : 0.0;
+    monteCarloStatusLabel->setText(QString("P(obtuse) = %1; at 1/2/3: %2 %3 %4; ξ3 > 0: %5 (%6 M/s)")
+                                       .arg(interval(result->obtuse))
+                                       .arg(result->obtuseAt[0].estimate, 0, 'f', 4)
+                                       .arg(result->obtuseAt[1].estimate, 0, 'f', 4)
+                                       .arg(result->obtuseAt[2].estimate, 0, 'f', 4)
+                                       .arg(result->positive.estimate, 0, 'f', 4)
+                                       .arg(rate, 0, 'f', 1));
+    monteCarloStatusLabel->setToolTip(QString("obtuse at 1: %1\nobtuse at 2: %2\nobtuse at 3: %3\n"
+                                              "acute: %4\nξ3 > 0: %5\ndegenerate: %6 of %7")
+                                          .arg(interval(result->obtuseAt[0]))
+                                          .arg(interval(result->obtuseAt[1]))
+                                          .arg(interval(result->obtuseAt[2]))
+                                          .arg(interval(result->acute))
+                                          .arg(interval(result->positive))
+                                          .arg(result->degenerate)
+                                          .arg(result->samples + result->degenerate));
+
+    showOverlay(Overlay::MonteCarlo, result->density.paint());
+}
+
+void MainWindow::startPoincareSection()
+{
+    if (!poincareRunner) return;
+
+    if (sectionButton->text() == "Cancel") {
+        poincareRunner->cancel();
+        sectionButton->setText("Run Section");
+        sectionStatusLabel->setText("section: cancelled");
+        return;
+    }
+
+    bool ok1 = false, ok2 = false, ok3 = false;
+    double energy = sectionEnergyEdit->text().replace(',', '.').toDouble(&ok1);
+    double momentum = sectionMomentumEdit->text().replace(',', '.').toDouble(&ok2);
+    int points = sectionPointsEdit->text().toInt(&ok3);
+    if (!ok1 || !ok2 || !ok3 || energy >= 0 || momentum < 0 || points <= 0) {
+        QMessageBox::warning(this, "Invalid Input", "The section needs a negative energy, a non-negative angular momentum and a point count.");
+        return;
+    }
+
+    PoincareOptions options;
+    options.masses = scene->getMasses();
+    options.energy = energy;
+    options.angularMomentum = momentum;
+    options.normal = sectionCombo->currentData().value<QVector3D>();
+    options.targetPoints = points;
+
+    clearPoincareSection();
+    complexPlaneView1->setScatterLabels("ψ/π", "v∥");
+    poincareRunner->launch(options);
+    sectionButton->setText("Cancel");
+    sectionStatusLabel->setText("section: 0%");
+}
+
+void MainWindow::drainPoincarePoints()
+{
+    QVector<QPointF> points;
+    if (poincareRunner && poincareRunner->takePoints(points)) {
+        complexPlaneView1->appendScatter(points.constData(), points.size());
+    }
+}
+
+void MainWindow::clearPoincareSection()
+{
+    if (!poincareRunner) return;
+
+    poincareRunner->cancel();
+    QVector<QPointF> stale;
+    poincareRunner->takePoints(stale);
+    sectionButton->setText("Run Section");
+    sectionStatusLabel->clear();
+    complexPlaneView1->clearScatter();
+}
+
+void MainWindow::loadPositionTable()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Load Position Table", "",
+                                                    "Tables (*.csv *.txt *.dat *.bin);;All Files (*)");
+    if (fileName.isEmpty()) return;
+
+    // Многогигабайтная таблица читается в отдельном потоке, чтобы не блокировать окно
+    auto result = std::make_shared<std::shared_ptr<TabulatedSource>>();
+    auto error = std::make_shared<QString>();
+    QThread* loader = QThread::create([fileName, result, error]() {
+        *result = TabulatedSource::load(fileName, error.get());
+    });
+    loader->setParent(this);
+    tableLoader = loader;
+
+    loadTableButton->setEnabled(false);
+    statusBar()->showMessage("Loading table " + fileName + "...");
+
+    connect(loader, &QThread::finished, this, [this, loader, fileName, result, error]() {
+        loader->deleteLater();
+        if (tableLoader == loader) tableLoader = nullptr;
+        loadTableButton->setEnabled(isAnimationMode);
+
+        std::shared_ptr<TabulatedSource> table = *result;
+        if (!table) {
+            statusBar()->clearMessage();
+            QMessageBox::warning(this, "Load Table", *error);
+            return;
+        }
+
+        closeReplay();
+        if (isAnimationRunning) onAnimationToggle();
+
+        // Функции больше не описывают движение
+        x1Func.clear(); y1Func.clear(); x2Func.clear();
+        y2Func.clear(); x3Func.clear(); y3Func.clear();
+
+        // Анимация идёт с t = 0 и охватывает всю таблицу; если таблица начинается
+        // позже, до её первого момента тела стоят в положениях первой строки
+        maxTime = qMax(table->endTime(), 1e-3);
+        maxTimeEdit->setText(QString::number(maxTime));
+        if (simulationWorker) simulationWorker->setMaxTime(maxTime);
+        setPositionSource(table);
+
+        animationToggleButton->setEnabled(true);
+        animationResetButton->setEnabled(true);
+        timeSlider->setEnabled(true);
+        currentTime = 0.0;
+        timeSlider->setValue(0);
+        evaluateFunctions(currentTime);
+
+        statusBar()->showMessage(QString("Table %1: %2 rows, t = %3..%4, %5 lines skipped")
+                                     .arg(fileName)
+                                     .arg(table->sampleCount())
+                                     .arg(table->startTime(), 0, 'f', 2)
+                                     .arg(table->endTime(), 0, 'f', 2)
+                                     .arg(table->skippedLines()), 10000);
+    });
+    loader->start();
+}
+
+void MainWindow::rebuildTimeline()
+{
+    if (!timelineCache) return;
+    if (loadTimelineButton) loadTimelineButton->setEnabled(false);
+
+    if (!positionSource || !scene) {
+        timelineCache->invalidate();
+        if (timelineStatusLabel) timelineStatusLabel->clear();
+        return;
+    }
+    timelineCache->rebuild(positionSource, scene->getMasses(), maxTime, timelineResolution);
 }
 
 void MainWindow::fixMaxTimeInput()
@@ -1128,6 +2529,15 @@ void MainWindow::fixMaxTimeInput()
         text = text.left(firstDot + 1) + text.mid(firstDot + 1).remove('.');
     }
     maxTimeEdit->setText(text);
+
+    bool ok;
+    double value = text.toDouble(&ok);
+    double newMaxTime = (ok && value > 0) ? value : 20.0;
+    if (newMaxTime == maxTime) return;
+
+    maxTime = newMaxTime;
+    if (simulationWorker) simulationWorker->setMaxTime(maxTime);
+    rebuildTimeline();
 }
 
 void MainWindow::fixSpeedInput()
@@ -1142,6 +2552,11 @@ void MainWindow::fixSpeedInput()
         text = text.left(firstDot + 1) + text.mid(firstDot + 1).remove('.');
     }
     speedEdit->setText(text);
+
+    bool ok;
+    double value = text.toDouble(&ok);
+    speedFactor = (ok && value > 0) ? value : 1.0;
+    if (simulationWorker) simulationWorker->setSpeed(speedFactor);
 }
 
 void MainWindow::autoScaleTriangleView() {
@@ -1200,20 +2615,58 @@ void MainWindow::autoScaleTriangleView() {
 
 void MainWindow::onAnimationToggle()
 {
-    if (!animationTimer) {
-        qWarning() << "Animation timer is null";
+    if (!simulationWorker) {
+        qWarning() << "Simulation worker is null";
         return;
     }
 
     if (!isAnimationRunning) {
-        // Запускаем анимацию
-        animationTimer->start();
+        // Запуск анимации закрывает воспроизводимую запись
+        if (replay) {
+            closeReplay();
+            currentTime = (timeSlider->value() / double(SliderResolution)) * maxTime;
+        }
+
+        // Запускаем анимацию с текущего момента
+        simulationWorker->setMasses(scene->getMasses());
+        simulationWorker->setTime(currentTime);
+        simulationWorker->setPlaying(true);
         isAnimationRunning = true;
         if (animationToggleButton) animationToggleButton->setText("Pause");
+
+        // Первый кадр запускает цепочку frameSwapped -> update()
+        if (sphereWidget) sphereWidget->update();
     } else {
-        // Останавливаем анимацию
-        animationTimer->stop();
+        // Останавливаем анимацию, дорисовав уже готовые выборки
+        simulationWorker->setPlaying(false);
+        updateAnimation();
         isAnimationRunning = false;
         if (animationToggleButton) animationToggleButton->setText("Start");
     }
 }
+
+void MainWindow::setOpenGLViewports(bool enabled)
+{
+    if (view) view->setOpenGLViewport(enabled);
+    if (complexPlaneView1) complexPlaneView1->setOpenGLViewport(enabled);
+    if (complexPlaneView2) complexPlaneView2->setOpenGLViewport(enabled);
+    updateFrameStats();
+}
+
+void MainWindow::updateFrameStats()
+{
+    if (!frameStatsLabel || !view || !complexPlaneView1 || !complexPlaneView2) return;
+
+    QStringList parts;
+    const AcceleratedGraphicsView::Backend backends[2] = {
+        AcceleratedGraphicsView::Raster, AcceleratedGraphicsView::OpenGL
+    };
+    for (AcceleratedGraphicsView::Backend backend : backends) {
+        parts << QString("%1: triangle %2 | ξ %3 | z %4")
+                     .arg(AcceleratedGraphicsView::backendName(backend))
+                     .arg(view->frameStats(backend).toString())
+                     .arg(complexPlaneView1->frameStats(backend).toString())
+                     .arg(complexPlaneView2->frameStats(backend).toString());
+    }
+    frameStatsLabel->setText(parts.join("   "));
+}
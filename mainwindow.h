@@ -13,13 +13,33 @@
 #include <QTimer>
 #include <QSlider>
 #include <QGroupBox>
+#include <QThread>
 #include <atomic>
-#include <mutex>
+#include <memory>
 #include "trianglescene.h"
 #include "spherewidget.h"
 #include "complexplaneview.h"
 #include "complexplaneview2.h"
+#include "acceleratedgraphicsview.h"
+#include "shapestate.h"
+#include "updatescheduler.h"
+#include "simulationworker.h"
+#include "positionsource.h"
+#include "timelinecache.h"
+#include "trajectoryrecording.h"
+#include "threebodysource.h"
+#include "periodicorbit.h"
+#include "periodicsource.h"
+#include "ensemble.h"
+#include "poincaresection.h"
+#include "ftlemap.h"
+#include "shapepotential.h"
+#include "geodesicfan.h"
+#include "shapehistogram.h"
+#include "sphericalharmonics.h"
+#include "trianglemontecarlo.h"
 #include <QCheckBox>
+#include <QComboBox>
 
 class MainWindow : public QMainWindow
 {
@@ -46,7 +66,10 @@ private slots:
     void onAnimationReset();
     void onTimeSliderChanged(int value);
     void updateAnimation();
+    void onSphereFrameSwapped();
     void updateTimeLabel();
+    void setOpenGLViewports(bool enabled);
+    void updateFrameStats();
 
 private:
     double calculateTriangleSize(const QList<QPointF>& points);
@@ -54,8 +77,21 @@ private:
     // Инициализируем все указатели nullptr
     QLabel* equilateralPointsLabel = nullptr;
     QCheckBox* showTrajectoryCheckbox = nullptr;
+    QCheckBox* threadedPlanesCheckbox = nullptr;
+    QCheckBox* openGLViewportsCheckbox = nullptr;
+    QLabel* frameStatsLabel = nullptr;
+    QTimer* frameStatsTimer = nullptr;
+    QLabel* schedulerStatsLabel = nullptr;
+
+    // Планировщик обновлений и номера его этапов
+    UpdateScheduler* updateScheduler = nullptr;
+    int geometryStage = -1;
+    int coordinatesStage = -1;
+    int shapeStage = -1;
     QLineEdit* maxTimeEdit = nullptr;
     QLineEdit* speedEdit = nullptr;
+    QLineEdit* sampleRateEdit = nullptr;
+    QLineEdit* timelineResolutionEdit = nullptr;
 
     QSplitter* mainSplitter = nullptr;
     QSplitter* rightSplitter = nullptr;
@@ -63,7 +99,7 @@ private:
     SphereWidget* sphereWidget = nullptr;
     ComplexPlaneView* complexPlaneView1 = nullptr;
     ComplexPlaneView2* complexPlaneView2 = nullptr;
-    QGraphicsView* view = nullptr;
+    AcceleratedGraphicsView* view = nullptr;
     TriangleScene* scene = nullptr;
     QLabel* sphereCoordsLabel = nullptr;
     QLabel* coordsLabel = nullptr;
@@ -74,7 +110,6 @@ private:
     QVector3D lastSpherePoint;
     const double updateThreshold = 0.001;
 
-    std::mutex updateMutex;
     bool updatingFromTriangle = false;
     bool updatingFromSphere = false;
 
@@ -94,20 +129,167 @@ private:
     QPushButton* animationModeButton = nullptr;
     QPushButton* animationToggleButton = nullptr;
     QPushButton* animationResetButton = nullptr;
+    QPushButton* loadTimelineButton = nullptr;
+    QPushButton* loadTableButton = nullptr;
+    QThread* tableLoader = nullptr;     // поток чтения таблицы, пока идёт загрузка
+    QPushButton* threeBodyButton = nullptr;
+    QComboBox* threeBodyPresetCombo = nullptr;
+    QComboBox* integratorCombo = nullptr;
+    QLineEdit* integratorStepEdit = nullptr;
+    QPushButton* recordButton = nullptr;
+    QPushButton* openRecordingButton = nullptr;
     QSlider* timeSlider = nullptr;
-    QTimer* animationTimer = nullptr;
+
+    // Поток симуляции и источник положений тел
+    SimulationWorker* simulationWorker = nullptr;
+    std::shared_ptr<const PositionSource> positionSource;
+    QLabel* simulationStatsLabel = nullptr;
+    QLabel* syzygyLabel = nullptr;
+    QLabel* shapeEventsLabel = nullptr;
+    QByteArray syzygySequence;  // символы '1'..'3' - тело посередине, по порядку
+    quint64 syzygyEpoch = 0;
+    double lastSyzygyTime = 0.0;
+    QLabel* threeBodyStatsLabel = nullptr;
+    std::shared_ptr<const ThreeBodySource> threeBodySource; // для контроля сохранения
+
+    // Поиск периодических орбит стрельбой
+    PeriodicOrbitFinder* orbitFinder = nullptr;
+    QComboBox* orbitSeedCombo = nullptr;
+    QLineEdit* orbitPeriodEdit = nullptr;
+    QLineEdit* orbitMassEdit = nullptr;
+    QPushButton* orbitButton = nullptr;
+    QPushButton* saveOrbitButton = nullptr;
+    QLabel* orbitStatusLabel = nullptr;
+    std::shared_ptr<const PeriodicOrbitSource> periodicSource; // текущая орбита для сохранения
+    QPointF lastTrailTolerance; // (угол на сфере, шаг ζ), переданные потоку
+    TrajectoryBatch frameTrail;  // выборки текущего кадра, переиспользуемые буферы
+
+    // Предвычисленная шкала времени для перемотки слайдером
+    TimelineCache* timelineCache = nullptr;
+    QLabel* timelineStatusLabel = nullptr;
+    int timelineResolution = 20000;
+    static constexpr int SliderResolution = 10000;
+    static constexpr int MaxSyzygySymbols = 65536;
+
+    // Карта поверх сферы одна на всех; перерисовывает её только текущий владелец
+    enum class Overlay { None, Ensemble, Ftle, VisitDensity, Spectrum, MonteCarlo };
+    Overlay overlayOwner = Overlay::None;
+
+    // Ансамбль свободного падения: карта исходов поверх сферы
+    EnsembleRunner* ensembleRunner = nullptr;
+    QComboBox* ensembleModeCombo = nullptr;
+    QLineEdit* ensembleResolutionEdit = nullptr;
+    QLineEdit* ensembleTimeEdit = nullptr;
+    QPushButton* ensembleButton = nullptr;
+    QPushButton* clearEnsembleButton = nullptr;
+    QLabel* ensembleStatusLabel = nullptr;
+
+    // Карта показателей Ляпунова на той же сетке, что и ансамбль
+    FtleRunner* ftleRunner = nullptr;
+    QLineEdit* ftleHorizonEdit = nullptr;
+    QPushButton* ftleButton = nullptr;
+    QLabel* ftleStatusLabel = nullptr;
+
+    // Сечение Пуанкаре: россыпь точек в исходной комплексной плоскости
+    PoincareRunner* poincareRunner = nullptr;
+    QComboBox* sectionCombo = nullptr;
+    QLineEdit* sectionEnergyEdit = nullptr;
+    QLineEdit* sectionMomentumEdit = nullptr;
+    QLineEdit* sectionPointsEdit = nullptr;
+    QPushButton* sectionButton = nullptr;
+    QPushButton* clearSectionButton = nullptr;
+    QLabel* sectionStatusLabel = nullptr;
+
+    // Потенциал формы Ũ на сфере и граница области Хилла для E, L сечения
+    ShapePotentialRunner* potentialRunner = nullptr;
+    QCheckBox* potentialCheckbox = nullptr;
+    QLabel* potentialStatusLabel = nullptr;
+
+    // Веер геодезических метрики Якоби из точки, выбранной на сфере
+    QCheckBox* geodesicCheckbox = nullptr;
+    QLineEdit* geodesicDirectionsEdit = nullptr;
+    QLineEdit* geodesicLengthEdit = nullptr;
+    QLabel* geodesicStatusLabel = nullptr;
+
+    // Плотность посещений сферы за весь прогон (карта поверх сферы)
+    ShapeHistogram visitDensity;
+    QCheckBox* densityCheckbox = nullptr;
+    QPushButton* clearDensityButton = nullptr;
+    QLabel* densityStatusLabel = nullptr;
+
+    // Спектр мощности плотности или потенциала; предыдущий - для сравнения прогонов
+    QComboBox* spectrumSourceCombo = nullptr;
+    QLineEdit* spectrumDegreeEdit = nullptr;
+    QIntValidator* spectrumDegreeValidator = nullptr;
+    QCheckBox* spectrumSmoothCheckbox = nullptr;
+    QPushButton* spectrumButton = nullptr;
+    QLabel* spectrumStatusLabel = nullptr;
+    SphericalSpectrum previousSpectrum;
+    int previousSpectrumSource = -1;
+
+    // Монте-Карло случайных треугольников: доли тупоугольных и плотность на сфере
+    TriangleMonteCarlo* monteCarlo = nullptr;
+    QComboBox* monteCarloMeasureCombo = nullptr;
+    QLineEdit* monteCarloSamplesEdit = nullptr;
+    QLineEdit* monteCarloSeedEdit = nullptr;
+    QPushButton* monteCarloButton = nullptr;
+    QLabel* monteCarloStatusLabel = nullptr;
+
+    // Открытая запись: слайдер перематывает её, а не симуляцию
+    std::shared_ptr<TrajectoryReplay> replay;
 
     // Переменные анимации
     bool isAnimationMode = false;
     bool isAnimationRunning = false;
     double currentTime = 0.0;
-    double timeStep = 0.1;
-    double maxTime = 10.0;
+    // Параметры кэшируются при подтверждении ввода, а не читаются каждый кадр
+    double maxTime = 20.0;
+    double speedFactor = 1.0;
 
     QString x1Func, y1Func, x2Func, y2Func, x3Func, y3Func;
 
     void evaluateFunctions(double t);
-    double evaluateExpression(const QString& expression, double t);
+    void setPositionFunctions(const QStringList& functions);
+    void setPositionSource(std::shared_ptr<const PositionSource> source);
+    void loadPositionTable();
+    void startThreeBody();
+    void updateThreeBodyStats();
+    void startOrbitSearch();
+    void showPeriodicOrbit();
+    void saveOrbit();
+    void showOverlay(Overlay owner, const QImage& image);
+    void clearOverlay();
+    void startEnsemble();
+    void showEnsembleResult();
+    void clearEnsemble();
+    void startFtle();
+    void showFtleResult();
+    void startPoincareSection();
+    void drainPoincarePoints();
+    void clearPoincareSection();
+    void requestShapePotential();
+    void showShapePotential();
+    void updateHillBoundary();
+    QVector<QVector3D> hillBoundary(const ShapePotentialMap& map) const;
+    void showGeodesicFan(const QVector3D& start);
+    void updateVisitDensity();
+    void clearVisitDensity();
+    int spectrumDegreeLimit() const;
+    void updateSpectrumDegreeLimit();
+    void analyzeSpectrum();
+    void startMonteCarlo();
+    void showMonteCarloResult();
+    void rebuildTimeline();
+    void updateTrailTolerance();
+    void applyShapeState(const ShapeState& state, bool appendSphereTrajectory);
+    void showShapeState(const ShapeState& state);
+    void appendShapeTrajectory(const ShapeState& state, bool includeSphere);
+    void appendTrajectoryBatch(const TrajectoryBatch& batch, bool replace);
+    void loadTimelineTrajectory();
+    void setRecording(bool enabled);
+    void openRecording();
+    void closeReplay();
+    void showTrianglePoints(const QPointF points[3]);
     void autoScaleTriangleView();
     void onAnimationToggle(); // Переносим объявление сюда
 };
@@ -0,0 +1,73 @@
+#include "masssystem.h"
+#include <cmath>
+#include <limits>
+
+MassSystem MassSystem::fromMasses(const QList<double>& masses)
+{
+    MassSystem system;
+    if (masses.size() != 3) return system;
+    for (double m : masses) {
+        if (!(m > 0) || !std::isfinite(m)) return system;
+    }
+
+    system.m1 = masses[0];
+    system.m2 = masses[1];
+    system.m3 = masses[2];
+    const double m12 = system.m1 + system.m2;
+    system.mu1 = system.m1 * system.m2 / m12;
+    system.mu2 = system.m3 * m12 / (m12 + system.m3);
+    system.k = (system.m1 / m12) * std::sqrt(system.mu2 / system.mu1);
+
+    // r13 = q2 + a·q1, r23 = q2 - b·q1
+    const double a = system.m2 / m12;
+    const double b = system.m1 / m12;
+
+    // |q1|², |q2|² и q1·q2 как аффинные функции ξ
+    const Plane q11{0.5 / system.mu1, 0.5 / system.mu1, 0.0};
+    const Plane q22{0.5 / system.mu2, -0.5 / system.mu2, 0.0};
+    const Plane q12{0.0, 0.0, 0.5 / std::sqrt(system.mu1 * system.mu2)};
+
+    auto combine = [](double x, const Plane& p, double y, const Plane& q, double z, const Plane& r) {
+        return Plane{x * p.c0 + y * q.c0 + z * r.c0,
+                     x * p.c1 + y * q.c1 + z * r.c1,
+                     x * p.c2 + y * q.c2 + z * r.c2};
+    };
+
+    // Вершина 1: r12·r13; вершина 2: r21·r23; вершина 3: r31·r32
+    system.rightAngle[0] = combine(a, q11, 0.0, q22, 1.0, q12);
+    system.rightAngle[1] = combine(b, q11, 0.0, q22, -1.0, q12);
+    system.rightAngle[2] = combine(-a * b, q11, 1.0, q22, a - b, q12);
+
+    // |r12|² = |q1|², |r13|² = |q2|² + a²|q1|² + 2a q1·q2, |r23|² = |q2|² + b²|q1|² - 2b q1·q2
+    system.isosceles[0] = combine(1.0 - a * a, q11, -1.0, q22, -2.0 * a, q12);
+    system.isosceles[1] = combine(1.0 - b * b, q11, -1.0, q22, 2.0 * b, q12);
+    system.isosceles[2] = combine(a * a - b * b, q11, 0.0, q22, 2.0 * (a + b), q12);
+
+    system.sideSquared[0] = q11;
+    system.sideSquared[1] = combine(a * a, q11, 1.0, q22, 2.0 * a, q12);
+    system.sideSquared[2] = combine(b * b, q11, 1.0, q22, -2.0 * b, q12);
+
+    system.valid = true;
+    return system;
+}
+
+int MassSystem::obtuseVertex(const QVector3D& p) const
+{
+    // Тупым может быть только один угол
+    for (int i = 0; i < 3; ++i) {
+        if (rightAngle[i].at(p) < 0) return i;
+    }
+    return -1;
+}
+
+double MassSystem::shapePotential(const QVector3D& p) const
+{
+    const double weight[3] = {m1 * m2, m1 * m3, m2 * m3};
+    double u = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        const double side = sideSquared[i].at(p);
+        if (!(side > 0)) return std::numeric_limits<double>::infinity();
+        u += weight[i] / std::sqrt(side);
+    }
+    return u;
+}
@@ -0,0 +1,51 @@
+#ifndef MASSSYSTEM_H
+#define MASSSYSTEM_H
+
+#include <QList>
+#include <QVector3D>
+
+// Постоянные системы масс, от которых зависят особые кривые на сфере форм.
+// Вычисляются один раз при смене масс.
+//
+// В координатах Якоби q1 = r2 - r1, q2 = r3 - ц.м.(r1, r2) на единичной сфере
+//   μ1|q1|² = (1 + ξ1)/2,  μ2|q2|² = (1 - ξ1)/2,  2√(μ1μ2) q1·q2 = ξ2,
+// поэтому скалярные произведения сторон и разности квадратов сторон - аффинные
+// функции ξ: прямоугольные и равнобедренные треугольники лежат на плоских
+// сечениях сферы, а проверка стороны - три умножения.
+struct MassSystem {
+    // g(ξ) = c0 + c1·ξ1 + c2·ξ2 на единичной сфере (для |ξ| = R: c0·R + ...)
+    struct Plane {
+        double c0 = 0.0;
+        double c1 = 0.0;
+        double c2 = 0.0;
+
+        // Точка сферы в порядке SphereWidget: (ξ2, ξ3, ξ1)
+        double at(const QVector3D& p) const { return c0 + c1 * p.z() + c2 * p.x(); }
+        double at(double radius, double xi1, double xi2) const { return c0 * radius + c1 * xi1 + c2 * xi2; }
+    };
+
+    double m1 = 1.0, m2 = 1.0, m3 = 1.0;
+    double mu1 = 0.5;       // приведённая масса пары (1, 2)
+    double mu2 = 2.0 / 3.0; // приведённая масса тела 3 и пары
+    double k = 0.0;         // параметр прямоугольных окружностей (m1/(m1+m2))·√(μ2/μ1)
+    bool valid = false;
+
+    // Скалярное произведение сторон при вершине i (с точностью до множителя R);
+    // < 0 - угол при вершине i тупой
+    Plane rightAngle[3];
+    // Разность квадратов сторон, сходящихся в вершине i: 0 - |r12|²-|r13|²,
+    // 1 - |r12|²-|r23|², 2 - |r13|²-|r23|²; ноль - треугольник равнобедренный
+    Plane isosceles[3];
+    // Квадраты сторон на единичной сфере (I = 1): 0 - |r12|², 1 - |r13|², 2 - |r23|²
+    Plane sideSquared[3];
+
+    static MassSystem fromMasses(const QList<double>& masses);
+
+    // Вершина с тупым углом или -1, если треугольник остроугольный
+    int obtuseVertex(const QVector3D& p) const;
+
+    // Потенциал формы Ũ = U·√I в точке единичной сферы; +∞ в точке соударения
+    double shapePotential(const QVector3D& p) const;
+};
+
+#endif // MASSSYSTEM_H
@@ -0,0 +1,99 @@
+#include "mathparser.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace MathParser {
+
+double evaluate(const QString& expression, double t) {
+    if (expression.isEmpty()) return 0.0;
+
+    QString expr = expression;
+    expr = expr.replace("t", QString::number(t, 'f', 6));
+    expr = expr.replace("pi", "3.14159265358979323846");
+    expr = expr.replace("e", "2.71828182845904523536");
+
+    // Добавляем поддержку математических констант из ваших уравнений
+    expr = expr.replace("0.8660254", "0.8660254037844386"); // sqrt(3)/2
+
+    // Упрощённая замена функций
+    expr = expr.replace("sin", "s");
+    expr = expr.replace("cos", "c");
+    expr = expr.replace("tan", "t");
+    expr = expr.replace("exp", "e");
+    expr = expr.replace("log", "l");
+    expr = expr.replace("sqrt", "q");
+
+    // Удаляем пробелы
+    expr = expr.remove(" ");
+
+    return evaluateExpression(expr);
+}
+
+double evaluateExpression(const QString& expr) {
+    try {
+        return parseExpression(expr);
+    } catch (const std::exception&) {
+        return 0.0;
+    }
+}
+
+double parseExpression(const QString& expr) {
+    int len = expr.length();
+    if (len == 0) return 0.0;
+
+    // Обработка скобок
+    if (expr[0] == '(' && expr[len-1] == ')') {
+        return parseExpression(expr.mid(1, len-2));
+    }
+
+    // Поиск операторов с низким приоритетом (+, -)
+    int parenCount = 0;
+    for (int i = len-1; i >= 0; --i) {
+        QChar c = expr[i];
+        if (c == ')') parenCount++;
+        else if (c == '(') parenCount--;
+
+        if (parenCount == 0 && (c == '+' || c == '-') && i > 0) {
+            double left = parseExpression(expr.left(i));
+            double right = parseExpression(expr.mid(i+1));
+            return (c == '+') ? left + right : left - right;
+        }
+    }
+
+    // Поиск операторов (*, /)
+    parenCount = 0;
+    for (int i = len-1; i >= 0; --i) {
+        QChar c = expr[i];
+        if (c == ')') parenCount++;
+        else if (c == '(') parenCount--;
+
+        if (parenCount == 0 && (c == '*' || c == '/') && i > 0) {
+            double left = parseExpression(expr.left(i));
+            double right = parseExpression(expr.mid(i+1));
+            if (c == '/' && right == 0.0) return 0.0; // Защита от деления на ноль
+            return (c == '*') ? left * right : left / right;
+        }
+    }
+
+    // Обработка функций
+    if (expr.length() > 1 && (expr[0] == 's' || expr[0] == 'c' || expr[0] == 't' ||
+                              expr[0] == 'e' || expr[0] == 'l' || expr[0] == 'q')) {
+        double arg = parseExpression(expr.mid(1));
+        switch (expr[0].toLatin1()) {
+        case 's': return std::sin(arg); // sin
+        case 'c': return std::cos(arg); // cos
+        case 't': return std::tan(arg); // tan
+        case 'e': return std::exp(arg); // exp
+        case 'l': return std::log(arg); // log
+        case 'q': return std::sqrt(arg); // sqrt
+        }
+    }
+
+    // Числа
+    bool ok;
+    double result = expr.toDouble(&ok);
+    if (ok) return result;
+
+    return 0.0;
+}
+} // namespace MathParser
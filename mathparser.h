@@ -0,0 +1,14 @@
+#ifndef MATHPARSER_H
+#define MATHPARSER_H
+
+#include <QString>
+
+// Простой математический парсер для функций положения x(t), y(t).
+// Не хранит состояния, поэтому может вызываться из любого потока.
+namespace MathParser {
+double evaluate(const QString& expression, double t);
+double evaluateExpression(const QString& expr);
+double parseExpression(const QString& expr);
+}
+
+#endif // MATHPARSER_H
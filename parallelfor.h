@@ -0,0 +1,62 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Параллельный цикл по [begin, end) на всех ядрах.
+// Индексы раздаются блоками по grain через общий атомарный счётчик,
+// поэтому неравномерная стоимость итераций балансируется сама.
+// body(i) вызывается ровно один раз для каждого i; функция возвращается,
+// когда все итерации завершены. Первое исключение из body пробрасывается.
+template <typename Body>
+void parallelFor(int begin, int end, Body body, int grain = 64)
+{
+    const int count = end - begin;
+    if (count <= 0) return;
+    grain = std::max(1, grain);
+
+    const int blocks = (count + grain - 1) / grain;
+    const int threads = std::max(1, std::min(QThread::idealThreadCount(), blocks));
+
+    std::atomic<int> next{begin};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        try {
+            forever {
+                const int start = next.fetch_add(grain, std::memory_order_relaxed);
+                if (start >= end) break;
+                const int stop = std::min(start + grain, end);
+                for (int i = start; i < stop; ++i) {
+                    body(i);
+                }
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            next.store(end, std::memory_order_relaxed); // остальные потоки заканчивают
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker(); // текущий поток тоже работает
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // PARALLELFOR_H
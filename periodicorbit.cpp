@@ -0,0 +1,461 @@
+#include "periodicorbit.h"
+#include "positionsource.h"
+#include "parallelfor.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double norm(const double* v, int n)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) sum += v[i] * v[i];
+    return std::sqrt(sum);
+}
+
+// Решение симметричной системы A x = b (Холецкий); false, если A не положительно определена
+bool solveSymmetric(double a[][PeriodicOrbitFinder::Unknowns], const double b[], double x[])
+{
+    constexpr int n = PeriodicOrbitFinder::Unknowns;
+    double l[n][n] = {};
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            double sum = a[i][j];
+            for (int k = 0; k < j; ++k) sum -= l[i][k] * l[j][k];
+            if (i == j) {
+                if (!(sum > 0)) return false;
+                l[i][i] = std::sqrt(sum);
+            } else {
+                l[i][j] = sum / l[j][j];
+            }
+        }
+    }
+    double y[n];
+    for (int i = 0; i < n; ++i) {
+        double sum = b[i];
+        for (int k = 0; k < i; ++k) sum -= l[i][k] * y[k];
+        y[i] = sum / l[i][i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double sum = y[i];
+        for (int k = i + 1; k < n; ++k) sum -= l[k][i] * x[k];
+        x[i] = sum / l[i][i];
+    }
+    return true;
+}
+
+}
+
+PeriodicOrbitFinder::PeriodicOrbitFinder(QObject* parent)
+    : QThread(parent)
+{
+}
+
+PeriodicOrbitFinder::~PeriodicOrbitFinder()
+{
+    stop();
+}
+
+void PeriodicOrbitFinder::launch(const PeriodicOrbitOptions& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.options = options;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+}
+
+void PeriodicOrbitFinder::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void PeriodicOrbitFinder::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+std::shared_ptr<const PeriodicOrbitResult> PeriodicOrbitFinder::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+bool PeriodicOrbitFinder::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+double PeriodicOrbitFinder::energy(const QList<double>& masses, const ThreeBodySystem::State& state)
+{
+    double kinetic = 0.0, potential = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        const double m = masses.value(i, 1.0);
+        kinetic += 0.5 * m * (state.v[2 * i] * state.v[2 * i] + state.v[2 * i + 1] * state.v[2 * i + 1]);
+        for (int j = i + 1; j < 3; ++j) {
+            potential -= m * masses.value(j, 1.0) /
+                         std::hypot(state.x[2 * j] - state.x[2 * i], state.x[2 * j + 1] - state.x[2 * i + 1]);
+        }
+    }
+    return kinetic + potential;
+}
+
+bool PeriodicOrbitFinder::flow(const QList<double>& masses, const ThreeBodySystem::State& initial,
+                               double period, int steps, ThreeBodySystem::State& final)
+{
+    if (!(period > 0) || steps <= 0) return false;
+
+    ThreeBodySystem system(masses, initial, ThreeBodySystem::Yoshida4, period / steps);
+    for (int i = 0; i < steps; ++i) {
+        system.advance();
+    }
+    final = system.state();
+    for (int k = 0; k < 6; ++k) {
+        if (!std::isfinite(final.x[k]) || !std::isfinite(final.v[k])) return false;
+    }
+    return true;
+}
+
+bool PeriodicOrbitFinder::seedFromSource(const PositionSource& source, double t, const QList<double>& masses,
+                                         ThreeBodySystem::State& seed)
+{
+    const double h = 1e-4;
+    QPointF before[3], at[3], after[3];
+    if (!source.positionsAt(t, at)) return false;
+    // У левого края (t = 0) разность односторонняя
+    const bool central = t >= h && source.positionsAt(t - h, before);
+    if (!source.positionsAt(t + h, after)) return false;
+
+    const double m[3] = {masses.value(0, 1.0), masses.value(1, 1.0), masses.value(2, 1.0)};
+    const double total = m[0] + m[1] + m[2];
+
+    seed = ThreeBodySystem::State();
+    for (int i = 0; i < 3; ++i) {
+        seed.x[2 * i] = at[i].x();
+        seed.x[2 * i + 1] = at[i].y();
+        const QPointF velocity = central ? (after[i] - before[i]) / (2 * h) : (after[i] - at[i]) / h;
+        seed.v[2 * i] = velocity.x();
+        seed.v[2 * i + 1] = velocity.y();
+    }
+    for (int axis = 0; axis < 2; ++axis) {
+        double position = 0.0, momentum = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            position += m[i] * seed.x[2 * i + axis] / total;
+            momentum += m[i] * seed.v[2 * i + axis] / total;
+        }
+        for (int i = 0; i < 3; ++i) {
+            seed.x[2 * i + axis] -= position;
+            seed.v[2 * i + axis] -= momentum;
+        }
+    }
+
+    // Растяжение λ (положения и скорости вместе, период тот же): K ~ λ², U ~ 1/λ,
+    // так что 2K = U при λ³ = U / 2K
+    double kinetic = 0.0, potential = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        kinetic += 0.5 * m[i] * (seed.v[2 * i] * seed.v[2 * i] + seed.v[2 * i + 1] * seed.v[2 * i + 1]);
+        for (int j = i + 1; j < 3; ++j) {
+            const double r = std::hypot(seed.x[2 * j] - seed.x[2 * i], seed.x[2 * j + 1] - seed.x[2 * i + 1]);
+            if (!(r > 0)) return false;
+            potential += m[i] * m[j] / r;
+        }
+    }
+    if (!(kinetic > 0)) return false;
+
+    const double scale = std::cbrt(potential / (2.0 * kinetic));
+    for (int k = 0; k < 6; ++k) {
+        seed.x[k] *= scale;
+        seed.v[k] *= scale;
+    }
+    return std::isfinite(scale);
+}
+
+void PeriodicOrbitFinder::toParameters(const ThreeBodySystem::State& state, double period, double p[Unknowns])
+{
+    for (int k = 0; k < 4; ++k) {
+        p[k] = state.x[k];
+        p[4 + k] = state.v[k];
+    }
+    p[8] = period;
+}
+
+ThreeBodySystem::State PeriodicOrbitFinder::fromParameters(const QList<double>& masses, const double p[Unknowns])
+{
+    const double m1 = masses.value(0, 1.0), m2 = masses.value(1, 1.0), m3 = masses.value(2, 1.0);
+
+    ThreeBodySystem::State state;
+    for (int k = 0; k < 4; ++k) {
+        state.x[k] = p[k];
+        state.v[k] = p[4 + k];
+    }
+    // Центр масс в начале координат, импульс нулевой
+    for (int axis = 0; axis < 2; ++axis) {
+        state.x[4 + axis] = -(m1 * p[axis] + m2 * p[2 + axis]) / m3;
+        state.v[4 + axis] = -(m1 * p[4 + axis] + m2 * p[6 + axis]) / m3;
+    }
+    return state;
+}
+
+bool PeriodicOrbitFinder::residual(const QList<double>& masses, const double p[Unknowns], double targetEnergy,
+                                   int steps, double r[Unknowns])
+{
+    const ThreeBodySystem::State initial = fromParameters(masses, p);
+    ThreeBodySystem::State final;
+    if (!flow(masses, initial, p[8], steps, final)) return false;
+
+    for (int k = 0; k < 4; ++k) {
+        r[k] = final.x[k] - p[k];
+        r[4 + k] = final.v[k] - p[4 + k];
+    }
+    r[8] = energy(masses, initial) - targetEnergy;
+    return true;
+}
+
+PeriodicOrbit PeriodicOrbitFinder::shoot(const QList<double>& masses, const double guess[Unknowns],
+                                         double targetEnergy, const PeriodicOrbitOptions& options,
+                                         int member, quint64 generation)
+{
+    constexpr int n = Unknowns;
+    constexpr int rows = Unknowns + 2; // + условия на фазу и поворот
+    const int steps = options.stepsPerPeriod;
+
+    PeriodicOrbit orbit;
+    orbit.masses = masses;
+
+    double p[n];
+    std::copy(guess, guess + n, p);
+
+    // Сдвиг по орбите и поворот переводят решение в решение. Запрещаем их
+    // условиями ⟨f, p - p0⟩ = 0 и ⟨R, p - p0⟩ = 0 (f - скорость потока,
+    // R - генератор поворота в точке приближения), иначе якобиан вырожден
+    // и шаг блуждает вдоль этих направлений.
+    double phase[n] = {}, rotation[n] = {};
+    {
+        const ThreeBodySystem::State state = fromParameters(masses, p);
+        double a[6] = {};
+        for (int i = 0; i < 3; ++i) {
+            for (int j = i + 1; j < 3; ++j) {
+                const double dx = state.x[2 * j] - state.x[2 * i];
+                const double dy = state.x[2 * j + 1] - state.x[2 * i + 1];
+                const double r2 = dx * dx + dy * dy;
+                const double inv = 1.0 / (r2 * std::sqrt(r2));
+                a[2 * i] += masses.value(j, 1.0) * dx * inv;
+                a[2 * i + 1] += masses.value(j, 1.0) * dy * inv;
+                a[2 * j] -= masses.value(i, 1.0) * dx * inv;
+                a[2 * j + 1] -= masses.value(i, 1.0) * dy * inv;
+            }
+        }
+        for (int k = 0; k < 4; ++k) {
+            phase[k] = p[4 + k];
+            phase[4 + k] = a[k];
+        }
+        for (int b = 0; b < 2; ++b) {
+            rotation[2 * b] = -p[2 * b + 1];
+            rotation[2 * b + 1] = p[2 * b];
+            rotation[4 + 2 * b] = -p[4 + 2 * b + 1];
+            rotation[4 + 2 * b + 1] = p[4 + 2 * b];
+        }
+        const double phaseNorm = norm(phase, n), rotationNorm = norm(rotation, n);
+        for (int k = 0; k < n; ++k) {
+            phase[k] = phaseNorm > 0 ? phase[k] / phaseNorm : 0.0;
+            rotation[k] = rotationNorm > 0 ? rotation[k] / rotationNorm : 0.0;
+        }
+    }
+
+    auto evaluate = [&](const double q[n], double r[rows]) {
+        if (!residual(masses, q, targetEnergy, steps, r)) return false;
+        r[n] = r[n + 1] = 0.0;
+        for (int k = 0; k < n; ++k) {
+            r[n] += phase[k] * (q[k] - guess[k]);
+            r[n + 1] += rotation[k] * (q[k] - guess[k]);
+        }
+        return true;
+    };
+
+    double r[rows];
+    if (!evaluate(p, r)) return orbit;
+    // Условия калибровки в меру сходимости не входят
+    double error = norm(r, n) / (1.0 + norm(p, n - 1));
+
+    double lambda = 1e-9;
+    for (int iteration = 1; iteration <= options.maxIterations && error > options.tolerance; ++iteration) {
+        if (isCancelled(generation)) return orbit;
+
+        // Столбцы якобиана центральными разностями: 2n независимых интегрирований
+        double delta[n];
+        for (int j = 0; j < n; ++j) delta[j] = 1e-6 * std::max(1.0, std::abs(p[j]));
+        double plus[n][n], minus[n][n];
+        std::atomic<bool> failed{false};
+        parallelFor(0, 2 * n, [&](int index) {
+            const int j = index / 2;
+            double q[n];
+            std::copy(p, p + n, q);
+            q[j] += (index % 2 == 0) ? delta[j] : -delta[j];
+            if (!residual(masses, q, targetEnergy, steps, (index % 2 == 0) ? plus[j] : minus[j])) {
+                failed = true;
+            }
+        }, 1);
+        if (failed) return orbit;
+
+        double jacobian[rows][n]; // jacobian[i][j] = ∂rᵢ/∂pⱼ
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                jacobian[i][j] = (plus[j][i] - minus[j][i]) / (2.0 * delta[j]);
+            }
+        }
+        std::copy(phase, phase + n, jacobian[n]);
+        std::copy(rotation, rotation + n, jacobian[n + 1]);
+
+        double normal[n][n], gradient[n];
+        for (int i = 0; i < n; ++i) {
+            gradient[i] = 0.0;
+            for (int k = 0; k < rows; ++k) gradient[i] += jacobian[k][i] * r[k];
+            for (int j = 0; j < n; ++j) {
+                double sum = 0.0;
+                for (int k = 0; k < rows; ++k) sum += jacobian[k][i] * jacobian[k][j];
+                normal[i][j] = sum;
+            }
+        }
+
+        // Демпфирование растёт, пока шаг не уменьшит невязку
+        bool accepted = false;
+        for (int attempt = 0; attempt < 12 && !accepted; ++attempt) {
+            double a[n][n], step[n], minusGradient[n];
+            for (int i = 0; i < n; ++i) {
+                for (int j = 0; j < n; ++j) a[i][j] = normal[i][j];
+                a[i][i] += lambda * (1.0 + normal[i][i]);
+                minusGradient[i] = -gradient[i];
+            }
+            if (solveSymmetric(a, minusGradient, step)) {
+                double q[n], rq[rows];
+                for (int i = 0; i < n; ++i) q[i] = p[i] + step[i];
+                if (q[8] > 0 && evaluate(q, rq) && norm(rq, rows) < norm(r, rows)) {
+                    std::copy(q, q + n, p);
+                    std::copy(rq, rq + rows, r);
+                    lambda = std::max(lambda * 0.1, 1e-15);
+                    accepted = true;
+                    continue;
+                }
+            }
+            lambda *= 10.0;
+        }
+        if (!accepted) break;
+
+        error = norm(r, n) / (1.0 + norm(p, n - 1));
+        orbit.iterations = iteration;
+        emit progress(member, iteration, error);
+    }
+
+    orbit.initial = fromParameters(masses, p);
+    orbit.period = p[8];
+    orbit.energy = energy(masses, orbit.initial);
+    orbit.residual = error;
+    orbit.converged = error <= options.tolerance;
+    return orbit;
+}
+
+void PeriodicOrbitFinder::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const PeriodicOrbitOptions& options = request.options;
+        auto result = std::make_shared<PeriodicOrbitResult>();
+        result->options = options;
+
+        try {
+            QList<double> masses = options.masses;
+            const double targetEnergy = energy(masses, options.seed);
+
+            double guess[Unknowns];
+            toParameters(options.seed, options.period, guess);
+            PeriodicOrbit orbit = shoot(masses, guess, targetEnergy, options, 0, request.generation);
+            if (orbit.converged) result->family.append(orbit);
+
+            // Продолжение по m3 с делением ступени при неудаче
+            if (orbit.converged && options.continuationMass > 0 && options.continuationSteps > 0) {
+                const double start = masses.value(2, 1.0);
+                const double full = (options.continuationMass - start) / options.continuationSteps;
+                double step = full;
+                double mass = start;
+                while (std::abs(options.continuationMass - mass) > 1e-12 &&
+                       std::abs(step) >= std::abs(full) / 64 && !isCancelled(request.generation)) {
+                    if (std::abs(step) > std::abs(options.continuationMass - mass)) {
+                        step = options.continuationMass - mass;
+                    }
+                    QList<double> next = masses;
+                    next[2] = mass + step;
+
+                    // Прогноз: секущая по двум последним орбитам семейства
+                    const int size = result->family.size();
+                    double last[Unknowns];
+                    toParameters(result->family[size - 1].initial, result->family[size - 1].period, last);
+                    std::copy(last, last + Unknowns, guess);
+                    if (size >= 2) {
+                        const PeriodicOrbit& previous = result->family[size - 2];
+                        double before[Unknowns];
+                        toParameters(previous.initial, previous.period, before);
+                        const double dm = mass - previous.masses.value(2);
+                        if (std::abs(dm) > 0) {
+                            for (int k = 0; k < Unknowns; ++k) {
+                                guess[k] += (last[k] - before[k]) / dm * step;
+                            }
+                        }
+                    }
+
+                    PeriodicOrbit member = shoot(next, guess, targetEnergy, options, size, request.generation);
+                    if (member.converged) {
+                        result->family.append(member);
+                        mass = next[2];
+                        // После удачной ступени укороченный шаг снова растёт
+                        step *= 2.0;
+                        if (std::abs(step) > std::abs(full)) step = full;
+                    } else {
+                        step *= 0.5;
+                    }
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in PeriodicOrbitFinder:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in PeriodicOrbitFinder";
+            continue;
+        }
+
+        result->elapsedMs = timer.elapsed();
+        {
+            QMutexLocker locker(&m_mutex);
+            if (isCancelled(request.generation)) continue;
+            m_result = result;
+        }
+        emit ready(result->family.size(), !result->family.isEmpty(), result->elapsedMs);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef PERIODICORBIT_H
+#define PERIODICORBIT_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <atomic>
+#include <memory>
+#include "threebody.h"
+
+class PositionSource;
+
+// Периодическая орбита задачи трёх тел: начальное состояние (система центра масс)
+// и период, за который поток возвращает его в себя.
+struct PeriodicOrbit {
+    QList<double> masses;
+    ThreeBodySystem::State initial;
+    double period = 0.0;
+    double energy = 0.0;
+    double residual = 0.0;  // |φ_T(z) - z| относительно |z|
+    int iterations = 0;
+    bool converged = false;
+};
+
+struct PeriodicOrbitOptions {
+    QList<double> masses = {1.0, 1.0, 1.0};
+    ThreeBodySystem::State seed;
+    double period = 2.2365;         // начальное приближение периода (восьмёрка при единичных массах)
+    int stepsPerPeriod = 4000;      // шагов Yoshida 4 на период
+    int maxIterations = 50;
+    double tolerance = 1e-10;
+    double continuationMass = -1.0; // продолжить семейство до такой m3 (m1, m2 не меняются); < 0 - нет
+    int continuationSteps = 20;
+};
+
+struct PeriodicOrbitResult {
+    PeriodicOrbitOptions options;
+    QVector<PeriodicOrbit> family;  // первая - от затравки, далее по m3 (только сошедшиеся)
+    qint64 elapsedMs = 0;
+};
+
+// Поиск периодических орбит одиночной стрельбой.
+// Неизвестные - положения и скорости тел 1 и 2 (тело 3 восстанавливается из
+// центра масс и нулевого импульса) и период T; невязка - φ_T(z) - z и отклонение
+// энергии от начальной (она фиксирует масштаб). Сдвиг по орбите и поворот
+// переводят решение в решение, и квадратный якобиан вырожден; к нему
+// добавлены две строки калибровки (rows = Unknowns + 2): ⟨f, p - p0⟩ = 0 и
+// ⟨R, p - p0⟩ = 0, где f - скорость потока, R - генератор поворота в затравке.
+// Они и снимают вырождение по фазе и повороту, так что переопределённая
+// система решается шагом Гаусса-Ньютона. Левенберг-Марквардт здесь - только
+// демпфирование: λ растёт, пока шаг не уменьшит невязку, и падает после удачного.
+// Столбцы якобиана - центральные разности, 18 интегрирований идут параллельно.
+// Продолжение по m3: масса меняется ступенями, прогноз - секущая по двум
+// последним орбитам; не сошедшаяся ступень делится пополам.
+class PeriodicOrbitFinder : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int Unknowns = 9;
+
+    explicit PeriodicOrbitFinder(QObject* parent = nullptr);
+    ~PeriodicOrbitFinder();
+
+    void launch(const PeriodicOrbitOptions& options);
+    void cancel();
+    void stop();
+
+    std::shared_ptr<const PeriodicOrbitResult> result() const;
+
+    // Состояние источника в момент t (скорости - центральной разностью),
+    // приведённое к центру масс и растянутое так, чтобы 2K = U: тогда размер
+    // согласован с периодом, как у настоящей орбиты (теорема вириала)
+    static bool seedFromSource(const PositionSource& source, double t, const QList<double>& masses,
+                               ThreeBodySystem::State& seed);
+
+    // Состояние через время period (steps шагов Yoshida 4); false при столкновении
+    static bool flow(const QList<double>& masses, const ThreeBodySystem::State& initial,
+                     double period, int steps, ThreeBodySystem::State& final);
+
+    static double energy(const QList<double>& masses, const ThreeBodySystem::State& state);
+
+signals:
+    void progress(int member, int iteration, double residual);
+    void ready(int orbits, bool converged, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        PeriodicOrbitOptions options;
+        quint64 generation = 0;
+    };
+
+    bool isCancelled(quint64 generation) const;
+
+    // Ньютон (Левенберг-Марквардт) от приближения guess при заданных массах
+    PeriodicOrbit shoot(const QList<double>& masses, const double guess[Unknowns], double targetEnergy,
+                        const PeriodicOrbitOptions& options, int member, quint64 generation);
+
+    static void toParameters(const ThreeBodySystem::State& state, double period, double p[Unknowns]);
+    static ThreeBodySystem::State fromParameters(const QList<double>& masses, const double p[Unknowns]);
+    static bool residual(const QList<double>& masses, const double p[Unknowns], double targetEnergy,
+                         int steps, double r[Unknowns]);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const PeriodicOrbitResult> m_result; // под m_mutex
+};
+
+#endif // PERIODICORBIT_H
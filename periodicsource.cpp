@@ -0,0 +1,92 @@
+#include "periodicsource.h"
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+#include <cstring>
+
+PeriodicOrbitSource::PeriodicOrbitSource(const PeriodicOrbit& orbit, int knotsPerPeriod)
+    : m_orbit(orbit)
+{
+    if (!(orbit.period > 0) || knotsPerPeriod <= 0) return;
+
+    // Та же схема и тот же шаг, что при стрельбе: конец периода совпадает
+    // с началом с точностью невязки
+    m_step = orbit.period / knotsPerPeriod;
+    ThreeBodySystem system(orbit.masses, orbit.initial, ThreeBodySystem::Yoshida4, m_step);
+
+    m_knots.reserve(knotsPerPeriod + 1);
+    for (int i = 0; i <= knotsPerPeriod; ++i) {
+        if (i > 0) system.advance();
+        Knot knot;
+        std::memcpy(knot.x, system.state().x, sizeof(knot.x));
+        std::memcpy(knot.v, system.state().v, sizeof(knot.v));
+        m_knots.append(knot);
+    }
+}
+
+bool PeriodicOrbitSource::positionsAt(double t, QPointF points[3]) const
+{
+    if (!isValid() || !std::isfinite(t)) return false;
+
+    double phase = std::fmod(t, m_orbit.period);
+    if (phase < 0) phase += m_orbit.period;
+
+    const int k = qBound(0, static_cast<int>(phase / m_step), int(m_knots.size()) - 2);
+    const Knot& a = m_knots[k];
+    const Knot& b = m_knots[k + 1];
+
+    // Эрмитов кубический сплайн по положениям и скоростям концов
+    const double h = m_step;
+    const double s = (phase - k * h) / h;
+    const double s2 = s * s, s3 = s2 * s;
+    const double h00 = 2 * s3 - 3 * s2 + 1;
+    const double h10 = (s3 - 2 * s2 + s) * h;
+    const double h01 = -2 * s3 + 3 * s2;
+    const double h11 = (s3 - s2) * h;
+
+    for (int i = 0; i < 3; ++i) {
+        const double x = h00 * a.x[2 * i] + h10 * a.v[2 * i] + h01 * b.x[2 * i] + h11 * b.v[2 * i];
+        const double y = h00 * a.x[2 * i + 1] + h10 * a.v[2 * i + 1] + h01 * b.x[2 * i + 1] + h11 * b.v[2 * i + 1];
+        points[i] = QPointF(x, y);
+    }
+    return true;
+}
+
+bool PeriodicOrbitSource::save(const QString& fileName, int periods, QString* error) const
+{
+    if (!isValid()) {
+        if (error) *error = "No orbit to save";
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error) *error = "Cannot open output file: " + fileName;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out.setRealNumberPrecision(17);
+    out << "# periodic orbit: m = " << m_orbit.masses.value(0) << ", " << m_orbit.masses.value(1)
+        << ", " << m_orbit.masses.value(2) << "; T = " << m_orbit.period << "; E = " << m_orbit.energy
+        << "; residual = " << m_orbit.residual << '\n';
+    out << "t,x1,y1,x2,y2,x3,y3\n";
+
+    const int knots = m_knots.size() - 1;
+    for (int period = 0; period < qMax(1, periods); ++period) {
+        // Последний узел периода - первый следующего; его пишем только в конце
+        const int last = (period + 1 < qMax(1, periods)) ? knots - 1 : knots;
+        for (int i = 0; i <= last; ++i) {
+            out << (period * knots + i) * m_step;
+            for (int k = 0; k < 6; ++k) out << ',' << m_knots[i].x[k];
+            out << '\n';
+        }
+    }
+    out.flush();
+
+    if (out.status() != QTextStream::Ok) {
+        if (error) *error = "Write error: " + file.errorString();
+        return false;
+    }
+    return true;
+}
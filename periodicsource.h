@@ -0,0 +1,37 @@
+#ifndef PERIODICSOURCE_H
+#define PERIODICSOURCE_H
+
+#include <QString>
+#include <QVector>
+#include "positionsource.h"
+#include "periodicorbit.h"
+
+// Найденная периодическая орбита как источник анимации.
+// Один период табулируется той же схемой, что и при стрельбе (положения и
+// скорости в узлах), между узлами - эрмитов сплайн, время берётся по модулю
+// периода. Поэтому движение не уходит с орбиты, даже если она неустойчива.
+class PeriodicOrbitSource : public PositionSource
+{
+public:
+    explicit PeriodicOrbitSource(const PeriodicOrbit& orbit, int knotsPerPeriod = 4000);
+
+    bool positionsAt(double t, QPointF points[3]) const override;
+
+    const PeriodicOrbit& orbit() const { return m_orbit; }
+    bool isValid() const { return m_knots.size() > 1; }
+
+    // Таблица (t, x1, y1, ..., y3) на periods периодов - читается TabulatedSource
+    bool save(const QString& fileName, int periods, QString* error = nullptr) const;
+
+private:
+    struct Knot {
+        double x[6];
+        double v[6];
+    };
+
+    PeriodicOrbit m_orbit;
+    QVector<Knot> m_knots;  // равномерно по [0, T], последний совпадает с первым
+    double m_step = 0.0;
+};
+
+#endif // PERIODICSOURCE_H
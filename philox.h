@@ -0,0 +1,78 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <QtGlobal>
+
+// Счётный генератор Philox4x32-10 (Salmon и др., "Parallel random numbers:
+// as easy as 1, 2, 3"): выход - биекция счётчика под ключом, состояния нет.
+// Поток задаётся ключом (seed) и старшей половиной счётчика (номер потока),
+// поэтому каждый блок работы получает свою независимую последовательность,
+// одну и ту же при любом распределении блоков по потокам.
+class PhiloxStream
+{
+public:
+    PhiloxStream(quint64 seed, quint64 stream)
+    {
+        m_key[0] = quint32(seed);
+        m_key[1] = quint32(seed >> 32);
+        m_counter[0] = 0;
+        m_counter[1] = 0;
+        m_counter[2] = quint32(stream);
+        m_counter[3] = quint32(stream >> 32);
+    }
+
+    // Четыре 32-битных слова следующего значения счётчика
+    void next(quint32 out[4])
+    {
+        generate(m_counter, m_key, out);
+        if (++m_counter[0] == 0) ++m_counter[1];
+    }
+
+    // count равномерных чисел в (0, 1) с шагом 2^-32
+    void uniforms(double* out, int count)
+    {
+        quint32 words[4];
+        int k = 0;
+        for (; k + 4 <= count; k += 4) {
+            next(words);
+            for (int i = 0; i < 4; ++i) out[k + i] = toUniform(words[i]);
+        }
+        if (k < count) {
+            next(words);
+            for (int i = 0; k < count; ++i, ++k) out[k] = toUniform(words[i]);
+        }
+    }
+
+    static double toUniform(quint32 word) { return (word + 0.5) * (1.0 / 4294967296.0); }
+
+    static void generate(const quint32 counter[4], const quint32 key[2], quint32 out[4])
+    {
+        const quint32 M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+        const quint32 W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+        quint32 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        quint32 k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            const quint64 p0 = quint64(M0) * c0;
+            const quint64 p1 = quint64(M1) * c2;
+            const quint32 n0 = quint32(p1 >> 32) ^ c1 ^ k0;
+            const quint32 n2 = quint32(p0 >> 32) ^ c3 ^ k1;
+            c1 = quint32(p1);
+            c3 = quint32(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += W0;
+            k1 += W1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+private:
+    quint32 m_key[2];
+    quint32 m_counter[4];
+};
+
+#endif // PHILOX_H
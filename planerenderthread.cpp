@@ -0,0 +1,193 @@
+#include "planerenderthread.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cmath>
+
+PlaneRenderThread::PlaneRenderThread(QObject* parent)
+    : QThread(parent)
+{
+}
+
+PlaneRenderThread::~PlaneRenderThread()
+{
+    stop();
+}
+
+void PlaneRenderThread::submit(const PlaneSnapshot& snapshot)
+{
+    QMutexLocker locker(&m_mutex);
+    // Заменяем ещё не начатый кадр - устаревшие снимки рисовать незачем
+    m_pending = snapshot;
+    m_hasPending = true;
+    m_condition.wakeOne();
+}
+
+void PlaneRenderThread::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+void PlaneRenderThread::run()
+{
+    forever {
+        PlaneSnapshot snapshot;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            snapshot = m_pending;
+            m_pending = PlaneSnapshot(); // отпускаем общие с GUI данные
+            m_hasPending = false;
+        }
+
+        try {
+            QImage frame = render(snapshot);
+            if (!frame.isNull()) {
+                emit frameReady(frame, snapshot.serial);
+            }
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in PlaneRenderThread:" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in PlaneRenderThread";
+        }
+    }
+}
+
+QImage PlaneRenderThread::render(const PlaneSnapshot& snapshot)
+{
+    if (snapshot.size.isEmpty()) return QImage();
+
+    QSize pixelSize = snapshot.size * snapshot.devicePixelRatio;
+    if (m_staticLayer.size() != pixelSize ||
+        m_staticTransform != snapshot.transform ||
+        !qFuzzyCompare(m_staticLayer.devicePixelRatio(), snapshot.devicePixelRatio)) {
+        renderStaticLayer(snapshot);
+    }
+
+    QImage frame = m_staticLayer.copy();
+    frame.setDevicePixelRatio(snapshot.devicePixelRatio);
+
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(snapshot.transform);
+
+    // Траектории
+    for (const PlaneSnapshot::Trail& trail : snapshot.trails) {
+        QPainterPath path;
+        for (const auto& segment : trail.segments) {
+            if (segment.size() < 2) continue;
+            path.moveTo(segment.first());
+            for (int i = 1; i < segment.size(); ++i) {
+                path.lineTo(segment[i]);
+            }
+        }
+        if (path.isEmpty()) continue;
+
+        painter.setPen(QPen(trail.color, trail.width));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawPath(path);
+    }
+
+    // Текущие точки
+    for (const PlaneSnapshot::Marker& marker : snapshot.markers) {
+        painter.setPen(QPen(Qt::black, 0.01));
+        painter.setBrush(QBrush(marker.color));
+        painter.drawEllipse(marker.pos, marker.radius, marker.radius);
+    }
+
+    painter.end();
+    return frame;
+}
+
+void PlaneRenderThread::renderStaticLayer(const PlaneSnapshot& snapshot)
+{
+    QSize pixelSize = snapshot.size * snapshot.devicePixelRatio;
+    m_staticLayer = QImage(pixelSize, QImage::Format_ARGB32_Premultiplied);
+    m_staticLayer.setDevicePixelRatio(snapshot.devicePixelRatio);
+    m_staticLayer.fill(snapshot.background);
+    m_staticTransform = snapshot.transform;
+
+    QPainter painter(&m_staticLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(snapshot.transform);
+
+    const double lo = snapshot.gridMin;
+    const double hi = snapshot.gridMax;
+
+    // Координатная сетка (целочисленный счётчик, чтобы не копить ошибку шага)
+    painter.setPen(QPen(snapshot.gridColor, 0.005));
+    int gridLines = static_cast<int>(std::round((hi - lo) / snapshot.gridStep));
+    for (int i = 0; i <= gridLines; ++i) {
+        double value = lo + i * snapshot.gridStep;
+        if (std::abs(value) < 1e-9) continue;
+        painter.drawLine(QPointF(value, lo), QPointF(value, hi));
+        painter.drawLine(QPointF(lo, value), QPointF(hi, value));
+    }
+
+    // Оси
+    painter.setPen(QPen(Qt::black, 0.02));
+    painter.drawLine(QPointF(lo, 0), QPointF(hi, 0));
+    painter.drawLine(QPointF(0, lo), QPointF(0, hi));
+
+    // Засечки
+    const double tickSize = 0.01 * (hi - lo);
+    painter.setPen(QPen(Qt::black, 0.015));
+    int ticks = static_cast<int>(std::round((hi - lo) / snapshot.tickStep));
+    for (int i = 0; i <= ticks; ++i) {
+        double value = lo + i * snapshot.tickStep;
+        if (std::abs(value) < 1e-9) continue;
+        painter.drawLine(QPointF(value, -tickSize), QPointF(value, tickSize));
+        painter.drawLine(QPointF(-tickSize, value), QPointF(tickSize, value));
+    }
+
+    // Легенда ветвей (размеры как у элементов сцены для области [-3, 3])
+    const double unit = (hi - lo) / 6.0;
+    painter.setPen(QPen(Qt::black, 0.005));
+    for (int i = 0; i < snapshot.legend.size(); ++i) {
+        painter.setBrush(QBrush(snapshot.legend[i]));
+        painter.drawRect(QRectF(lo + 0.1 * unit, lo + (0.4 + 0.2 * i) * unit,
+                                0.1 * unit, 0.1 * unit));
+    }
+
+    // Подписи рисуем в пикселях, иначе шрифт масштабируется вместе со сценой
+    const QTransform& t = snapshot.transform;
+    painter.resetTransform();
+    painter.setPen(Qt::black);
+
+    QFont font = painter.font();
+    font.setPointSize(12);
+    painter.setFont(font);
+    if (!snapshot.xLabel.isEmpty()) {
+        painter.drawText(t.map(QPointF(hi, 0)) + QPointF(4, -4), snapshot.xLabel);
+    }
+    if (!snapshot.yLabel.isEmpty()) {
+        painter.drawText(t.map(QPointF(0, hi)) + QPointF(4, -4), snapshot.yLabel);
+    }
+
+    if (snapshot.tickLabels) {
+        font.setPointSize(8);
+        painter.setFont(font);
+        for (int i = 0; i <= ticks; ++i) {
+            double value = lo + i * snapshot.tickStep;
+            if (std::abs(value) < 1e-9) continue;
+            QString text = QString::number(value, 'f', 1);
+            painter.drawText(t.map(QPointF(value, tickSize)) + QPointF(-8, 12), text);
+            painter.drawText(t.map(QPointF(tickSize, value)) + QPointF(4, 4), text);
+        }
+        painter.drawText(t.map(QPointF(0, 0)) + QPointF(4, 12), "0");
+    }
+
+    painter.end();
+}
@@ -0,0 +1,87 @@
+#ifndef PLANERENDERTHREAD_H
+#define PLANERENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QTransform>
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include <QString>
+
+// Неизменяемый снимок состояния комплексной плоскости.
+// Все данные копируются (QVector разделяет память до первой записи),
+// поэтому GUI может продолжать дописывать траектории, пока рабочий поток рисует.
+struct PlaneSnapshot {
+    struct Trail {
+        QColor color;
+        double width = 0.02; // толщина в координатах сцены
+        QVector<QVector<QPointF>> segments;
+    };
+
+    struct Marker {
+        QPointF pos;
+        QColor color;
+        double radius = 0.03;
+    };
+
+    QSize size;                  // размер viewport в логических пикселях
+    qreal devicePixelRatio = 1.0;
+    QTransform transform;        // сцена -> viewport
+    QColor background = Qt::white;
+
+    // Координатная сетка
+    double gridMin = -1.0;
+    double gridMax = 1.0;
+    double gridStep = 0.1;
+    double tickStep = 0.5;
+    QColor gridColor = QColor(220, 220, 220);
+    bool tickLabels = true;
+    QString xLabel;
+    QString yLabel;
+
+    QVector<Trail> trails;
+    QVector<Marker> markers;
+    QVector<QColor> legend; // цветные квадратики в левом верхнем углу
+
+    quint64 serial = 0;
+};
+
+// Рабочий поток, растеризующий плоскость в QImage.
+// Если кадры приходят быстрее, чем успевают рисоваться, промежуточные
+// снимки отбрасываются - рисуется только самый свежий.
+class PlaneRenderThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit PlaneRenderThread(QObject* parent = nullptr);
+    ~PlaneRenderThread();
+
+    void submit(const PlaneSnapshot& snapshot);
+    void stop();
+
+signals:
+    void frameReady(const QImage& frame, quint64 serial);
+
+protected:
+    void run() override;
+
+private:
+    QImage render(const PlaneSnapshot& snapshot);
+    void renderStaticLayer(const PlaneSnapshot& snapshot);
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    PlaneSnapshot m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    // Сетка и подписи меняются только при изменении размера,
+    // поэтому кэшируем их между кадрами (используется только рабочим потоком)
+    QImage m_staticLayer;
+    QTransform m_staticTransform;
+};
+
+#endif // PLANERENDERTHREAD_H
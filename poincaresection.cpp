@@ -0,0 +1,350 @@
+#include "poincaresection.h"
+#include "ensemble.h"
+#include "parallelfor.h"
+#include "threebodylanes.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+// Точки копятся в потоке и уходят в общий буфер такими порциями
+constexpr int PublishChunk = 4096;
+
+}
+
+PoincareRunner::PoincareRunner(QObject* parent)
+    : QThread(parent)
+{
+}
+
+PoincareRunner::~PoincareRunner()
+{
+    stop();
+}
+
+void PoincareRunner::launch(const PoincareOptions& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.options = options;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+}
+
+void PoincareRunner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void PoincareRunner::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+bool PoincareRunner::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+bool PoincareRunner::takePoints(QVector<QPointF>& points)
+{
+    QMutexLocker locker(&m_pointsMutex);
+    points.swap(m_points);
+    m_points.clear();
+    m_notified = false;
+    return !points.isEmpty();
+}
+
+void PoincareRunner::publish(const PoincareOptions& options, QVector<QPointF>& points, Work& work,
+                             quint64 generation)
+{
+    if (points.isEmpty()) return;
+
+    bool notify = false;
+    {
+        QMutexLocker locker(&m_pointsMutex);
+        // Точки отменённого расчёта не показываем
+        if (!isCancelled(generation)) {
+            m_points += points;
+            notify = !m_notified;
+            m_notified = true;
+        }
+    }
+
+    const quint64 total = work.points.fetch_add(points.size(), std::memory_order_relaxed) + points.size();
+    points.clear();
+    if (notify) emit pointsAvailable();
+
+    const int percent = int(qMin<quint64>(100, total * 100 / quint64(qMax(1, options.targetPoints))));
+    if (work.reportedPercent.exchange(percent) != percent) emit progress(percent);
+}
+
+bool PoincareRunner::initialState(const PoincareOptions& options, std::mt19937_64& rng,
+                                  double position[6], double velocity[6])
+{
+    const QList<double>& m = options.masses;
+    if (m.size() != 3 || !(options.energy < 0)) return false;
+
+    // Равномерно распределённая форма, из покоя с U = 1
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double y = 2.0 * uniform(rng) - 1.0;
+    const double theta = 2.0 * M_PI * uniform(rng);
+    const double rho = std::sqrt(qMax(0.0, 1.0 - y * y));
+    double x0[6];
+    if (!EnsembleRunner::initialPositions(QVector3D(rho * std::cos(theta), y, rho * std::sin(theta)), m, x0)) {
+        return false;
+    }
+
+    double inertia0 = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        inertia0 += m[i] * (x0[2 * i] * x0[2 * i] + x0[2 * i + 1] * x0[2 * i + 1]);
+    }
+
+    // Масштаб 1/u: U = u, I = I0/u², T_rot = L²u²/(2I0).
+    // Кинетическая энергия формы E + u - L²u²/(2I0) должна быть неотрицательной
+    const double energy = options.energy;
+    const double momentum = options.angularMomentum;
+    double uMin, uMax;
+    if (momentum == 0.0) {
+        uMin = -energy;
+        uMax = -2.0 * energy; // кинетическая энергия формы не больше |E|
+    } else {
+        const double a = momentum * momentum / (2.0 * inertia0);
+        const double discriminant = 1.0 + 4.0 * a * energy;
+        if (discriminant < 0) return false; // форма вне области Хилла
+        uMin = (1.0 - std::sqrt(discriminant)) / (2.0 * a);
+        uMax = (1.0 + std::sqrt(discriminant)) / (2.0 * a);
+    }
+    const double u = uMin + (uMax - uMin) * uniform(rng);
+    if (!(u > 0)) return false;
+
+    for (int k = 0; k < 6; ++k) position[k] = x0[k] / u;
+    const double inertia = inertia0 / (u * u);
+    const double shapeKinetic = energy + u - momentum * momentum / (2.0 * inertia);
+
+    // Случайная скорость формы: без импульса и без момента импульса
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double w[6];
+    double px = 0.0, py = 0.0, total = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        w[2 * i] = normal(rng) / std::sqrt(m[i]);
+        w[2 * i + 1] = normal(rng) / std::sqrt(m[i]);
+        px += m[i] * w[2 * i];
+        py += m[i] * w[2 * i + 1];
+        total += m[i];
+    }
+    double lw = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        w[2 * i] -= px / total;
+        w[2 * i + 1] -= py / total;
+        lw += m[i] * (position[2 * i] * w[2 * i + 1] - position[2 * i + 1] * w[2 * i]);
+    }
+    const double omegaW = lw / inertia;
+    double kinetic = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        w[2 * i] += omegaW * position[2 * i + 1];
+        w[2 * i + 1] -= omegaW * position[2 * i];
+        kinetic += 0.5 * m[i] * (w[2 * i] * w[2 * i] + w[2 * i + 1] * w[2 * i + 1]);
+    }
+    const double scale = kinetic > 0 ? std::sqrt(qMax(0.0, shapeKinetic) / kinetic) : 0.0;
+
+    // Вращение твёрдым телом с ω = L/I ортогонально скорости формы,
+    // поэтому энергии складываются
+    const double omega = momentum / inertia;
+    for (int i = 0; i < 3; ++i) {
+        velocity[2 * i] = -omega * position[2 * i + 1] + scale * w[2 * i];
+        velocity[2 * i + 1] = omega * position[2 * i] + scale * w[2 * i + 1];
+    }
+    return true;
+}
+
+void PoincareRunner::integrateOrbits(const PoincareOptions& options, Work& work, quint64 generation)
+{
+    const QList<double>& m = options.masses;
+    ThreeBodyLanes<Lanes> lanes;
+    lanes.setMasses(m);
+
+    const double m12 = m[0] + m[1];
+    const double mu1 = m[0] * m[1] / m12;
+    const double mu2 = m[2] * m12 / (m12 + m[2]);
+    const double c = 2.0 * std::sqrt(mu1 * mu2);
+
+    // Базис плоскости круга: ψ = atan2(p·b, p·a)
+    const QVector3D n = options.normal.normalized();
+    QVector3D a = QVector3D::crossProduct(n, QVector3D(0.0f, 1.0f, 0.0f));
+    if (a.lengthSquared() < 1e-6f) a = QVector3D(0.0f, 0.0f, 1.0f);
+    a.normalize();
+    const QVector3D b = QVector3D::crossProduct(n, a);
+    const double nx = n.x(), ny = n.y(), nz = n.z();
+
+    // Точка сферы (ξ2, ξ3, ξ1) без нормировки и значение функции сечения
+    double p[3][Lanes], previous[3][Lanes], g[Lanes], previousG[Lanes];
+    int collected[Lanes] = {};
+    int orbitSteps[Lanes] = {};
+    double escapeRadius[Lanes];
+    auto shapePoints = [&]() {
+        const auto& x = lanes.x;
+        for (int l = 0; l < Lanes; ++l) {
+            const double q1x = x[2][l] - x[0][l], q1y = x[3][l] - x[1][l];
+            const double q2x = x[4][l] - (m[0] * x[0][l] + m[1] * x[2][l]) / m12;
+            const double q2y = x[5][l] - (m[0] * x[1][l] + m[1] * x[3][l]) / m12;
+            p[0][l] = c * (q1x * q2x + q1y * q2y);
+            p[1][l] = c * (q1y * q2x - q1x * q2y);
+            p[2][l] = mu1 * (q1x * q1x + q1y * q1y) - mu2 * (q2x * q2x + q2y * q2y);
+            g[l] = nx * p[0][l] + ny * p[1][l] + nz * p[2][l];
+        }
+    };
+
+    QVector<QPointF> points;
+    points.reserve(PublishChunk);
+
+    std::mt19937_64 rng;
+    auto startOrbit = [&](int l) {
+        for (;;) {
+            // Счётчик точек отстаёт на неопубликованные порции - это лишь небольшой перебор
+            const bool enough = work.points.load(std::memory_order_relaxed) +
+                                quint64(points.size()) >= quint64(options.targetPoints);
+            const int orbit = work.nextOrbit.fetch_add(1);
+            if (enough || orbit >= options.maxOrbits || isCancelled(generation)) {
+                lanes.active[l] = 0.0;
+                return false;
+            }
+            // Своя последовательность для каждой орбиты - результат не зависит от раздачи
+            rng.seed(options.seed * 0x9E3779B97F4A7C15ull + quint64(orbit));
+            double position[6], velocity[6];
+            bool ok = false;
+            for (int attempt = 0; attempt < 64 && !ok; ++attempt) {
+                ok = initialState(options, rng, position, velocity);
+            }
+            if (!ok) continue;
+            lanes.load(l, position, velocity);
+            collected[l] = 0;
+            orbitSteps[l] = 0;
+            double size = std::max({std::hypot(position[2] - position[0], position[3] - position[1]),
+                                    std::hypot(position[4] - position[0], position[5] - position[1]),
+                                    std::hypot(position[4] - position[2], position[5] - position[3])});
+            escapeRadius[l] = options.escapeFactor * size;
+            return true;
+        }
+    };
+
+    int running = 0;
+    for (int l = 0; l < Lanes; ++l) {
+        lanes.active[l] = 0.0;
+        for (int k = 0; k < 6; ++k) lanes.x[k][l] = lanes.v[k][l] = 0.0;
+        lanes.x[2][l] = lanes.x[5][l] = 1.0; // стоящая дорожка не должна делить на ноль
+        lanes.t[l] = 0.0;
+        lanes.binding[l] = 1.0;
+        if (startOrbit(l)) ++running;
+    }
+    shapePoints();
+    for (int l = 0; l < Lanes; ++l) {
+        previousG[l] = g[l];
+        for (int k = 0; k < 3; ++k) previous[k][l] = p[k][l];
+    }
+
+    quint64 steps = 0;
+    while (running > 0) {
+        lanes.step(options.step);
+        shapePoints();
+        ++steps;
+
+        for (int l = 0; l < Lanes; ++l) {
+            if (lanes.active[l] == 0.0) continue;
+            ++orbitSteps[l];
+
+            // Пересечение в одну сторону: g переходит через ноль снизу вверх
+            if (previousG[l] < 0 && g[l] >= 0) {
+                const double f = previousG[l] / (previousG[l] - g[l]);
+                QVector3D p0(previous[0][l], previous[1][l], previous[2][l]);
+                QVector3D p1(p[0][l], p[1][l], p[2][l]);
+                p0.normalize();
+                p1.normalize();
+                const QVector3D crossing = (p0 + float(f) * (p1 - p0)).normalized();
+                const QVector3D motion = p1 - p0;
+                const float speed = motion.length();
+                if (speed > 0) {
+                    const QVector3D along = QVector3D::crossProduct(n, crossing);
+                    const double psi = std::atan2(QVector3D::dotProduct(crossing, b),
+                                                  QVector3D::dotProduct(crossing, a));
+                    points.append(QPointF(psi / M_PI, QVector3D::dotProduct(motion, along) / speed));
+                    ++collected[l];
+                }
+            }
+            previousG[l] = g[l];
+            for (int k = 0; k < 3; ++k) previous[k][l] = p[k][l];
+
+            bool done = collected[l] >= options.pointsPerOrbit || lanes.t[l] >= options.maxTime;
+            if (!done && (orbitSteps[l] & 63) == 0) {
+                done = lanes.escapingBody(l, escapeRadius[l]) >= 0;
+            }
+            if (done) {
+                if (!startOrbit(l)) {
+                    --running;
+                    continue;
+                }
+                // Новая орбита: предыдущая точка - её начало
+                shapePoints();
+                previousG[l] = g[l];
+                for (int k = 0; k < 3; ++k) previous[k][l] = p[k][l];
+            }
+        }
+
+        if (points.size() >= PublishChunk) publish(options, points, work, generation);
+        if ((steps & 1023) == 0 && isCancelled(generation)) break;
+    }
+    publish(options, points, work, generation);
+}
+
+void PoincareRunner::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const PoincareOptions& options = request.options;
+        Work work;
+        const int workers = qMax(1, QThread::idealThreadCount());
+
+        try {
+            // Каждый рабочий сам берёт орбиты из общего счётчика
+            parallelFor(0, workers, [&](int) {
+                integrateOrbits(options, work, request.generation);
+            }, 1);
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in PoincareRunner:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in PoincareRunner";
+            continue;
+        }
+
+        if (isCancelled(request.generation)) continue;
+        emit ready(work.points.load(), qMin(work.nextOrbit.load(), options.maxOrbits), timer.elapsed());
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef POINCARESECTION_H
+#define POINCARESECTION_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QVector3D>
+#include <atomic>
+#include <random>
+
+// Сечение Пуанкаре: плоскость большого круга на сфере форм (нормаль normal
+// в координатах SphereWidget), фиксированные энергия и момент импульса.
+// Точка сечения - (ψ/π, v∥): ψ - положение на большом круге, v∥ - доля
+// скорости движения по сфере вдоль круга (от -1 до 1). Обе в [-1, 1],
+// так что разброс точек ложится в область ComplexPlaneView.
+struct PoincareOptions {
+    QList<double> masses = {1.0, 1.0, 1.0};
+    double energy = -1.0;           // только связанные движения (E < 0)
+    double angularMomentum = 0.5;
+    QVector3D normal = QVector3D(0.0f, 1.0f, 0.0f); // экватор - сизигии
+    int targetPoints = 1000000;     // новые орбиты не начинаются, когда точек набрано столько
+    int pointsPerOrbit = 500;       // больше точек с одной орбиты не берём
+    int maxOrbits = 10000000;
+    double maxTime = 5000.0;        // предел для одной орбиты
+    double step = 1e-2;             // шаг по фиктивному времени s
+    double escapeFactor = 20.0;     // орбита с вылетом дальше стольких начальных размеров кончается
+    quint64 seed = 1;
+};
+
+// Фоновый расчёт сечения: орбиты идут пачками ThreeBodyLanes на всех ядрах,
+// закончившаяся дорожка сразу получает следующую орбиту. Точки пересечения
+// копятся в общем буфере порциями; GUI забирает их по сигналу pointsAvailable,
+// не дожидаясь конца расчёта.
+class PoincareRunner : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int Lanes = 8;
+
+    explicit PoincareRunner(QObject* parent = nullptr);
+    ~PoincareRunner();
+
+    // Отменяет идущий расчёт и запускает новый
+    void launch(const PoincareOptions& options);
+    void cancel();
+    void stop();
+
+    // Забирает накопленные точки (только GUI-поток)
+    bool takePoints(QVector<QPointF>& points);
+
+    // Начальное состояние орбиты (центр масс в покое, заданные E и L) из случайной
+    // формы; false, если форма недостижима при этих E и L
+    static bool initialState(const PoincareOptions& options, std::mt19937_64& rng,
+                             double position[6], double velocity[6]);
+
+signals:
+    void pointsAvailable();
+    void progress(int percent);
+    void ready(quint64 points, int orbits, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        PoincareOptions options;
+        quint64 generation = 0;
+    };
+
+    // Общие для рабочих потоков счётчики одного расчёта
+    struct Work {
+        std::atomic<int> nextOrbit{0};
+        std::atomic<int> reportedPercent{-1};
+        std::atomic<quint64> points{0};
+    };
+
+    bool isCancelled(quint64 generation) const;
+    void publish(const PoincareOptions& options, QVector<QPointF>& points, Work& work, quint64 generation);
+    void integrateOrbits(const PoincareOptions& options, Work& work, quint64 generation);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+    std::atomic<quint64> m_generation{0};
+
+    // Точки, ещё не забранные GUI (под m_pointsMutex)
+    QMutex m_pointsMutex;
+    QVector<QPointF> m_points;
+    bool m_notified = false;
+};
+
+#endif // POINCARESECTION_H
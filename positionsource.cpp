@@ -0,0 +1,62 @@
+#include "positionsource.h"
+#include "mathparser.h"
+#include <QLineF>
+#include <QDebug>
+#include <cmath>
+
+double PositionSource::triangleSize(const QPointF points[3])
+{
+    double side1 = QLineF(points[0], points[1]).length();
+    double side2 = QLineF(points[1], points[2]).length();
+    double side3 = QLineF(points[2], points[0]).length();
+    return qMax(side1, qMax(side2, side3));
+}
+
+void PositionSource::fitToScene(QPointF points[3])
+{
+    const double smallTriangleThreshold = 50.0;
+    if (triangleSize(points) >= smallTriangleThreshold) return;
+
+    const double scale = 50.0;
+    const double center = 100.0;
+    for (int i = 0; i < 3; ++i) {
+        points[i] = QPointF(points[i].x() * scale + center,
+                            points[i].y() * scale + center);
+    }
+}
+
+ExpressionSource::ExpressionSource(const QStringList& functions)
+{
+    for (int i = 0; i < 6 && i < functions.size(); ++i) {
+        m_functions[i] = functions[i];
+    }
+}
+
+bool ExpressionSource::isValid() const
+{
+    for (const QString& function : m_functions) {
+        if (function.isEmpty()) return false;
+    }
+    return true;
+}
+
+bool ExpressionSource::positionsAt(double t, QPointF points[3]) const
+{
+    if (!isValid()) return false;
+
+    double values[6];
+    for (int i = 0; i < 6; ++i) {
+        try {
+            values[i] = MathParser::evaluate(m_functions[i], t);
+        } catch (const std::exception& e) {
+            qWarning() << "Expression evaluation error:" << m_functions[i] << "->" << e.what();
+            values[i] = 0.0;
+        }
+        if (std::isnan(values[i]) || std::isinf(values[i])) return false;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        points[i] = QPointF(values[2 * i], values[2 * i + 1]);
+    }
+    return true;
+}
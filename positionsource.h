@@ -0,0 +1,41 @@
+#ifndef POSITIONSOURCE_H
+#define POSITIONSOURCE_H
+
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+
+// Источник положений трёх тел во времени.
+// Реализации не должны иметь изменяемого состояния в positionsAt:
+// один и тот же объект читают поток симуляции и GUI одновременно.
+class PositionSource
+{
+public:
+    virtual ~PositionSource() = default;
+
+    // Положения тел в момент t; false, если они не определены
+    virtual bool positionsAt(double t, QPointF points[3]) const = 0;
+
+    // Максимальная длина стороны треугольника
+    static double triangleSize(const QPointF points[3]);
+
+    // Маленькие треугольники (например, в безразмерных единицах)
+    // растягиваются до масштаба сцены
+    static void fitToScene(QPointF points[3]);
+};
+
+// Положения, заданные формулами x1(t), y1(t), ..., y3(t)
+class ExpressionSource : public PositionSource
+{
+public:
+    // Порядок: x1, y1, x2, y2, x3, y3
+    explicit ExpressionSource(const QStringList& functions);
+
+    bool isValid() const;
+    bool positionsAt(double t, QPointF points[3]) const override;
+
+private:
+    QString m_functions[6];
+};
+
+#endif // POSITIONSOURCE_H
@@ -0,0 +1,75 @@
+#include "shapeevents.h"
+
+namespace {
+
+// Время, в которое линейная интерполяция функции проходит через ноль
+double crossingTime(double t0, double g0, double t1, double g1)
+{
+    return t0 + (t1 - t0) * g0 / (g0 - g1);
+}
+
+}
+
+void ShapeEventTracker::setMassSystem(const MassSystem& system)
+{
+    m_system = system;
+    reset();
+}
+
+void ShapeEventTracker::reset()
+{
+    m_hasPrevious = false;
+}
+
+void ShapeEventTracker::clearStats()
+{
+    m_stats = ShapeEventStats();
+    reset();
+}
+
+void ShapeEventTracker::feed(double t, const QVector3D& spherePoint)
+{
+    if (!m_system.valid) return;
+
+    double right[3], isosceles[3];
+    int region = -1;
+    for (int i = 0; i < 3; ++i) {
+        right[i] = m_system.rightAngle[i].at(spherePoint);
+        isosceles[i] = m_system.isosceles[i].at(spherePoint);
+        if (right[i] < 0) region = i;
+    }
+
+    if (m_hasPrevious && t > m_previousTime) {
+        const double dt = t - m_previousTime;
+        if (m_stats.region >= 0) m_stats.obtuseTime += dt; else m_stats.acuteTime += dt;
+
+        if (region != m_stats.region) {
+            // Переход через прямоугольную окружность той вершины, где сменился знак
+            int vertex = region >= 0 ? region : m_stats.region;
+            double when = crossingTime(m_previousTime, m_previousRight[vertex], t, right[vertex]);
+            if (region >= 0) {
+                ++m_stats.obtuseEntries[region];
+                m_stats.lastObtuseEntry = when;
+            } else {
+                ++m_stats.acuteEntries;
+                m_stats.lastAcuteEntry = when;
+            }
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if ((m_previousIsosceles[i] < 0) != (isosceles[i] < 0)) {
+                ++m_stats.isoscelesCrossings[i];
+                m_stats.lastIsoscelesCrossing = crossingTime(m_previousTime, m_previousIsosceles[i],
+                                                             t, isosceles[i]);
+            }
+        }
+    }
+
+    m_stats.region = region;
+    m_previousTime = t;
+    for (int i = 0; i < 3; ++i) {
+        m_previousRight[i] = right[i];
+        m_previousIsosceles[i] = isosceles[i];
+    }
+    m_hasPrevious = true;
+}
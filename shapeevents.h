@@ -0,0 +1,46 @@
+#ifndef SHAPEEVENTS_H
+#define SHAPEEVENTS_H
+
+#include <QVector3D>
+#include "masssystem.h"
+
+// Статистика прохождений через особые кривые сферы форм
+struct ShapeEventStats {
+    quint64 acuteEntries = 0;       // переходы тупоугольный -> остроугольный
+    quint64 obtuseEntries[3] = {};  // переходы в тупой угол при вершине i
+    quint64 isoscelesCrossings[3] = {}; // по функциям MassSystem::isosceles
+    double lastAcuteEntry = -1.0;   // время последнего перехода (< 0 - не было)
+    double lastObtuseEntry = -1.0;
+    double lastIsoscelesCrossing = -1.0;
+    double acuteTime = 0.0;         // время, проведённое в каждой области
+    double obtuseTime = 0.0;
+    int region = -2;                // -1 - остроугольный, 0..2 - тупой угол, -2 - нет данных
+
+    quint64 obtuseEntryCount() const { return obtuseEntries[0] + obtuseEntries[1] + obtuseEntries[2]; }
+};
+
+// Счётчик событий по выборкам траектории: шесть аффинных функций ξ на выборку,
+// момент пересечения - линейная интерполяция функции между выборками.
+// Хранит только предыдущую выборку.
+class ShapeEventTracker
+{
+public:
+    void setMassSystem(const MassSystem& system);
+    // Следующая выборка начинает новый участок; накопленная статистика сохраняется
+    void reset();
+    void clearStats();
+
+    void feed(double t, const QVector3D& spherePoint);
+
+    const ShapeEventStats& stats() const { return m_stats; }
+
+private:
+    MassSystem m_system;
+    ShapeEventStats m_stats;
+    bool m_hasPrevious = false;
+    double m_previousTime = 0.0;
+    double m_previousRight[3] = {};
+    double m_previousIsosceles[3] = {};
+};
+
+#endif // SHAPEEVENTS_H
@@ -0,0 +1,90 @@
+#include "shapehistogram.h"
+#include <QColor>
+#include <algorithm>
+#include <cmath>
+
+ShapeHistogram::ShapeHistogram(int nside)
+    : m_grid(nside)
+    , m_counts(m_grid.pixelCount(), 0)
+{
+}
+
+int ShapeHistogram::visitedCells() const
+{
+    return static_cast<int>(std::count_if(m_counts.begin(), m_counts.end(), [](quint64 c) { return c > 0; }));
+}
+
+bool ShapeHistogram::merge(const ShapeHistogram& other)
+{
+    if (other.nside() != nside()) return false;
+    if (other.m_total == 0) return true;
+
+    quint64* counts = m_counts.data();
+    const quint64* source = other.m_counts.constData();
+    const int size = m_counts.size();
+    for (int k = 0; k < size; ++k) counts[k] += source[k];
+    m_total += other.m_total;
+    return true;
+}
+
+void ShapeHistogram::clear()
+{
+    if (m_total == 0) return;
+    m_counts.fill(0);
+    m_total = 0;
+}
+
+QVector<double> ShapeHistogram::relativeDensity() const
+{
+    QVector<double> density(m_counts.size(), 0.0);
+    if (m_total == 0) return density;
+
+    const double mean = double(m_total) / m_counts.size();
+    for (int k = 0; k < m_counts.size(); ++k) density[k] = m_counts[k] / mean;
+    return density;
+}
+
+QVector<double> ShapeHistogram::rasterize(const QVector<double>& density, int nside, int width, int height)
+{
+    const Healpix grid(nside);
+    QVector<double> values(width * height, 0.0);
+    if (density.size() != grid.pixelCount()) return values;
+
+    for (int j = 0; j < height; ++j) {
+        const double y = 1.0 - 2.0 * (j + 0.5) / height;
+        const double s = std::sqrt(std::max(0.0, 1.0 - y * y));
+        for (int i = 0; i < width; ++i) {
+            const double theta = 2.0 * M_PI * (i + 0.5) / width;
+            values[j * width + i] = density[grid.pixelOf(s * std::cos(theta), y, s * std::sin(theta))];
+        }
+    }
+    return values;
+}
+
+QImage ShapeHistogram::paint() const
+{
+    return paint(relativeDensity(), nside());
+}
+
+QImage ShapeHistogram::paint(const QVector<double>& density, int nside)
+{
+    return paint(rasterize(density, nside, TextureWidth, TextureHeight), TextureWidth, TextureHeight);
+}
+
+QImage ShapeHistogram::paint(const QVector<double>& density, int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGBA8888);
+    image.fill(QColor(40, 40, 40));
+    if (density.size() != width * height) return image;
+
+    // Шкала ±6 октав вокруг равномерной плотности
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            const double d = density[j * width + i];
+            if (!(d > 0)) continue;
+            const double f = qBound(0.0, (std::log2(d) + 6.0) / 12.0, 1.0);
+            image.setPixelColor(i, j, QColor::fromHsvF(0.66 * (1.0 - f), 0.85, 0.95));
+        }
+    }
+    return image;
+}
@@ -0,0 +1,71 @@
+#ifndef SHAPEHISTOGRAM_H
+#define SHAPEHISTOGRAM_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QImage>
+#include "healpix.h"
+
+// Счётчик посещений сферы форм по пикселям HEALPix (кольцевая нумерация,
+// см. Healpix): у всех пикселей одна площадь, поэтому число попаданий
+// сравнимо напрямую, а кольца постоянной широты сразу годятся для
+// гармонического анализа (SphericalHarmonics). Добавление - atan2 и
+// несколько умножений, память фиксирована; 64-битные счётчики не
+// переполняются и на 10^9 выборок. На текстуру сферы (равновеликая
+// сетка ансамбля) карта переносится в paint().
+// Гистограммы одного разрешения складываются, так что каждый поток копит
+// свою, а потребитель сливает их в общую.
+class ShapeHistogram
+{
+public:
+    static constexpr int DefaultNside = 64;         // 49152 пикселя, ≈ 0.9°
+    static constexpr int TextureWidth = 512;
+    static constexpr int TextureHeight = 256;
+
+    explicit ShapeHistogram(int nside = DefaultNside);
+
+    int nside() const { return m_grid.nside(); }
+    const Healpix& grid() const { return m_grid; }
+    int pixelCount() const { return m_counts.size(); }
+    quint64 total() const { return m_total; }
+    bool isEmpty() const { return m_total == 0; }
+    quint64 count(int pixel) const { return m_counts[pixel]; }
+    int visitedCells() const;
+
+    // Номер пикселя или -1 для нулевой или нечисловой точки
+    int binOf(const QVector3D& p) const { return m_grid.pixelOf(p); }
+
+    void add(const QVector3D& p)
+    {
+        const int bin = binOf(p);
+        if (bin < 0) return;
+        ++m_counts[bin];
+        ++m_total;
+    }
+
+    // false, если разрешения различаются
+    bool merge(const ShapeHistogram& other);
+    void clear();
+
+    // Число попаданий, делённое на среднее по пикселям (1 - равномерно), в порядке колец
+    QVector<double> relativeDensity() const;
+
+    // Значения по пикселям, перенесённые в центры ячеек равновеликой сетки width × height
+    static QVector<double> rasterize(const QVector<double>& density, int nside, int width, int height);
+
+    // Плотность относительно равномерной в логарифмической шкале на текстуре
+    // TextureWidth × TextureHeight: зелёный - как при равномерном заполнении,
+    // синий - реже, красный - чаще, непосещённые пиксели (и неположительная
+    // плотность) - тёмно-серые
+    QImage paint() const;
+    static QImage paint(const QVector<double>& density, int nside);
+    // То же для значений, уже заданных на равновеликой сетке width × height
+    static QImage paint(const QVector<double>& density, int width, int height);
+
+private:
+    Healpix m_grid;
+    QVector<quint64> m_counts;
+    quint64 m_total = 0;
+};
+
+#endif // SHAPEHISTOGRAM_H
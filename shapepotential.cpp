@@ -0,0 +1,278 @@
+#include "shapepotential.h"
+#include "coordtransform.h"
+#include "ensemble.h"
+#include "parallelfor.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QColor>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Точка сетки (θ, y) на сфере, чуть над поверхностью, чтобы линии не тонули в ней
+QVector3D contourPoint(double theta, double y)
+{
+    const double radius = 1.003;
+    const double rho = std::sqrt(std::max(0.0, 1.0 - y * y));
+    return QVector3D(radius * rho * std::cos(theta), radius * y, radius * rho * std::sin(theta));
+}
+
+}
+
+ShapePotentialRunner::ShapePotentialRunner(QObject* parent)
+    : QThread(parent)
+{
+}
+
+ShapePotentialRunner::~ShapePotentialRunner()
+{
+    stop();
+}
+
+bool ShapePotentialRunner::request(const QList<double>& masses)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_cache.size(); ++i) {
+        if (m_cache[i]->masses != masses) continue;
+        m_generation.fetch_add(1); // идущее построение больше не нужно
+        m_hasPending = false;
+        m_result = m_cache[i];
+        m_cache.move(i, 0);
+        return true;
+    }
+
+    m_pending.masses = masses;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+    return false;
+}
+
+void ShapePotentialRunner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void ShapePotentialRunner::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+std::shared_ptr<const ShapePotentialMap> ShapePotentialRunner::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+bool ShapePotentialRunner::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+double ShapePotentialRunner::potentialAt(const QVector3D& spherePoint, const QList<double>& masses)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    QVector<QPointF> points = CoordTransform::transformFromSphere(spherePoint, masses);
+    if (points.size() != 3) return nan;
+
+    const double total = masses[0] + masses[1] + masses[2];
+    QPointF center;
+    for (int i = 0; i < 3; ++i) center += masses[i] / total * points[i];
+
+    double u = 0.0, inertia = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        const QPointF d = points[i] - center;
+        inertia += masses[i] * (d.x() * d.x() + d.y() * d.y());
+        for (int j = i + 1; j < 3; ++j) {
+            const double r = QLineF(points[i], points[j]).length();
+            if (!(r > 0)) return nan;
+            u += masses[i] * masses[j] / r;
+        }
+    }
+    const double value = u * std::sqrt(inertia);
+    return std::isfinite(value) ? value : nan;
+}
+
+double ShapePotentialRunner::hillLevel(double energy, double angularMomentum)
+{
+    if (energy >= 0) return 0.0;
+    return std::sqrt(-2.0 * energy) * std::abs(angularMomentum);
+}
+
+QVector<QVector3D> ShapePotentialRunner::contour(const ShapePotentialMap& map, double level)
+{
+    QVector<QVector3D> segments;
+    const int width = map.width;
+    const int height = map.height;
+    if (width <= 0 || height <= 1 || map.values.size() != width * height) return segments;
+
+    auto value = [&](int i, int j) { return double(map.values[j * width + (i % width)]); };
+    auto theta = [&](double i) { return 2.0 * M_PI * (i + 0.5) / width; };
+    auto y = [&](double j) { return 1.0 - 2.0 * (j + 0.5) / height; };
+
+    for (int j = 0; j + 1 < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            // Углы ячейки: a (i, j), b (i+1, j), c (i+1, j+1), d (i, j+1)
+            const double corner[4] = {value(i, j), value(i + 1, j), value(i + 1, j + 1), value(i, j + 1)};
+            if (std::isnan(corner[0]) || std::isnan(corner[1]) || std::isnan(corner[2]) || std::isnan(corner[3])) {
+                continue;
+            }
+            const double ci[4] = {double(i), double(i + 1), double(i + 1), double(i)};
+            const double cj[4] = {double(j), double(j), double(j + 1), double(j + 1)};
+
+            // Пересечения на рёбрах ab, bc, cd, da
+            QVector3D cross[4];
+            bool crossed[4];
+            int count = 0;
+            for (int e = 0; e < 4; ++e) {
+                const int k = (e + 1) % 4;
+                crossed[e] = (corner[e] >= level) != (corner[k] >= level);
+                if (!crossed[e]) continue;
+                const double s = (level - corner[e]) / (corner[k] - corner[e]);
+                cross[e] = contourPoint(theta(ci[e] + s * (ci[k] - ci[e])), y(cj[e] + s * (cj[k] - cj[e])));
+                ++count;
+            }
+
+            if (count == 2) {
+                for (int e = 0; e < 4; ++e) {
+                    if (crossed[e]) segments.append(cross[e]);
+                }
+            } else if (count == 4) {
+                // Седло: решает среднее по ячейке. Если область b связна через центр,
+                // отсекаются углы a и c, иначе - b и d
+                const double center = 0.25 * (corner[0] + corner[1] + corner[2] + corner[3]);
+                if ((center >= level) == (corner[1] >= level)) {
+                    segments << cross[3] << cross[0] << cross[1] << cross[2];
+                } else {
+                    segments << cross[0] << cross[1] << cross[2] << cross[3];
+                }
+            }
+        }
+    }
+    return segments;
+}
+
+QImage ShapePotentialRunner::paint(const QVector<float>& values, int width, int height, float minimum, float maximum)
+{
+    QImage image(width, height, QImage::Format_RGBA8888);
+    image.fill(QColor(40, 40, 40));
+    if (!(minimum > 0) || !(maximum > minimum) || values.size() != width * height) return image;
+
+    // Логарифмическая шкала: низкий Ũ - синий, высокий - красный
+    const double logMin = std::log(minimum);
+    const double logRange = std::log(maximum) - logMin;
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            const float value = values[j * width + i];
+            if (!(value > 0) || !std::isfinite(value)) continue;
+            const double f = qBound(0.0, (std::log(value) - logMin) / logRange, 1.0);
+            image.setPixelColor(i, j, QColor::fromHsvF(0.7 * (1.0 - f), 0.6, 0.95));
+        }
+    }
+    return image;
+}
+
+std::shared_ptr<ShapePotentialMap> ShapePotentialRunner::build(const QList<double>& masses, int width,
+                                                               quint64 generation) const
+{
+    auto map = std::make_shared<ShapePotentialMap>();
+    map->masses = masses;
+    map->width = width;
+    map->height = width / 2;
+    map->values.resize(map->width * map->height);
+
+    float* values = map->values.data();
+    parallelFor(0, map->height, [&](int j) {
+        if (isCancelled(generation)) return;
+        for (int i = 0; i < map->width; ++i) {
+            const QVector3D point = EnsembleRunner::gridPoint(i, j, map->width, map->height);
+            values[j * map->width + i] = float(potentialAt(point, masses));
+        }
+    }, 1);
+    if (isCancelled(generation)) return nullptr;
+
+    // Шкала по 98-му процентилю: у точек соударений Ũ неограничен
+    QVector<float> finite;
+    finite.reserve(map->values.size());
+    for (float value : map->values) {
+        if (std::isfinite(value)) finite.append(value);
+    }
+    if (finite.isEmpty()) return map;
+
+    map->minimum = *std::min_element(finite.begin(), finite.end());
+    auto top = finite.begin() + (finite.size() - 1) * 98 / 100;
+    std::nth_element(finite.begin(), top, finite.end());
+    map->maximum = std::max(*top, map->minimum * 1.001f);
+
+    map->image = paint(map->values, map->width, map->height, map->minimum, map->maximum);
+    const double logMin = std::log(map->minimum);
+    const double logRange = std::log(map->maximum) - logMin;
+
+    // Линии уровня равномерно по log Ũ
+    for (int k = 0; k < ContourLevels; ++k) {
+        const double level = std::exp(logMin + logRange * (k + 0.5) / ContourLevels);
+        map->contours += contour(*map, level);
+    }
+    return map;
+}
+
+void ShapePotentialRunner::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // Каждый проход вдвое подробнее предыдущего
+        for (int width = MinWidth; width <= MaxWidth; width *= 2) {
+            std::shared_ptr<ShapePotentialMap> map;
+            try {
+                map = build(request.masses, width, request.generation);
+            }
+            catch (const std::exception& e) {
+                qWarning() << "Exception in ShapePotentialRunner:" << e.what();
+                break;
+            }
+            catch (...) {
+                qWarning() << "Unknown exception in ShapePotentialRunner";
+                break;
+            }
+            if (!map) break;
+
+            map->elapsedMs = timer.elapsed();
+            {
+                QMutexLocker locker(&m_mutex);
+                if (isCancelled(request.generation)) break;
+                m_result = map;
+                if (width * 2 > MaxWidth) {
+                    m_cache.prepend(map);
+                    while (m_cache.size() > CacheSize) m_cache.removeLast();
+                }
+            }
+            emit ready(width, map->elapsedMs);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef SHAPEPOTENTIAL_H
+#define SHAPEPOTENTIAL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <QVector3D>
+#include <QImage>
+#include <atomic>
+#include <memory>
+
+// Потенциал формы Ũ = U·√I (U = Σ mᵢmⱼ/rᵢⱼ, I = Σ mᵢ|rᵢ - c|²) не зависит
+// от масштаба и поворота, т.е. является функцией на сфере форм. Это
+// конформный множитель метрики Якоби-Мопертюи при L = 0; минимумы - в лагранжевых
+// точках, на точках соударений Ũ → ∞.
+// Из неравенства Сундмана при энергии E < 0 и моменте L форма достижима,
+// только если Ũ ≥ √(-2EL²) - линия уровня этой величины и есть граница области Хилла.
+struct ShapePotentialMap {
+    QList<double> masses;
+    int width = 0;                  // сетка ансамбля: θ по столбцам, y по строкам (строка 0 - y = 1)
+    int height = 0;
+    QVector<float> values;          // Ũ в центрах ячеек; NaN на особых точках
+    float minimum = 0.0f;
+    float maximum = 0.0f;           // верх шкалы раскраски (98-й процентиль)
+    QImage image;                   // текстура сферы
+    QVector<QVector3D> contours;    // линии уровня (пары концов отрезков)
+    qint64 elapsedMs = 0;
+};
+
+// Фоновое построение карты Ũ для тройки масс. Карта строится несколькими
+// проходами с удвоением сетки (64 → ... → MaxWidth), после каждого сфера
+// получает более подробную картинку. Готовые карты полного разрешения
+// запоминаются по тройке масс.
+class ShapePotentialRunner : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int MinWidth = 64;
+    static constexpr int MaxWidth = 512;
+    static constexpr int CacheSize = 8;
+    static constexpr int ContourLevels = 8;
+
+    explicit ShapePotentialRunner(QObject* parent = nullptr);
+    ~ShapePotentialRunner();
+
+    // true - карта уже в кэше и доступна через result(), сигнала не будет
+    bool request(const QList<double>& masses);
+    void cancel();
+    void stop();
+
+    std::shared_ptr<const ShapePotentialMap> result() const;
+
+    // Ũ для точки сферы; NaN на точках соударений
+    static double potentialAt(const QVector3D& spherePoint, const QList<double>& masses);
+    // Граница области Хилла: Ũ = √(-2EL²); 0, если ограничения нет
+    static double hillLevel(double energy, double angularMomentum);
+    // Раскраска значений сетки в логарифмической шкале [minimum, maximum]
+    static QImage paint(const QVector<float>& values, int width, int height, float minimum, float maximum);
+    // Линии уровня (marching squares по сетке; по θ сетка замкнута)
+    static QVector<QVector3D> contour(const ShapePotentialMap& map, double level);
+
+signals:
+    void ready(int width, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        QList<double> masses;
+        quint64 generation = 0;
+    };
+
+    bool isCancelled(quint64 generation) const;
+    std::shared_ptr<ShapePotentialMap> build(const QList<double>& masses, int width, quint64 generation) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const ShapePotentialMap> m_result;          // под m_mutex
+    QList<std::shared_ptr<const ShapePotentialMap>> m_cache;    // под m_mutex, свежие в начале
+};
+
+#endif // SHAPEPOTENTIAL_H
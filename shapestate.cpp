@@ -0,0 +1,130 @@
+#include "shapestate.h"
+#include "trajectoryspan.h"
+#include <cmath>
+
+QVector<ComplexSolution> ShapeState::solutions() const
+{
+    QVector<ComplexSolution> result;
+    result.reserve(rootCount);
+    for (int i = 0; i < rootCount; ++i) {
+        result.append(roots[i]);
+    }
+    return result;
+}
+
+ShapeState ShapeState::compute(const QList<QPointF>& points, const QList<double>& masses)
+{
+    ShapeState state;
+    if (points.size() != 3) return state;
+
+    for (int i = 0; i < 3; ++i) {
+        state.points[i] = points[i];
+    }
+
+    // Единственное преобразование треугольника за обновление
+    state.raw = CoordTransform::getRawSphereCoordinates(points, masses);
+    if (state.raw.isNull()) return state;
+
+    double norm = state.raw.length();
+    if (norm <= 0 || std::isnan(norm) || std::isinf(norm)) return state;
+
+    state.radius = norm;
+    state.normalized = state.raw / norm;
+    state.zeta = QPointF(state.normalized.x(), state.normalized.y());
+    state.rootCount = CoordTransform::transformZetaToZ(state.zeta, state.roots);
+    state.valid = true;
+
+    return state;
+}
+
+ShapeState ShapeState::interpolate(const ShapeState& a, const ShapeState& b, double f)
+{
+    if (!a.valid) return b;
+    if (!b.valid) return a;
+
+    const ShapeState& nearest = (f < 0.5) ? a : b;
+    ShapeState state = nearest;
+
+    for (int i = 0; i < 3; ++i) {
+        state.points[i] = a.points[i] + (b.points[i] - a.points[i]) * f;
+    }
+    state.raw = a.raw + (b.raw - a.raw) * float(f);
+    state.radius = a.radius + (b.radius - a.radius) * f;
+
+    QVector3D chord = a.normalized + (b.normalized - a.normalized) * float(f);
+    if (chord.isNull()) return nearest; // диаметрально противоположные точки
+    state.normalized = chord.normalized();
+    state.zeta = QPointF(state.normalized.x(), state.normalized.y());
+
+    // Корни интерполируем, только если набор ветвей совпадает и они не скачут
+    const double maxRootJump = 0.25;
+    if (a.rootCount == b.rootCount) {
+        for (int i = 0; i < a.rootCount; ++i) {
+            if (a.roots[i].branch != b.roots[i].branch) break;
+            QPointF delta = b.roots[i].point - a.roots[i].point;
+            if (std::abs(delta.x()) + std::abs(delta.y()) > maxRootJump) continue;
+            state.roots[i].point = a.roots[i].point + delta * f;
+        }
+    }
+
+    return state;
+}
+
+void TrajectoryBatch::clear()
+{
+    sphere.clear();
+    zeta.clear();
+    for (QVector<QPointF>& branch : roots) {
+        branch.clear();
+    }
+}
+
+void TrajectoryBatch::reserve(int count)
+{
+    sphere.reserve(count);
+    zeta.reserve(count);
+    for (QVector<QPointF>& branch : roots) {
+        branch.reserve(count);
+    }
+}
+
+void TrajectoryBatch::append(const ShapeState& state)
+{
+    if (!state.valid) {
+        appendBreak();
+        return;
+    }
+
+    sphere.append(state.normalized);
+    zeta.append(state.zeta);
+
+    QPointF branchPoints[4] = {
+        trajectoryBreakPoint(), trajectoryBreakPoint(),
+        trajectoryBreakPoint(), trajectoryBreakPoint()
+    };
+    for (int i = 0; i < state.rootCount; ++i) {
+        int branch = state.roots[i].branch;
+        if (branch >= 0 && branch < 4) {
+            branchPoints[branch] = state.roots[i].point;
+        }
+    }
+    for (int branch = 0; branch < 4; ++branch) {
+        roots[branch].append(branchPoints[branch]);
+    }
+}
+
+void TrajectoryBatch::appendBreak()
+{
+    sphere.append(trajectoryBreakVertex());
+    zeta.append(trajectoryBreakPoint());
+    for (QVector<QPointF>& branch : roots) {
+        branch.append(trajectoryBreakPoint());
+    }
+}
+
+void TrajectoryBatch::rootBuffers(const QPointF* buffers[4]) const
+{
+    for (int branch = 0; branch < 4; ++branch) {
+        buffers[branch] = roots[branch].constData();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef SHAPESTATE_H
+#define SHAPESTATE_H
+
+#include <QPointF>
+#include <QVector3D>
+#include <QList>
+#include <QVector>
+#include "coordtransform.h"
+
+// Снимок формы треугольника, вычисленный за один проход преобразований.
+// Сфера, обе комплексные плоскости и метки берут данные отсюда,
+// вместо того чтобы каждый раз заново пересчитывать ξ.
+struct ShapeState {
+    QPointF points[3];
+    QVector3D raw;          // ξ до нормализации
+    QVector3D normalized;   // точка на единичной сфере
+    double radius = 0.0;    // |ξ|
+    QPointF zeta;           // ζ = (ξ₂, ξ₃) нормализованной точки
+    ComplexSolution roots[4];
+    int rootCount = 0;
+    bool valid = false;
+
+    QVector<ComplexSolution> solutions() const;
+
+    static ShapeState compute(const QList<QPointF>& points, const QList<double>& masses);
+
+    // Промежуточное состояние между соседними выборками (f от 0 до 1).
+    // Точка на сфере интерполируется по хорде с нормировкой; корень берётся
+    // из ближайшей выборки, если ветвь между выборками перескочила.
+    static ShapeState interpolate(const ShapeState& a, const ShapeState& b, double f);
+};
+
+// Буферы для пакетной загрузки траекторий из последовательности форм:
+// точки сферы, ζ и корни по ветвям лежат подряд, разрывы - NaN-точки.
+// Отсутствующий на выборке корень тоже становится разрывом своей ветви.
+struct TrajectoryBatch {
+    QVector<QVector3D> sphere;
+    QVector<QPointF> zeta;
+    QVector<QPointF> roots[4];
+
+    void clear();
+    void reserve(int count);
+    int size() const { return sphere.size(); }
+    bool isEmpty() const { return sphere.isEmpty(); }
+
+    void append(const ShapeState& state);
+    void appendBreak();
+
+    // Указатели на буферы ветвей для ComplexPlaneView2::appendTrajectories
+    void rootBuffers(const QPointF* buffers[4]) const;
+};
+
+#endif // SHAPESTATE_H
@@ -0,0 +1,368 @@
+#include "simulationworker.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <chrono>
+#include <cmath>
+
+SimulationWorker::SimulationWorker(QObject* parent)
+    : QThread(parent)
+{
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    stop();
+}
+
+void SimulationWorker::setSource(std::shared_ptr<const PositionSource> source)
+{
+    QMutexLocker locker(&m_mutex);
+    m_source = std::move(source);
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_condition.wakeOne();
+}
+
+void SimulationWorker::setMasses(const QList<double>& masses)
+{
+    QMutexLocker locker(&m_mutex);
+    if (masses != m_masses) {
+        m_visits.clear();
+        ++m_visitsGeneration;
+    }
+    m_masses = masses;
+    m_massSystem = MassSystem::fromMasses(masses);
+}
+
+void SimulationWorker::setMaxTime(double maxTime)
+{
+    if (maxTime <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_maxTime = maxTime;
+}
+
+void SimulationWorker::setSpeed(double speed)
+{
+    if (speed <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_speed = speed;
+}
+
+void SimulationWorker::setSampleRate(double samplesPerSecond)
+{
+    if (samplesPerSecond <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_sampleRate = samplesPerSecond;
+    m_condition.wakeOne();
+}
+
+double SimulationWorker::sampleRate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sampleRate;
+}
+
+void SimulationWorker::setTrailTolerance(double sphereAngle, double zetaStep)
+{
+    if (sphereAngle <= 0 || zetaStep <= 0) return;
+    QMutexLocker locker(&m_mutex);
+    m_tolerance.sphereAngle = sphereAngle;
+    m_tolerance.zetaStep = zetaStep;
+}
+
+void SimulationWorker::setRecorder(std::shared_ptr<TrajectoryRecorder> recorder)
+{
+    QMutexLocker locker(&m_mutex);
+    m_recorder = std::move(recorder);
+    // Поток на паузе должен проснуться и закрыть отпущенную запись
+    m_condition.wakeOne();
+}
+
+void SimulationWorker::setTime(double t)
+{
+    QMutexLocker locker(&m_mutex);
+    m_time = t;
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_condition.wakeOne();
+}
+
+void SimulationWorker::setPlaying(bool playing)
+{
+    QMutexLocker locker(&m_mutex);
+    m_playing = playing;
+    m_condition.wakeOne();
+}
+
+bool SimulationWorker::isPlaying() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_playing;
+}
+
+void SimulationWorker::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+bool SimulationWorker::popSyzygy(SyzygyEvent& event)
+{
+    const quint64 epoch = m_epoch.load(std::memory_order_acquire);
+    while (m_syzygies.tryPop(event)) {
+        if (event.epoch == epoch) return true;
+    }
+    return false;
+}
+
+bool SimulationWorker::shapeEventStats(ShapeEventStats& stats)
+{
+    return m_shapeStats.read(stats);
+}
+
+bool SimulationWorker::takeVisits(ShapeHistogram& into)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_visits.isEmpty()) return false;
+    into.merge(m_visits);
+    m_visits.clear();
+    return true;
+}
+
+void SimulationWorker::clearVisits()
+{
+    QMutexLocker locker(&m_mutex);
+    m_visits.clear();
+    ++m_visitsGeneration;
+}
+
+bool SimulationWorker::popSample(ShapeSample& sample)
+{
+    const quint64 epoch = m_epoch.load(std::memory_order_acquire);
+    while (m_samples.tryPop(sample)) {
+        if (sample.epoch == epoch) return true;
+        // Выборка получена до перемотки - пропускаем
+    }
+    return false;
+}
+
+bool SimulationWorker::latestSample(ShapeSample& sample)
+{
+    ShapeSample latest;
+    if (!m_latest.read(latest)) return false;
+    if (latest.epoch != m_epoch.load(std::memory_order_acquire)) return false;
+    sample = latest;
+    return true;
+}
+
+void SimulationWorker::run()
+{
+    QElapsedTimer clock;
+    clock.start();
+    qint64 deadlineNs = 0;
+    qint64 lastSampleNs = 0;
+
+    ShapeSample previous;       // предыдущая выборка (для подразбиения)
+    ShapeState lastTrailState;  // последняя точка, отправленная в след
+
+    // Время записи монотонно: перемотки и зацикливание не отматывают его назад
+    std::shared_ptr<TrajectoryRecorder> activeRecorder;
+    double recordedTime = 0.0;
+
+    // Детектор держит указатель на источник, поэтому храним и ссылку на него
+    std::shared_ptr<const PositionSource> syzygySource;
+    SyzygyDetector syzygies;
+
+    // Постоянные масс пересчитываются только при их смене
+    MassSystem activeMassSystem;
+    ShapeEventTracker shapeEvents;
+    quint64 shapeEventsEpoch = 0;
+
+    // Посещения копятся локально и сливаются в m_visits раз в VisitsFlushNs
+    static constexpr qint64 VisitsFlushNs = 100000000;
+    ShapeHistogram visits;
+    quint64 visitsGeneration = 0;
+    qint64 visitsFlushNs = 0;
+
+    forever {
+        std::shared_ptr<const PositionSource> source;
+        QList<double> masses;
+        MassSystem massSystem;
+        AdaptiveSampler::Tolerance tolerance;
+        std::shared_ptr<TrajectoryRecorder> recorder;
+        ShapeSample sample;
+        qint64 intervalNs = 0;
+        double step = 0.0;
+        quint64 generation = 0;
+
+        {
+            QMutexLocker locker(&m_mutex);
+
+            // Посещения сливаются под той же блокировкой, перед паузой - сразу;
+            // накопленное до сброса поколение отбрасывается
+            if (!visits.isEmpty() && (!m_playing || clock.nsecsElapsed() - visitsFlushNs >= VisitsFlushNs)) {
+                if (visitsGeneration == m_visitsGeneration) m_visits.merge(visits);
+                visits.clear();
+                visitsFlushNs = clock.nsecsElapsed();
+            }
+
+            bool waited = false;
+            forever {
+                // Снятая запись дописывается и закрывается сразу, а не после паузы:
+                // иначе файл на диске остаётся неполным, пока воспроизведение стоит
+                if (activeRecorder && activeRecorder != m_recorder) {
+                    std::shared_ptr<TrajectoryRecorder> finished = std::move(activeRecorder);
+                    activeRecorder.reset();
+                    locker.unlock();
+                    finished->close();
+                    finished.reset();
+                    locker.relock();
+                }
+                if (m_abort || (m_playing && m_source)) break;
+                m_condition.wait(&m_mutex);
+                waited = true;
+            }
+            if (m_abort) return;
+
+            // После паузы начинаем отсчёт заново, а не догоняем пропущенное
+            if (waited) {
+                deadlineNs = clock.nsecsElapsed();
+                lastSampleNs = deadlineNs;
+            }
+
+            // Ждём момента следующей выборки; изменение параметров будит раньше
+            qint64 remainingNs = deadlineNs - clock.nsecsElapsed();
+            if (remainingNs > 0) {
+                m_condition.wait(&m_mutex, QDeadlineTimer(std::chrono::nanoseconds(remainingNs)));
+                continue;
+            }
+
+            intervalNs = static_cast<qint64>(1e9 / m_sampleRate);
+
+            // Модельное время идёт по измеренному реальному времени,
+            // поэтому пропущенные или запоздавшие выборки не меняют скорость
+            const qint64 nowNs = clock.nsecsElapsed();
+            const double elapsed = (nowNs - lastSampleNs) * 1e-9;
+            lastSampleNs = nowNs;
+
+            step = TimePerSecond * m_speed * elapsed;
+            m_time += step;
+            sample.wrapped = m_time > m_maxTime;
+            if (sample.wrapped) {
+                m_time = std::fmod(m_time, m_maxTime);
+            }
+
+            sample.time = m_time;
+            sample.epoch = m_epoch.load(std::memory_order_relaxed);
+            source = m_source;
+            masses = m_masses;
+            massSystem = m_massSystem;
+            tolerance = m_tolerance;
+            recorder = m_recorder;
+            generation = m_visitsGeneration;
+        }
+
+        if (generation != visitsGeneration) {
+            visitsGeneration = generation;
+            visits.clear();
+        }
+
+        if (recorder != activeRecorder) {
+            activeRecorder = recorder;
+            recordedTime = 0.0;
+        }
+
+        if (massSystem.valid != activeMassSystem.valid || massSystem.m1 != activeMassSystem.m1 ||
+            massSystem.m2 != activeMassSystem.m2 || massSystem.m3 != activeMassSystem.m3) {
+            activeMassSystem = massSystem;
+            shapeEvents.setMassSystem(activeMassSystem);
+            shapeEvents.clearStats();
+        }
+        if (sample.epoch != shapeEventsEpoch) {
+            shapeEventsEpoch = sample.epoch;
+            shapeEvents.clearStats();
+        }
+
+        if (source != syzygySource) {
+            syzygySource = source;
+            syzygies.setSource(syzygySource.get());
+        }
+
+        // Если поток отстал больше чем на интервал, не пытаемся наверстать пачкой
+        deadlineNs = qMax(deadlineNs + intervalNs, clock.nsecsElapsed() - intervalNs);
+
+        try {
+            AdaptiveSampler sampler(*source, masses, tolerance);
+            sample.state = sampler.evaluate(sample.time);
+            if (!sample.state.valid) continue;
+
+            auto pushTrail = [&](const ShapeSample& trailSample) {
+                if (!m_samples.tryPush(trailSample)) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                lastTrailState = trailSample.state;
+            };
+
+            auto detectEvents = [&](double t, const ShapeState& state) {
+                shapeEvents.feed(t, state.normalized);
+
+                SyzygyEvent event;
+                if (!syzygies.feed(t, state.points, event)) return;
+                event.epoch = sample.epoch;
+                m_syzygyCount.fetch_add(1, std::memory_order_relaxed);
+                if (!m_syzygies.tryPush(event)) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            };
+
+            const bool continuous = previous.state.valid && previous.epoch == sample.epoch &&
+                                    !sample.wrapped && sample.time > previous.time;
+            if (continuous) {
+                // Быстрые участки подразбиваем, медленные прореживаем
+                sampler.refine(previous.time, previous.state, sample.time, sample.state,
+                               [&](double t, const ShapeState& state) {
+                    detectEvents(t, state);
+                    if (recorder) {
+                        recorder->append(recordedTime + (t - previous.time), state, false);
+                    }
+                    if (sampler.isNegligible(lastTrailState, state)) {
+                        m_skipped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    ShapeSample trailSample;
+                    trailSample.time = t;
+                    trailSample.epoch = sample.epoch;
+                    trailSample.state = state;
+                    pushTrail(trailSample);
+                });
+                m_refined.fetch_add(sampler.extraEvaluations(), std::memory_order_relaxed);
+                recordedTime += sample.time - previous.time;
+            } else {
+                syzygies.reset();
+                shapeEvents.reset();
+                detectEvents(sample.time, sample.state);
+                pushTrail(sample);
+                recordedTime += step;
+                if (recorder) {
+                    recorder->append(recordedTime, sample.state, true);
+                }
+            }
+
+            visits.add(sample.state.normalized);
+            m_latest.write(sample);
+            m_shapeStats.write(shapeEvents.stats());
+            previous = sample;
+            m_produced.fetch_add(1, std::memory_order_relaxed);
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in SimulationWorker:" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in SimulationWorker";
+        }
+    }
+}
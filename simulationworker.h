@@ -0,0 +1,125 @@
+#ifndef SIMULATIONWORKER_H
+#define SIMULATIONWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <atomic>
+#include <memory>
+#include "shapestate.h"
+#include "positionsource.h"
+#include "spscring.h"
+#include "triplebuffer.h"
+#include "adaptivesampler.h"
+#include "trajectoryrecording.h"
+#include "syzygydetector.h"
+#include "shapeevents.h"
+#include "shapehistogram.h"
+
+// Одна выборка анимации: время и уже вычисленная форма треугольника
+struct ShapeSample {
+    double time = 0.0;
+    bool wrapped = false;   // время перескочило с maxTime на 0 - траектории разрываются
+    quint64 epoch = 0;      // номер перемотки, при которой выборка получена
+    ShapeState state;
+};
+
+// Поток симуляции: ведёт модельное время по реальным часам (время × скорость),
+// вычисляет положения тел и ShapeState с собственной частотой выборки,
+// независимой от частоты отрисовки.
+// Все выборки идут в ограниченную SPSC-очередь (для траекторий),
+// последняя дополнительно - в тройной буфер (для точек и меток).
+// Между соседними выборками след уточняется AdaptiveSampler по допуску в пикселях.
+// GUI забирает их раз за кадр через popSample/latestSample.
+// Сизигии ищутся по всем выборкам (включая уточнённые) и идут в свою очередь;
+// там же считаются переходы через прямоугольные и равнобедренные кривые.
+// Основные (равномерные по времени) выборки копятся в гистограмме посещений
+// сферы; уточнённые в неё не идут, иначе быстрые участки весили бы больше.
+class SimulationWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit SimulationWorker(QObject* parent = nullptr);
+    ~SimulationWorker();
+
+    // Параметры (вызываются из GUI)
+    void setSource(std::shared_ptr<const PositionSource> source);
+    void setMasses(const QList<double>& masses);
+    void setMaxTime(double maxTime);
+    void setSpeed(double speed);
+    void setSampleRate(double samplesPerSecond);
+    double sampleRate() const;
+
+    // Допуск следа: угловой шаг на сфере и шаг в плоскости ζ (обычно ~1 пиксель)
+    void setTrailTolerance(double sphereAngle, double zetaStep);
+
+    // Запись прогона: каждая выборка (включая уточнённые) дописывается в файл
+    // из потока симуляции. nullptr останавливает запись; файл закрывается,
+    // когда отпущена последняя ссылка.
+    void setRecorder(std::shared_ptr<TrajectoryRecorder> recorder);
+
+    // Перемотка; выборки, полученные до неё, отбрасываются
+    void setTime(double t);
+    void setPlaying(bool playing);
+    bool isPlaying() const;
+    void stop();
+
+    // Потребитель (только GUI-поток)
+    bool popSample(ShapeSample& sample);
+    bool latestSample(ShapeSample& sample);
+    bool popSyzygy(SyzygyEvent& event);
+    // Статистика областей с последней перемотки; false, если не обновилась
+    bool shapeEventStats(ShapeEventStats& stats);
+    // Добавляет накопленные посещения сферы в into и обнуляет их; false, если новых нет
+    bool takeVisits(ShapeHistogram& into);
+    // Посещения сбрасываются и при смене масс
+    void clearVisits();
+
+    quint64 producedCount() const { return m_produced.load(std::memory_order_relaxed); }
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    quint64 refinedCount() const { return m_refined.load(std::memory_order_relaxed); }
+    quint64 skippedCount() const { return m_skipped.load(std::memory_order_relaxed); }
+    quint64 syzygyCount() const { return m_syzygyCount.load(std::memory_order_relaxed); }
+
+    // Модельное время за секунду реального при скорости 1 (как прежний шаг 0.1 каждые 50 мс)
+    static constexpr double TimePerSecond = 2.0;
+
+protected:
+    void run() override;
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    std::shared_ptr<const PositionSource> m_source;
+    QList<double> m_masses;
+    MassSystem m_massSystem;
+    double m_maxTime = 20.0;
+    double m_speed = 1.0;
+    double m_sampleRate = 100.0;
+    double m_time = 0.0;
+    bool m_playing = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_epoch{0};
+    std::atomic<quint64> m_produced{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_refined{0};  // дополнительные вычисления при подразбиении
+    std::atomic<quint64> m_skipped{0};  // точки следа, отброшенные как неразличимые
+    std::atomic<quint64> m_syzygyCount{0};
+    AdaptiveSampler::Tolerance m_tolerance;
+    std::shared_ptr<TrajectoryRecorder> m_recorder;
+
+    SpscRing<ShapeSample> m_samples{4096};
+    TripleBuffer<ShapeSample> m_latest;
+    SpscRing<SyzygyEvent> m_syzygies{1024};
+    TripleBuffer<ShapeEventStats> m_shapeStats;
+
+    // Посещения, слитые из потока симуляции (под m_mutex); поколение растёт
+    // при сбросе, и накопленное до него в потоке отбрасывается
+    ShapeHistogram m_visits;
+    quint64 m_visitsGeneration = 0;
+};
+
+#endif // SIMULATIONWORKER_H
@@ -3,18 +3,20 @@
 #include <QWheelEvent>
 #include <QOpenGLShaderProgram>
 #include <cmath>
+#include <QtMath>
 #include <QDebug>
 #include <QApplication>
 #include <QOpenGLContext>
 #include <QGraphicsOpacityEffect>
+#include "trajectoryspan.h"
 
 SphereWidget::SphereWidget(QWidget* parent)
     : QOpenGLWidget(parent), m_sphereRadius(1.0), spherePoint(0, 0, 1), rotation(1, 0, 0, 0),
     m_masses({1.0, 1.0, 1.0}), distance(5.0f), isDraggingPoint(false),
     isRotatingSphere(false), m_showTrajectory(false)
 {
-    m_trajectorySegments.append(QVector<QVector3D>());
-    m_trajectorySegmentColors.append(QVector<QVector3D>());
+    m_trajectoryRanges.append(TrajectoryRange());
+    m_massSystem = MassSystem::fromMasses(m_masses);
     setMinimumSize(400, 400);
     setFocusPolicy(Qt::StrongFocus);
 
@@ -28,6 +30,51 @@ SphereWidget::SphereWidget(QWidget* parent)
 }
 
 SphereWidget::~SphereWidget() {
+    if (m_trajectoryBuffer.isCreated() || m_contourBuffer.isCreated() || m_overlayTexture || m_potentialTexture) {
+        makeCurrent();
+        if (m_trajectoryBuffer.isCreated()) m_trajectoryBuffer.destroy();
+        if (m_contourBuffer.isCreated()) m_contourBuffer.destroy();
+        if (m_overlayTexture) glDeleteTextures(1, &m_overlayTexture);
+        if (m_potentialTexture) glDeleteTextures(1, &m_potentialTexture);
+        doneCurrent();
+    }
+}
+
+void SphereWidget::setOutcomeOverlay(const QImage& overlay) {
+    m_outcomeOverlay = overlay.convertToFormat(QImage::Format_RGBA8888);
+    m_overlayDirty = true;
+    update();
+}
+
+void SphereWidget::clearOutcomeOverlay() {
+    m_outcomeOverlay = QImage();
+    m_overlayDirty = true;
+    update();
+}
+
+void SphereWidget::setPotentialMap(const QImage& image, const QVector<QVector3D>& contours,
+                                   const QVector<QVector3D>& hillBoundary) {
+    m_potentialImage = image.convertToFormat(QImage::Format_RGBA8888);
+    m_potentialDirty = true;
+    m_potentialContours = contours;
+    m_hillBoundary = hillBoundary;
+    m_contourBufferDirty = true;
+    update();
+}
+
+void SphereWidget::setHillBoundary(const QVector<QVector3D>& hillBoundary) {
+    m_hillBoundary = hillBoundary;
+    m_contourBufferDirty = true;
+    update();
+}
+
+void SphereWidget::clearPotentialMap() {
+    m_potentialImage = QImage();
+    m_potentialDirty = true;
+    m_potentialContours.clear();
+    m_hillBoundary.clear();
+    m_contourBufferDirty = true;
+    update();
 }
 
 QVector3D SphereWidget::getPoint() const {
@@ -105,6 +152,13 @@ void SphereWidget::resizeGL(int w, int h) {
     projection.perspective(45.0f, aspect, 0.1f, 100.0f);
 }
 
+double SphereWidget::pixelsPerUnit() const {
+    // Перспектива 45° по вертикали, ближняя точка сферы на расстоянии distance - 1
+    const double halfFov = qDegreesToRadians(45.0 / 2.0);
+    const double depth = qMax(0.1, double(distance) - 1.0);
+    return (height() / 2.0) / (std::tan(halfFov) * depth);
+}
+
 void SphereWidget::paintGL() {
     if (!isValid()) {
         qCritical() << "OpenGL context is not valid in paintGL";
@@ -126,6 +180,7 @@ void SphereWidget::paintGL() {
     // Сначала рисуем непрозрачные элементы
     glDisable(GL_LIGHTING);
     drawSpecialLines();
+    drawPotentialContours();
     drawCollisionPoints();
     drawEquilateralPoints();
     drawPoles();
@@ -285,8 +340,22 @@ QVector3D SphereWidget::projectToScreen(const QVector3D& point) const {
 }
 
 void SphereWidget::drawSphere() {
-    const int segments = 36;
-    const int rings = 18;
+    // Загрузка текстур (контекст в paintGL уже текущий)
+    if (m_overlayDirty) {
+        m_overlayDirty = false;
+        uploadTexture(m_outcomeOverlay, m_overlayTexture, false);
+    }
+    if (m_potentialDirty) {
+        m_potentialDirty = false;
+        uploadTexture(m_potentialImage, m_potentialTexture, true);
+    }
+    // Карта исходов важнее фона потенциала
+    const GLuint texture = m_overlayTexture ? m_overlayTexture : m_potentialTexture;
+    const bool textured = texture != 0;
+
+    // С картой сетка мельче: текстурные координаты линейны по y, а не по φ
+    const int segments = textured ? 96 : 36;
+    const int rings = textured ? 48 : 18;
     const float radius = 1.0f;
 
     glEnable(GL_CULL_FACE);
@@ -300,6 +369,12 @@ void SphereWidget::drawSphere() {
 
     // Устанавливаем серый цвет с прозрачностью
     glColor4f(0.7f, 0.7f, 0.7f, 0.75f);
+    if (textured) {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glColor4f(1.0f, 1.0f, 1.0f, 0.9f);
+    }
 
     // Отключаем specular для устранения цветных бликов
     GLfloat mat_specular[] = {0.0f, 0.0f, 0.0f, 1.0f};
@@ -323,17 +398,82 @@ void SphereWidget::drawSphere() {
                 float z = radius * sin(phi) * sin(theta);
 
                 glNormal3f(x, y, z);
+                if (textured) glTexCoord2f(theta / (2.0f * M_PI), 0.5f * (1.0f - y));
                 glVertex3f(x, y, z);
             }
         }
         glEnd();
     }
 
+    if (textured) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
     glDisable(GL_COLOR_MATERIAL);
     glDisable(GL_CULL_FACE);
     glDisable(GL_BLEND);
 }
 
+void SphereWidget::uploadTexture(const QImage& image, GLuint& texture, bool smooth) {
+    if (image.isNull()) {
+        if (texture) {
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+        return;
+    }
+
+    if (!texture) glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(),
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SphereWidget::drawPotentialContours() {
+    if (m_potentialContours.isEmpty() && m_hillBoundary.isEmpty()) return;
+
+    // Отрезки загружаются в VBO только после смены карты или границы; вращение их не трогает
+    if (!m_contourBuffer.isCreated()) {
+        m_contourBuffer.create();
+        m_contourBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        m_contourBufferDirty = true;
+    }
+    m_contourBuffer.bind();
+    if (m_contourBufferDirty) {
+        const int contourBytes = int(m_potentialContours.size() * sizeof(QVector3D));
+        const int hillBytes = int(m_hillBoundary.size() * sizeof(QVector3D));
+        m_contourBuffer.allocate(contourBytes + hillBytes);
+        m_contourBuffer.write(0, m_potentialContours.constData(), contourBytes);
+        m_contourBuffer.write(contourBytes, m_hillBoundary.constData(), hillBytes);
+        m_contourBufferDirty = false;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(QVector3D), nullptr);
+
+    // Линии уровня Ũ - тонкие тёмные, граница области Хилла - толстая белая
+    if (!m_potentialContours.isEmpty()) {
+        glLineWidth(1.0f);
+        glColor3f(0.15f, 0.15f, 0.15f);
+        glDrawArrays(GL_LINES, 0, int(m_potentialContours.size()));
+    }
+    if (!m_hillBoundary.isEmpty()) {
+        glLineWidth(3.0f);
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glDrawArrays(GL_LINES, int(m_potentialContours.size()), int(m_hillBoundary.size()));
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    m_contourBuffer.release();
+    glLineWidth(1.0f);
+}
+
 void SphereWidget::drawCoordinateSystem() {
     glLineWidth(2.0f);
     glBegin(GL_LINES);
@@ -492,76 +632,37 @@ void SphereWidget::drawSpecialLines() {
     }
     glEnd();
 
-    double m1 = m_masses[0];
-    double m2 = m_masses[1];
-    double m3 = m_masses[2];
-
-    // Calculate reduced masses
-    double denominator1 = m1 + m2;
-    double denominator2 = m1 + m2 + m3;
-
-    if (denominator1 <= 0 || denominator2 <= 0) return;
+    if (!m_massSystem.valid) return;
 
-    double mu1 = (m1 * m2) / denominator1;
-    double mu2 = (m3 * (m1 + m2)) / denominator2;
-
-    // Calculate k parameter
-    double k = (m1 / denominator1) * std::sqrt(mu2 / mu1);
-    double k2 = k * k;
-    double denom = 1.0 + k2;
-
-    // Condition 1: Right angle at vertex r2 (xi2 = k*(1+xi1))
+    // Прямоугольные треугольники: плоские сечения rightAngle[i](ξ) = 0.
+    // При m1 = m2 это окружности ξ2 = ±k(1 + ξ1) и ξ1 = (1 - k²)/(1 + k²)
     glColor3f(0.0f, 1.0f, 1.0f); // Cyan
-    glBegin(GL_LINE_LOOP);
-    for (int i = 0; i <= resolution; i++) {
-        double theta = 2.0 * M_PI * i / resolution;
-        double sin_theta = std::sin(theta);
-        double cos_theta = std::cos(theta);
-
-        double x = k / denom * (1.0 + sin_theta);
-        double y = cos_theta / std::sqrt(denom);
-        double z = (-k2 + sin_theta) / denom;
-
-        glVertex3f(x, y, z);
+    for (int i = 0; i < 3; ++i) {
+        drawPlaneSection(m_massSystem.rightAngle[i], resolution);
     }
-    glEnd();
-
-    // Condition 2: Right angle at vertex r1 (xi2 = -k*(1+xi1))
-    // Отражение относительно плоскости x = -z
-    glColor3f(0.0f, 1.0f, 1.0f);
-    glBegin(GL_LINE_LOOP);
-    for (int i = 0; i <= resolution; i++) {
-        double theta = 2.0 * M_PI * i / resolution;
-        double sin_theta = std::sin(theta);
-        double cos_theta = std::cos(theta);
+}
 
-        // Оригинальные координаты (как в условии 1)
-        double x_orig = k / denom * (1.0 + sin_theta);
-        double y_orig = cos_theta / std::sqrt(denom);
-        double z_orig = (-k2 + sin_theta) / denom;
+void SphereWidget::drawPlaneSection(const MassSystem::Plane& plane, int resolution) {
+    // Плоскость c0 + n·p = 0 с нормалью n = (c2, 0, c1) в координатах сферы
+    QVector3D normal(plane.c2, 0.0f, plane.c1);
+    double length = normal.length();
+    if (length <= 0) return;
+    normal /= length;
 
-        // Отражение относительно плоскости x = -z
-        double x = -x_orig;
-        double y = y_orig;
-        double z = z_orig;
+    double offset = -plane.c0 / length; // расстояние плоскости от центра
+    if (std::abs(offset) >= 1.0) return;
+    double radius = std::sqrt(1.0 - offset * offset);
 
-        glVertex3f(x, y, z);
-    }
-    glEnd();
+    // Базис в плоскости: ось y лежит в ней всегда, вторая ось - n × y
+    QVector3D u(0.0f, 1.0f, 0.0f);
+    QVector3D v = QVector3D::crossProduct(normal, u);
+    QVector3D center = normal * offset;
 
-    // Condition 3: Right angle at vertex r3 (xi2^2 + xi3^2 = k^2*(1+xi1)^2)
-    glColor3f(0.0f, 1.0f, 1.0f);
     glBegin(GL_LINE_LOOP);
-    for (int i = 0; i <= resolution; i++) {
+    for (int i = 0; i < resolution; i++) {
         double theta = 2.0 * M_PI * i / resolution;
-
-        // Это окружность на постоянной широте
-        double phi0 = 2.0 * std::atan(k);
-        double x = std::sin(phi0) * std::cos(theta);
-        double y = std::sin(phi0) * std::sin(theta);
-        double z = std::cos(phi0);
-
-        glVertex3f(x, y, z);
+        QVector3D p = center + radius * (std::cos(theta) * u + std::sin(theta) * v);
+        glVertex3f(p.x(), p.y(), p.z());
     }
     glEnd();
 }
@@ -586,6 +687,7 @@ void SphereWidget::setMasses(const QList<double>& masses)
 
     if (valid) {
         m_masses = masses;
+        m_massSystem = MassSystem::fromMasses(masses);
         update(); // Перерисовываем сцену с новыми точками соударения
     }
 }
@@ -631,11 +733,12 @@ void SphereWidget::setShowTrajectory(bool show)
 
 void SphereWidget::clearTrajectory()
 {
-    m_trajectorySegments.clear();
-    m_trajectorySegmentColors.clear();
+    m_trajectoryVertices.clear();
+    m_trajectoryRanges.clear();
+    m_deadTrajectoryVertices = 0;
     // Создаем первый пустой сегмент
-    m_trajectorySegments.append(QVector<QVector3D>());
-    m_trajectorySegmentColors.append(QVector<QVector3D>());
+    m_trajectoryRanges.append(TrajectoryRange());
+    m_trajectoryBufferDirty = true;
     update();
 }
 
@@ -643,53 +746,129 @@ void SphereWidget::addToTrajectory(const QVector3D& point)
 {
     if (!m_drawingEnabled) return;
 
-    if (m_trajectorySegments.isEmpty()) {
-        m_trajectorySegments.append(QVector<QVector3D>());
-        m_trajectorySegmentColors.append(QVector<QVector3D>());
+    if (m_trajectoryRanges.isEmpty()) {
+        m_trajectoryRanges.append(TrajectoryRange{int(m_trajectoryVertices.size()), 0});
     }
 
-    m_trajectorySegments.last().append(point);
+    m_trajectoryVertices.append(point);
+    TrajectoryRange& range = m_trajectoryRanges.last();
+    range.count++;
 
-    // Яркий бирюзовый цвет для траектории (лучшая видимость)
-    float t = static_cast<float>(m_trajectorySegments.last().size()) / 1000.0f;
-    QVector3D color(0.0f, 0.8f + 0.2f * t, 1.0f - 0.5f * t); // От бирюзового к синему
-    m_trajectorySegmentColors.last().append(color);
+    trimLiveTrajectory();
+    m_trajectoryBufferDirty = true;
+    update();
+}
+
+void SphereWidget::appendTrajectory(const QVector3D* points, int count)
+{
+    if (!m_drawingEnabled || !points || count <= 0) return;
 
-    // Ограничиваем длину каждого сегмента для производительности
-    if (m_trajectorySegments.last().size() > 1000) {
-        m_trajectorySegments.last().removeFirst();
-        m_trajectorySegmentColors.last().removeFirst();
+    appendTrajectorySpan(points, count);
+    trimLiveTrajectory();
+    m_trajectoryBufferDirty = true;
+    update();
+}
+
+void SphereWidget::trimLiveTrajectory()
+{
+    // Ограничиваем длину живого сегмента для производительности;
+    // обрезанное начало уплотняется пакетно
+    TrajectoryRange& range = m_trajectoryRanges.last();
+    if (range.count <= LiveTrajectoryLimit) return;
+
+    const int excess = range.count - LiveTrajectoryLimit;
+    range.first += excess;
+    range.count -= excess;
+    m_deadTrajectoryVertices += excess;
+    if (m_deadTrajectoryVertices > m_trajectoryVertices.size() / 2) {
+        compactTrajectory();
     }
+}
 
+void SphereWidget::replaceTrajectory(const QVector3D* points, int count)
+{
+    if (!m_drawingEnabled) return;
+
+    m_trajectoryVertices.clear();
+    m_trajectoryRanges.clear();
+    m_deadTrajectoryVertices = 0;
+    m_trajectoryRanges.append(TrajectoryRange());
+
+    if (points && count > 0) {
+        appendTrajectorySpan(points, count);
+    }
+    m_trajectoryBufferDirty = true;
     update();
 }
 
+void SphereWidget::appendTrajectorySpan(const QVector3D* points, int count)
+{
+    if (m_trajectoryRanges.isEmpty()) {
+        m_trajectoryRanges.append(TrajectoryRange{int(m_trajectoryVertices.size()), 0});
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (isTrajectoryBreak(points[i])) {
+            if (m_trajectoryRanges.last().count > 0) {
+                m_trajectoryRanges.append(TrajectoryRange{int(m_trajectoryVertices.size()), 0});
+            }
+            continue;
+        }
+        m_trajectoryVertices.append(points[i]);
+        m_trajectoryRanges.last().count++;
+    }
+}
+
+void SphereWidget::compactTrajectory()
+{
+    QVector<QVector3D> vertices;
+    vertices.reserve(m_trajectoryVertices.size() - m_deadTrajectoryVertices);
+    for (TrajectoryRange& range : m_trajectoryRanges) {
+        int first = vertices.size();
+        vertices.append(m_trajectoryVertices.mid(range.first, range.count));
+        range.first = first;
+    }
+    m_trajectoryVertices.swap(vertices);
+    m_deadTrajectoryVertices = 0;
+}
+
 void SphereWidget::drawTrajectory()
 {
-    if (!m_showTrajectory || m_trajectorySegments.isEmpty()) {
+    if (!m_showTrajectory || m_trajectoryVertices.isEmpty()) {
         return;
     }
 
+    // Вершины загружаются в VBO один раз за кадр, сколько бы точек ни добавилось
+    if (!m_trajectoryBuffer.isCreated()) {
+        m_trajectoryBuffer.create();
+        m_trajectoryBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        m_trajectoryBufferDirty = true;
+    }
+    m_trajectoryBuffer.bind();
+    if (m_trajectoryBufferDirty) {
+        m_trajectoryBuffer.allocate(m_trajectoryVertices.constData(),
+                                    int(m_trajectoryVertices.size() * sizeof(QVector3D)));
+        m_trajectoryBufferDirty = false;
+    }
+
     glDisable(GL_LIGHTING);
 
     // Увеличим толщину линии траектории для лучшей видимости
     glLineWidth(4.0f);
+    glColor3f(1.0f, 0.0f, 0.0f);
 
-    // Рисуем каждый сегмент отдельно
-    for (int seg = 0; seg < m_trajectorySegments.size(); ++seg) {
-        const auto& segment = m_trajectorySegments[seg];
-
-        if (segment.size() < 2) continue;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(QVector3D), nullptr);
 
-        glBegin(GL_LINE_STRIP);
-        for (int i = 0; i < segment.size(); ++i) {
-            // Используем градиент цвета
-            glColor3f(1.0f, 0.0f, 0.0f);
-            glVertex3f(segment[i].x(), segment[i].y(), segment[i].z());
-        }
-        glEnd();
+    // Рисуем каждый сегмент отдельно
+    for (const TrajectoryRange& range : m_trajectoryRanges) {
+        if (range.count < 2) continue;
+        glDrawArrays(GL_LINE_STRIP, range.first, range.count);
     }
 
+    glDisableClientState(GL_VERTEX_ARRAY);
+    m_trajectoryBuffer.release();
+
     glLineWidth(1.0f);
     glEnable(GL_LIGHTING);
 }
@@ -697,9 +876,8 @@ void SphereWidget::drawTrajectory()
 void SphereWidget::breakTrajectory()
 {
     // Создаем новый сегмент траектории
-    if (!m_trajectorySegments.isEmpty() && !m_trajectorySegments.last().isEmpty()) {
-        m_trajectorySegments.append(QVector<QVector3D>());
-        m_trajectorySegmentColors.append(QVector<QVector3D>());
+    if (!m_trajectoryRanges.isEmpty() && m_trajectoryRanges.last().count > 0) {
+        m_trajectoryRanges.append(TrajectoryRange{int(m_trajectoryVertices.size()), 0});
     }
 }
 
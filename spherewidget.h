@@ -8,6 +8,9 @@
 #include <QQuaternion>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QOpenGLBuffer>
+#include <QImage>
+#include "masssystem.h"
 
 class SphereWidget : public QOpenGLWidget, protected QOpenGLFunctions {
     Q_OBJECT
@@ -37,6 +40,28 @@ public:
     void clearTrajectory();
     void addToTrajectory(const QVector3D& point);
 
+    // Пакетная загрузка: непрерывный буфер точек, NaN-точка (trajectoryBreakVertex)
+    // начинает новый сегмент. Одна загрузка в VBO и одна перерисовка на вызов.
+    void appendTrajectory(const QVector3D* points, int count);
+    void replaceTrajectory(const QVector3D* points, int count);
+
+    // Карта исходов в равновеликой цилиндрической развёртке (строка 0 - полюс y = 1),
+    // натягивается на сферу вместо серой заливки
+    void setOutcomeOverlay(const QImage& overlay);
+    void clearOutcomeOverlay();
+    bool hasOutcomeOverlay() const { return !m_outcomeOverlay.isNull(); }
+
+    // Карта потенциала формы в той же развёртке (с линейной фильтрацией) и её линии
+    // уровня парами концов отрезков; граница области Хилла рисуется отдельным цветом.
+    // Карта исходов, если есть, закрывает текстуру потенциала, линии остаются
+    void setPotentialMap(const QImage& image, const QVector<QVector3D>& contours,
+                         const QVector<QVector3D>& hillBoundary);
+    void setHillBoundary(const QVector<QVector3D>& hillBoundary);
+    void clearPotentialMap();
+
+    // Пикселей на единицу длины у ближайшей к камере точки сферы
+    double pixelsPerUnit() const;
+
     // Новый метод для автоматического вращения к точке
     void rotateToPoint(const QVector3D& point);
 
@@ -80,6 +105,7 @@ private:
     QQuaternion rotation;
     QPoint lastMousePos;
     QList<double> m_masses;
+    MassSystem m_massSystem; // постоянные особых кривых для m_masses
     float distance;
     bool isDraggingPoint;
     bool isRotatingSphere;
@@ -87,23 +113,55 @@ private:
 
     // Переменные для траектории
     bool m_showTrajectory;
-    QVector<QVector3D> m_trajectoryPoints;
-    QVector<QVector3D> m_trajectoryColors; // для градиента цвета
 
     void setupLighting();
     void drawSphere();
     void drawCoordinateSystem();
     void drawPoint();
     void drawSpecialLines();
+    void drawPlaneSection(const MassSystem::Plane& plane, int resolution);
     void drawCollisionPoints();
     void drawPoles();
     void drawEquilateralPoints();
     void drawTrajectory(); // метод для рисования траектории
+    void drawPotentialContours();
+    void uploadTexture(const QImage& image, GLuint& texture, bool smooth);
     QVector3D getSpherePointFromMouse(const QPoint& mousePos) const;
     QVector3D projectToScreen(const QVector3D& point) const;
-    QVector<QVector<QVector3D>> m_trajectorySegments;
-    QVector<QVector<QVector3D>> m_trajectorySegmentColors;
+    void appendTrajectorySpan(const QVector3D* points, int count);
+    void trimLiveTrajectory();
+    void compactTrajectory();
+
+    static constexpr int LiveTrajectoryLimit = 1000;
+
+    // Все сегменты траектории лежат подряд в одном массиве вершин;
+    // сегмент - диапазон [first, first + count). Вершины до начала
+    // обрезанного сегмента считаются мёртвыми до следующего уплотнения.
+    struct TrajectoryRange {
+        int first = 0;
+        int count = 0;
+    };
+    QVector<QVector3D> m_trajectoryVertices;
+    QVector<TrajectoryRange> m_trajectoryRanges;
+    int m_deadTrajectoryVertices = 0;
+    QOpenGLBuffer m_trajectoryBuffer{QOpenGLBuffer::VertexBuffer};
+    bool m_trajectoryBufferDirty = false;
     bool m_drawingEnabled = true;
+
+    // Текстура карты исходов; загружается в paintGL при следующей перерисовке
+    QImage m_outcomeOverlay;
+    GLuint m_overlayTexture = 0;
+    bool m_overlayDirty = false;
+
+    // Потенциал формы: текстура загружается так же; отрезки линий уровня и
+    // границы Хилла лежат подряд в одном VBO и загружаются только при смене карты
+    QImage m_potentialImage;
+    GLuint m_potentialTexture = 0;
+    bool m_potentialDirty = false;
+    QVector<QVector3D> m_potentialContours;
+    QVector<QVector3D> m_hillBoundary;
+    QOpenGLBuffer m_contourBuffer{QOpenGLBuffer::VertexBuffer};
+    bool m_contourBufferDirty = false;
 };
 
 #endif // SPHEREWIDGET_H
@@ -0,0 +1,222 @@
+#include "sphericalharmonics.h"
+#include "parallelfor.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+QVector<double> SphericalSpectrum::power() const
+{
+    QVector<double> result(degree + 1, 0.0);
+    for (int l = 0; l <= degree; ++l) {
+        double sum = std::norm(coefficient(l, 0));
+        for (int m = 1; m <= l; ++m) sum += 2.0 * std::norm(coefficient(l, m));
+        result[l] = sum / (2 * l + 1);
+    }
+    return result;
+}
+
+double SphericalSpectrum::distance(const SphericalSpectrum& other) const
+{
+    const QVector<double> a = power();
+    const QVector<double> b = other.power();
+    double difference = 0.0, reference = 0.0;
+    for (int l = 1; l < std::min(a.size(), b.size()); ++l) {
+        difference += (a[l] - b[l]) * (a[l] - b[l]);
+        reference += b[l] * b[l];
+    }
+    return reference > 0 ? std::sqrt(difference / reference) : 0.0;
+}
+
+void SphericalHarmonics::fft(std::complex<double>* data, int n, bool inverse)
+{
+    if (n <= 1) return;
+    const double sign = inverse ? 1.0 : -1.0;
+
+    if (n & (n - 1)) {
+        std::vector<std::complex<double>> input(data, data + n);
+        for (int k = 0; k < n; ++k) {
+            std::complex<double> sum;
+            for (int i = 0; i < n; ++i) {
+                sum += input[i] * std::polar(1.0, sign * 2.0 * M_PI * double((qint64(k) * i) % n) / n);
+            }
+            data[k] = sum;
+        }
+        return;
+    }
+
+    // Кули-Тьюки по основанию 2: перестановка с обращением битов, затем бабочки
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i], data[j]);
+    }
+    for (int length = 2; length <= n; length <<= 1) {
+        const std::complex<double> root = std::polar(1.0, sign * 2.0 * M_PI / length);
+        for (int start = 0; start < n; start += length) {
+            std::complex<double> w(1.0, 0.0);
+            for (int k = 0; k < length / 2; ++k) {
+                const std::complex<double> u = data[start + k];
+                const std::complex<double> v = data[start + k + length / 2] * w;
+                data[start + k] = u + v;
+                data[start + k + length / 2] = u - v;
+                w *= root;
+            }
+        }
+    }
+}
+
+void SphericalHarmonics::legendre(int m, int degree, double y, double* values)
+{
+    // P̄mm = (-1)^m √((2m+1)/4π · (2m-1)!!/(2m)!!) (1 - y²)^{m/2}
+    const double s = std::sqrt(std::max(0.0, 1.0 - y * y));
+    double pmm = std::sqrt(1.0 / (4.0 * M_PI));
+    for (int k = 1; k <= m; ++k) {
+        pmm *= -std::sqrt((2.0 * k + 1.0) / (2.0 * k)) * s;
+    }
+    values[0] = pmm;
+    if (degree == m) return;
+
+    double previous = pmm;
+    double current = y * std::sqrt(2.0 * m + 3.0) * pmm;
+    values[1] = current;
+    for (int l = m + 2; l <= degree; ++l) {
+        const double a = std::sqrt((4.0 * l * l - 1.0) / (double(l) * l - double(m) * m));
+        const double b = std::sqrt((double(l - 1) * (l - 1) - double(m) * m) / (4.0 * (l - 1) * (l - 1) - 1.0));
+        const double next = a * (y * current - b * previous);
+        previous = current;
+        current = next;
+        values[l - m] = current;
+    }
+}
+
+int SphericalHarmonics::maxDegree(int nside)
+{
+    return 5 * nside / 2;
+}
+
+QVector<Healpix::Ring> SphericalHarmonics::rings(const Healpix& grid)
+{
+    QVector<Healpix::Ring> result(grid.ringCount());
+    for (int r = 0; r < result.size(); ++r) result[r] = grid.ring(r);
+    return result;
+}
+
+SphericalSpectrum SphericalHarmonics::analyze(const QVector<double>& values, const Healpix& grid, int degree,
+                                              int iterations)
+{
+    if (values.size() != grid.pixelCount()) return SphericalSpectrum();
+    degree = std::min(degree, maxDegree(grid.nside()));
+    if (degree < 0) return SphericalSpectrum();
+
+    double mean = 0.0;
+    int finite = 0;
+    for (double value : values) {
+        if (!std::isfinite(value)) continue;
+        mean += value;
+        ++finite;
+    }
+    mean = finite > 0 ? mean / finite : 0.0;
+
+    QVector<double> input(values);
+    for (double& value : input) {
+        if (!std::isfinite(value)) value = mean;
+    }
+
+    SphericalSpectrum spectrum = project(input, grid, degree);
+    QVector<double> residual(input.size());
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        const QVector<double> fitted = synthesize(spectrum, grid);
+        for (int k = 0; k < input.size(); ++k) residual[k] = input[k] - fitted[k];
+        const SphericalSpectrum correction = project(residual, grid, degree);
+        for (int k = 0; k < spectrum.coefficients.size(); ++k) {
+            spectrum.coefficients[k] += correction.coefficients[k];
+        }
+    }
+    return spectrum;
+}
+
+SphericalSpectrum SphericalHarmonics::project(const QVector<double>& values, const Healpix& grid, int degree)
+{
+    SphericalSpectrum spectrum;
+    const QVector<Healpix::Ring> ringList = rings(grid);
+
+    // Fr(m) = Σi f e^{-imθi} = e^{-imθ0} · ДПФ[m mod n]; БПФ каждого кольца
+    QVector<std::complex<double>> transforms(values.size());
+    parallelFor(0, ringList.size(), [&](int r) {
+        const Healpix::Ring& ring = ringList[r];
+        std::complex<double>* data = transforms.data() + ring.first;
+        for (int i = 0; i < ring.count; ++i) data[i] = values[ring.first + i];
+        fft(data, ring.count, false);
+    }, 1);
+
+    // aℓm = Σr P̄ℓm(yr) Fr(m) · 4π/Npix
+    spectrum.degree = degree;
+    spectrum.coefficients.fill(std::complex<double>(), SphericalSpectrum::index(degree, degree) + 1);
+    const double weight = 4.0 * M_PI / grid.pixelCount();
+    parallelFor(0, degree + 1, [&](int m) {
+        std::vector<double> p(degree + 1 - m);
+        std::vector<std::complex<double>> sums(degree + 1 - m);
+        for (const Healpix::Ring& ring : ringList) {
+            legendre(m, degree, ring.y, p.data());
+            const std::complex<double> f = transforms[ring.first + m % ring.count]
+                                           * std::polar(weight, -m * ring.theta0);
+            for (int l = m; l <= degree; ++l) sums[l - m] += f * p[l - m];
+        }
+        for (int l = m; l <= degree; ++l) {
+            spectrum.coefficients[SphericalSpectrum::index(l, m)] = sums[l - m];
+        }
+    }, 1);
+    return spectrum;
+}
+
+QVector<double> SphericalHarmonics::synthesize(const SphericalSpectrum& spectrum, const Healpix& grid)
+{
+    return synthesize(spectrum, rings(grid), grid.pixelCount());
+}
+
+QVector<double> SphericalHarmonics::synthesize(const SphericalSpectrum& spectrum, int width, int height)
+{
+    if (width <= 0 || height <= 0) return QVector<double>();
+
+    // Строка j - кольцо из width ячеек, центр первой - на полъячейки от θ = 0
+    QVector<Healpix::Ring> ringList(height);
+    for (int j = 0; j < height; ++j) {
+        ringList[j].first = j * width;
+        ringList[j].count = width;
+        ringList[j].y = 1.0 - 2.0 * (j + 0.5) / height;
+        ringList[j].theta0 = M_PI / width;
+    }
+    return synthesize(spectrum, ringList, width * height);
+}
+
+QVector<double> SphericalHarmonics::synthesize(const SphericalSpectrum& spectrum,
+                                               const QVector<Healpix::Ring>& rings, int size)
+{
+    QVector<double> values;
+    if (!spectrum.isValid()) return values;
+    values.resize(size);
+
+    // Кольцо: Gm = Σℓ aℓm P̄ℓm(y), f(θ) = Re G0 + 2 Re Σm>0 Gm e^{imθ}. На кольце из n
+    // пикселей e^{imθi} = e^{imθ0} e^{2πi(m mod n)i/n}: гармоники складываются в бины
+    // m mod n, и остаётся одно обратное БПФ
+    const int degree = spectrum.degree;
+    parallelFor(0, rings.size(), [&](int r) {
+        const Healpix::Ring& ring = rings[r];
+        std::vector<double> p(degree + 1);
+        std::vector<std::complex<double>> bins(ring.count);
+        double constant = 0.0;
+        for (int m = 0; m <= degree; ++m) {
+            legendre(m, degree, ring.y, p.data());
+            std::complex<double> sum;
+            for (int l = m; l <= degree; ++l) sum += spectrum.coefficient(l, m) * p[l - m];
+            if (m == 0) constant = sum.real();
+            bins[m % ring.count] += sum * std::polar(1.0, m * ring.theta0);
+        }
+        fft(bins.data(), ring.count, true);
+        for (int i = 0; i < ring.count; ++i) {
+            values[ring.first + i] = 2.0 * bins[i].real() - constant;
+        }
+    }, 1);
+    return values;
+}
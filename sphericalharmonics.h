@@ -0,0 +1,70 @@
+#ifndef SPHERICALHARMONICS_H
+#define SPHERICALHARMONICS_H
+
+#include <QVector>
+#include <complex>
+#include "healpix.h"
+
+// Коэффициенты aℓm (m ≥ 0) разложения f = Σ aℓm Yℓm с ортонормированными
+// Yℓm = P̄ℓm(y)·e^{imθ}; полярная ось - y, как у сферы в SphereWidget.
+// Для вещественной f aℓ,-m = (-1)^m conj(aℓm), поэтому хранится половина.
+struct SphericalSpectrum {
+    int degree = -1;                                // ℓmax
+    QVector<std::complex<double>> coefficients;     // индекс ℓ(ℓ+1)/2 + m
+
+    static int index(int l, int m) { return l * (l + 1) / 2 + m; }
+    bool isValid() const { return degree >= 0; }
+    std::complex<double> coefficient(int l, int m) const { return coefficients[index(l, m)]; }
+
+    // Cℓ = Σm |aℓm|² / (2ℓ + 1)
+    QVector<double> power() const;
+    // Относительное расхождение спектров мощности √Σ(Cℓ - C'ℓ)² / √ΣC'ℓ² по общим ℓ ≥ 1
+    // (ℓ = 0 - среднее значение, от длины прогона не зависит только после нормировки)
+    double distance(const SphericalSpectrum& other) const;
+};
+
+// Сферическое гармоническое преобразование на пикселях HEALPix (значения в
+// кольцевом порядке, см. Healpix): вдоль каждого кольца y = const БПФ по θ
+// (в шапках кольца короче 2ℓ, и гармоника m берётся из бина m mod n),
+// затем по каждому m рекуррентность нормированных присоединённых функций
+// Лежандра. Вес пикселя - его площадь 4π/Npix; ошибку такой квадратуры, как
+// в anafast, гасят итерации Якоби a ← a + analyze(f - synthesize(a)).
+// Кольца HEALPix не редеют у полюсов, и итерации сходятся до ℓ ≈ 2.5·nside
+// (на гистограмме посещений nside = 64 это ℓ ≤ 160; при 3·nside - 1, как
+// у anafast, ошибка полосы уже порядка процентов).
+// Синтез - на тех же пикселях или в центрах ячеек равновеликой сетки
+// текстур (θ по столбцам, y по строкам, строка 0 - y = 1).
+// Обе стороны параллельны: БПФ - по кольцам, суммы Лежандра - по m.
+class SphericalHarmonics
+{
+public:
+    static constexpr int DefaultIterations = 3;
+
+    // Наибольшая степень, различимая на сетке HEALPix: 2.5·nside
+    static int maxDegree(int nside);
+
+    // values - по пикселю grid; NaN заменяются средним по конечным.
+    // degree обрезается до maxDegree
+    static SphericalSpectrum analyze(const QVector<double>& values, const Healpix& grid, int degree,
+                                     int iterations = DefaultIterations);
+    // Значения в центрах пикселей grid
+    static QVector<double> synthesize(const SphericalSpectrum& spectrum, const Healpix& grid);
+    // Значения в центрах ячеек равновеликой сетки width × height
+    static QVector<double> synthesize(const SphericalSpectrum& spectrum, int width, int height);
+
+    // Комплексное БПФ на месте; длина - степень двойки, иначе прямое ДПФ.
+    // inverse - с e^{+i}, без деления на n
+    static void fft(std::complex<double>* data, int n, bool inverse);
+
+private:
+    // Одна квадратура без уточнения
+    static SphericalSpectrum project(const QVector<double>& values, const Healpix& grid, int degree);
+    // Синтез по набору колец постоянной широты; пиксели колец идут подряд
+    static QVector<double> synthesize(const SphericalSpectrum& spectrum, const QVector<Healpix::Ring>& rings,
+                                      int size);
+    static QVector<Healpix::Ring> rings(const Healpix& grid);
+    // P̄ℓm(y) для ℓ = m..degree
+    static void legendre(int m, int degree, double y, double* values);
+};
+
+#endif // SPHERICALHARMONICS_H
@@ -0,0 +1,69 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Ограниченная очередь без блокировок для одного писателя и одного читателя.
+// Ёмкость округляется вверх до степени двойки; индексы растут монотонно,
+// позиция в буфере берётся по маске.
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(std::size_t capacity = 1024)
+    {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return m_slots.size(); }
+
+    // Только поток-писатель
+    bool tryPush(const T& value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= m_slots.size()) return false; // очередь полна
+
+        m_slots[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только поток-читатель
+    bool tryPop(T& value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        if (tail == head) return false; // очередь пуста
+
+        value = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Приблизительный размер (точен только из потока-читателя или писателя)
+    std::size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const { return size() == 0; }
+
+private:
+    std::vector<T> m_slots;
+    std::size_t m_mask = 0;
+
+    // Разносим индексы по разным строкам кэша, чтобы потоки не мешали друг другу
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,158 @@
+#include "syzygydetector.h"
+#include <QLineF>
+#include <cmath>
+#include <limits>
+
+SyzygyDetector::SyzygyDetector(const PositionSource* source)
+    : m_source(source)
+{
+}
+
+void SyzygyDetector::setSource(const PositionSource* source)
+{
+    m_source = source;
+    reset();
+}
+
+void SyzygyDetector::reset()
+{
+    m_hasPrevious = false;
+}
+
+double SyzygyDetector::normalizedArea(const QPointF points[3])
+{
+    const QPointF a = points[1] - points[0];
+    const QPointF b = points[2] - points[0];
+    const double area = a.x() * b.y() - a.y() * b.x();
+
+    const double size = PositionSource::triangleSize(points);
+    if (!(size > 0)) return 0.0;
+    return area / (size * size);
+}
+
+int SyzygyDetector::middleBody(const QPointF points[3])
+{
+    // Против наибольшей стороны лежит тело, стоящее между двумя другими
+    double d01 = QLineF(points[0], points[1]).length();
+    double d12 = QLineF(points[1], points[2]).length();
+    double d20 = QLineF(points[2], points[0]).length();
+    if (d01 >= d12 && d01 >= d20) return 2;
+    if (d12 >= d20) return 0;
+    return 1;
+}
+
+bool SyzygyDetector::feed(double t, const QPointF points[3], SyzygyEvent& event)
+{
+    const double area = normalizedArea(points);
+
+    bool found = false;
+    if (m_hasPrevious && t > m_previousTime &&
+        ((m_previousArea < 0 && area > 0) || (m_previousArea > 0 && area < 0))) {
+        QPointF crossing[3] = {points[0], points[1], points[2]};
+        event.time = refine(m_previousTime, m_previousArea, t, area, crossing);
+        event.middle = middleBody(crossing);
+        event.direction = area > 0 ? 1 : -1;
+        ++m_events;
+        found = true;
+    }
+
+    // Точный ноль не сбрасывает знак: пересечение засчитается на следующей выборке
+    if (!m_hasPrevious || area != 0.0) {
+        m_previousTime = t;
+        m_previousArea = area;
+        for (int i = 0; i < 3; ++i) m_previousPoints[i] = points[i];
+        m_hasPrevious = true;
+    }
+    return found;
+}
+
+double SyzygyDetector::refine(double t0, double a0, double t1, double a1, QPointF points[3])
+{
+    m_lastEvaluations = 0;
+
+    // Без источника - секущая и линейная интерполяция положений
+    auto secant = [&]() {
+        const double f = a0 / (a0 - a1);
+        for (int i = 0; i < 3; ++i) {
+            points[i] = m_previousPoints[i] + f * (points[i] - m_previousPoints[i]);
+        }
+        return t0 + f * (t1 - t0);
+    };
+    if (!m_source) return secant();
+
+    // Метод Брента: обратная квадратичная интерполяция / секущая с защитой бисекцией.
+    // b - лучшее приближение, a - предыдущее, c - конец отрезка с другим знаком
+    double a = t0, fa = a0;
+    double b = t1, fb = a1;
+    double c = a, fc = fa;
+    double d = b - a, e = d;
+    const double tolerance = TimeTolerance * (t1 - t0);
+
+    // Положения меняются местами вместе с абсциссами, чтобы вернуть конфигурацию именно в b
+    QPointF pa[3], pb[3], pc[3];
+    for (int i = 0; i < 3; ++i) {
+        pa[i] = m_previousPoints[i];
+        pb[i] = points[i];
+        pc[i] = pa[i];
+    }
+    auto copy = [](QPointF to[3], const QPointF from[3]) {
+        for (int i = 0; i < 3; ++i) to[i] = from[i];
+    };
+
+    for (int iteration = 0; iteration < MaxIterations; ++iteration) {
+        if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+            c = a; fc = fa; copy(pc, pa);
+            d = e = b - a;
+        }
+        if (std::abs(fc) < std::abs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+            copy(pa, pb); copy(pb, pc); copy(pc, pa);
+        }
+
+        const double tol = 2.0 * std::numeric_limits<double>::epsilon() * std::abs(b) + 0.5 * tolerance;
+        const double m = 0.5 * (c - b);
+        if (std::abs(m) <= tol || fb == 0.0) break;
+
+        if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+            double p, q;
+            const double s = fb / fa;
+            if (a == c) {
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            } else {
+                const double r = fb / fc;
+                const double u = fa / fc;
+                p = s * (2.0 * m * u * (u - r) - (b - a) * (r - 1.0));
+                q = (u - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0) q = -q; else p = -p;
+
+            if (2.0 * p < std::min(3.0 * m * q - std::abs(tol * q), std::abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = m;
+            }
+        } else {
+            d = m;
+            e = m;
+        }
+
+        a = b;
+        fa = fb;
+        copy(pa, pb);
+        b += std::abs(d) > tol ? d : (m > 0 ? tol : -tol);
+
+        ++m_lastEvaluations;
+        if (!m_source->positionsAt(b, pb)) {
+            // Источник не определён внутри отрезка - остаёмся на секущей
+            return secant();
+        }
+        fb = normalizedArea(pb);
+    }
+
+    copy(points, pb);
+    return b;
+}
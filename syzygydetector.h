@@ -0,0 +1,61 @@
+#ifndef SYZYGYDETECTOR_H
+#define SYZYGYDETECTOR_H
+
+#include <QPointF>
+#include <QByteArray>
+#include "positionsource.h"
+
+// Прохождение через коллинеарность (экватор сферы форм)
+struct SyzygyEvent {
+    double time = 0.0;
+    quint64 epoch = 0;  // номер перемотки симуляции, как у ShapeSample
+    int middle = -1;    // 0..2 - тело, оказавшееся между двумя другими
+    int direction = 0;  // +1: площадь стала положительной (в северное полушарие), -1 - наоборот
+};
+
+// Потоковый детектор сизигий. Получает выборки траектории по порядку и хранит
+// только предыдущую, поэтому работает с частотой интегрирования без буфера.
+// Знак экваториальной координаты ξ₃ совпадает со знаком ориентированной площади
+// треугольника, поэтому смена знака ищется прямо по положениям тел - без
+// преобразований формы. Момент пересечения уточняется методом Брента по
+// источнику положений (несколько вычислений positionsAt), а если источника нет -
+// секущей между выборками.
+class SyzygyDetector
+{
+public:
+    explicit SyzygyDetector(const PositionSource* source = nullptr);
+
+    void setSource(const PositionSource* source);
+    // Следующая выборка начинает новый участок (перемотка, зацикливание)
+    void reset();
+
+    // Очередная выборка; true и событие, если между ней и предыдущей была сизигия
+    bool feed(double t, const QPointF points[3], SyzygyEvent& event);
+
+    quint64 eventCount() const { return m_events; }
+    int lastEvaluations() const { return m_lastEvaluations; }
+
+    // Ориентированная площадь, отнесённая к квадрату наибольшей стороны
+    static double normalizedArea(const QPointF points[3]);
+    // Тело между двумя другими (противолежащее наибольшей стороне)
+    static int middleBody(const QPointF points[3]);
+    // Символ последовательности: '1', '2' или '3'
+    static char symbol(int middle) { return middle >= 0 ? char('1' + middle) : '?'; }
+
+    // Допуск по времени - доля интервала между выборками
+    static constexpr double TimeTolerance = 1e-10;
+    static constexpr int MaxIterations = 30;
+
+private:
+    double refine(double t0, double a0, double t1, double a1, QPointF points[3]);
+
+    const PositionSource* m_source = nullptr;
+    bool m_hasPrevious = false;
+    double m_previousTime = 0.0;
+    double m_previousArea = 0.0;
+    QPointF m_previousPoints[3];
+    quint64 m_events = 0;
+    int m_lastEvaluations = 0;
+};
+
+#endif // SYZYGYDETECTOR_H
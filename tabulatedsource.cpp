@@ -0,0 +1,325 @@
+#include "tabulatedsource.h"
+#include "parallelfor.h"
+#include <QFile>
+#include <QByteArray>
+#include <QSysInfo>
+#include <QDebug>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int Columns = 7;                      // t, x1, y1, x2, y2, x3, y3
+constexpr qint64 BlockBytes = 64 * 1024 * 1024; // текст читается блоками такого размера
+
+// Разобранный кусок блока: строки подряд по Columns значений
+struct ParsedPiece {
+    std::vector<double> rows;
+    qint64 skipped = 0;
+};
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Разбор одной строки; false - строка не содержит семи чисел
+bool parseLine(const char* p, const char* end, double row[Columns])
+{
+    while (p < end && isSpace(*p)) ++p;
+    if (p == end || *p == '#') return false;
+
+    for (int column = 0; column < Columns; ++column) {
+        while (p < end && isSpace(*p)) ++p;
+        if (p < end && *p == '+') ++p;
+
+        // from_chars не зависит от локали, в отличие от strtod
+        auto result = std::from_chars(p, end, row[column]);
+        if (result.ec != std::errc()) return false;
+        if (!std::isfinite(row[column])) return false;
+        p = result.ptr;
+
+        while (p < end && isSpace(*p)) ++p;
+        if (p < end && (*p == ',' || *p == ';')) ++p;
+    }
+    return true;
+}
+
+void parsePiece(const char* begin, const char* end, ParsedPiece& piece)
+{
+    // Оценка сверху: строка таблицы занимает не меньше ~14 байт
+    piece.rows.reserve(static_cast<size_t>((end - begin) / 14 + 1) * Columns);
+
+    double row[Columns];
+    const char* line = begin;
+    while (line < end) {
+        const char* next = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* lineEnd = next ? next : end;
+        if (parseLine(line, lineEnd, row)) {
+            piece.rows.insert(piece.rows.end(), row, row + Columns);
+        } else if (lineEnd > line) {
+            ++piece.skipped;
+        }
+        line = next ? next + 1 : end;
+    }
+}
+
+}
+
+std::shared_ptr<TabulatedSource> TabulatedSource::load(const QString& fileName, QString* error)
+{
+    std::shared_ptr<TabulatedSource> source(new TabulatedSource());
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "Cannot open file: " + fileName;
+        return nullptr;
+    }
+    const bool binary = file.peek(8) == QByteArray("TSBATCH1");
+    file.close();
+
+    try {
+        bool ok = binary ? source->loadBinary(fileName, error) : source->loadText(fileName, error);
+        if (!ok || !source->finish(error)) return nullptr;
+    }
+    catch (const std::bad_alloc&) {
+        if (error) *error = "Not enough memory for table: " + fileName;
+        return nullptr;
+    }
+    return source;
+}
+
+bool TabulatedSource::loadText(const QString& fileName, QString* error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "Cannot open file: " + fileName;
+        return false;
+    }
+
+    // Грубая оценка числа строк по размеру файла, чтобы не копировать столбцы при росте
+    const qint64 estimatedRows = file.size() / 64;
+    m_time.reserve(estimatedRows);
+    for (QVector<double>& column : m_values) column.reserve(estimatedRows);
+
+    const int pieceCount = QThread::idealThreadCount() * 4;
+    QByteArray carry; // хвост блока без завершающего '\n'
+
+    while (true) {
+        QByteArray block = file.read(BlockBytes);
+        const bool last = block.isEmpty() || file.atEnd();
+        if (!carry.isEmpty()) {
+            block.prepend(carry);
+            carry.clear();
+        }
+        if (block.isEmpty()) break;
+
+        qsizetype usable = block.size();
+        if (!last) {
+            usable = block.lastIndexOf('\n') + 1;
+            carry = block.mid(usable);
+        }
+
+        // Делим блок на куски по границам строк и разбираем их параллельно
+        QVector<qsizetype> bounds(pieceCount + 1);
+        bounds[0] = 0;
+        bounds[pieceCount] = usable;
+        for (int k = 1; k < pieceCount; ++k) {
+            qsizetype at = qMax(bounds[k - 1], usable * k / pieceCount);
+            const char* newline = static_cast<const char*>(
+                std::memchr(block.constData() + at, '\n', usable - at));
+            bounds[k] = newline ? (newline - block.constData()) + 1 : usable;
+        }
+
+        std::vector<ParsedPiece> pieces(pieceCount);
+        const char* data = block.constData();
+        parallelFor(0, pieceCount, [&](int k) {
+            parsePiece(data + bounds[k], data + bounds[k + 1], pieces[k]);
+        }, 1);
+
+        // Склеиваем в порядке файла
+        for (ParsedPiece& piece : pieces) {
+            m_skipped += piece.skipped;
+            for (size_t i = 0; i < piece.rows.size(); i += Columns) {
+                const double* row = piece.rows.data() + i;
+                m_time.append(row[0]);
+                for (int c = 0; c < 6; ++c) m_values[c].append(row[c + 1]);
+            }
+            std::vector<double>().swap(piece.rows);
+        }
+
+        if (last && carry.isEmpty()) break;
+    }
+
+    if (file.error() != QFileDevice::NoError) {
+        if (error) *error = "Read error: " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TabulatedSource::loadBinary(const QString& fileName, QString* error)
+{
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+        if (error) *error = "Binary tables require a little-endian host";
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "Cannot open file: " + fileName;
+        return false;
+    }
+
+    // Заголовок пакетного формата: magic, версия, число полей, число записей, массы
+    QByteArray header = file.read(8 + 4 + 4 + 8 + 3 * 8);
+    if (header.size() < 48) {
+        if (error) *error = "Truncated binary table: " + fileName;
+        return false;
+    }
+    quint32 version, fields;
+    quint64 records;
+    std::memcpy(&version, header.constData() + 8, 4);
+    std::memcpy(&fields, header.constData() + 12, 4);
+    std::memcpy(&records, header.constData() + 16, 8);
+    if (version != 1 || fields < quint32(Columns)) {
+        if (error) *error = "Unsupported binary table layout: " + fileName;
+        return false;
+    }
+
+    const qint64 recordBytes = qint64(fields) * 8;
+    if (qint64(records) > (file.size() - 48) / recordBytes) {
+        if (error) *error = "Truncated binary table: " + fileName;
+        return false;
+    }
+
+    m_time.resize(records);
+    for (QVector<double>& column : m_values) column.resize(records);
+
+    const qint64 recordsPerBlock = qMax<qint64>(1, BlockBytes / recordBytes);
+    for (qint64 first = 0; first < qint64(records); first += recordsPerBlock) {
+        const qint64 count = qMin<qint64>(recordsPerBlock, qint64(records) - first);
+        QByteArray block = file.read(count * recordBytes);
+        if (block.size() != count * recordBytes) {
+            if (error) *error = "Read error: " + file.errorString();
+            return false;
+        }
+
+        // Разносим записи по столбцам
+        const char* data = block.constData();
+        parallelFor(0, int(count), [&](int i) {
+            double row[Columns];
+            std::memcpy(row, data + i * recordBytes, sizeof(row));
+            m_time[first + i] = row[0];
+            for (int c = 0; c < 6; ++c) m_values[c][first + i] = row[c + 1];
+        }, 4096);
+    }
+    return true;
+}
+
+bool TabulatedSource::finish(QString* error)
+{
+    // Повторяющиеся моменты отбрасываем, убывающее время - ошибка
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < m_time.size(); ++i) {
+        const double t = m_time[i];
+        bool finite = std::isfinite(t);
+        for (int c = 0; c < 6 && finite; ++c) finite = std::isfinite(m_values[c][i]);
+        if (!finite || (kept > 0 && t == m_time[kept - 1])) {
+            ++m_skipped;
+            continue;
+        }
+        if (kept > 0 && t < m_time[kept - 1]) {
+            if (error) *error = QString("Time column must be increasing (t = %1 after %2)")
+                                    .arg(t).arg(m_time[kept - 1]);
+            return false;
+        }
+        m_time[kept] = t;
+        for (int c = 0; c < 6; ++c) m_values[c][kept] = m_values[c][i];
+        ++kept;
+    }
+    m_time.resize(kept);
+    m_time.squeeze();
+    for (QVector<double>& column : m_values) {
+        column.resize(kept);
+        column.squeeze();
+    }
+
+    if (kept < 2) {
+        if (error) *error = "Table must contain at least two rows of t, x1, y1, x2, y2, x3, y3";
+        return false;
+    }
+
+    buildSplines();
+    return true;
+}
+
+void TabulatedSource::buildSplines()
+{
+    const qsizetype n = m_time.size();
+    const double* t = m_time.constData();
+
+    // Прогонка для естественного сплайна: прямой ход по шагам сетки общий
+    // для всех столбцов, поэтому считается один раз
+    QVector<double> upper(n, 0.0);   // c' прогонки
+    QVector<double> pivot(n, 1.0);   // диагональ после исключения
+    for (qsizetype i = 1; i < n - 1; ++i) {
+        const double h0 = t[i] - t[i - 1];
+        const double h1 = t[i + 1] - t[i];
+        pivot[i] = 2.0 * (h0 + h1) - h0 * upper[i - 1];
+        upper[i] = h1 / pivot[i];
+    }
+
+    parallelFor(0, 6, [&](int c) {
+        const double* y = m_values[c].constData();
+        QVector<double>& m = m_curvature[c];
+        m = QVector<double>(n, 0.0);
+
+        // Правая часть и прямой ход
+        for (qsizetype i = 1; i < n - 1; ++i) {
+            const double h0 = t[i] - t[i - 1];
+            const double h1 = t[i + 1] - t[i];
+            const double rhs = 6.0 * ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0);
+            m[i] = (rhs - h0 * m[i - 1]) / pivot[i];
+        }
+        // Обратный ход; на концах вторая производная равна нулю
+        m[n - 1] = 0.0;
+        for (qsizetype i = n - 2; i >= 1; --i) {
+            m[i] -= upper[i] * m[i + 1];
+        }
+        m[0] = 0.0;
+    }, 1);
+}
+
+bool TabulatedSource::positionsAt(double t, QPointF points[3]) const
+{
+    const qsizetype n = m_time.size();
+    if (n < 2 || std::isnan(t)) return false;
+    t = qBound(m_time.first(), t, m_time.last());
+
+    // Интервал [t_k, t_k+1], содержащий t
+    const double* times = m_time.constData();
+    qsizetype k = std::upper_bound(times, times + n, t) - times - 1;
+    k = qBound<qsizetype>(0, k, n - 2);
+
+    const double h = times[k + 1] - times[k];
+    const double a = (times[k + 1] - t) / h;
+    const double b = 1.0 - a;
+    const double ca = (a * a * a - a) * h * h / 6.0;
+    const double cb = (b * b * b - b) * h * h / 6.0;
+
+    double values[6];
+    for (int c = 0; c < 6; ++c) {
+        const double* y = m_values[c].constData();
+        const double* m = m_curvature[c].constData();
+        values[c] = a * y[k] + b * y[k + 1] + ca * m[k] + cb * m[k + 1];
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        points[i] = QPointF(values[2 * i], values[2 * i + 1]);
+    }
+    return true;
+}
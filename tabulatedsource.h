@@ -0,0 +1,47 @@
+#ifndef TABULATEDSOURCE_H
+#define TABULATEDSOURCE_H
+
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "positionsource.h"
+
+// Положения тел из таблицы (t, x1, y1, x2, y2, x3, y3), например вывода интегратора.
+// Поддерживаются:
+//   - текст: столбцы через запятую, ';' или пробелы; строки, где первые семь
+//     полей не числа (заголовок, комментарии #), пропускаются; лишние столбцы
+//     игнорируются, поэтому читается и CSV пакетного режима;
+//   - бинарный формат пакетного режима (TSBATCH1), берутся первые семь полей.
+// Файл читается блоками, каждый блок разбирается параллельно, так что в памяти
+// никогда не лежит весь текст - только разобранные столбцы.
+// Между узлами - естественный кубический сплайн; узел ищется бинарным поиском.
+class TabulatedSource : public PositionSource
+{
+public:
+    static std::shared_ptr<TabulatedSource> load(const QString& fileName, QString* error = nullptr);
+
+    // Вне таблицы положения держатся на крайних узлах: t раньше первой строки
+    // даёт первую строку (так анимация с t = 0 проходит начало таблицы, начатой
+    // позже), t позже последней - последнюю
+    bool positionsAt(double t, QPointF points[3]) const override;
+
+    qsizetype sampleCount() const { return m_time.size(); }
+    double startTime() const { return m_time.isEmpty() ? 0.0 : m_time.first(); }
+    double endTime() const { return m_time.isEmpty() ? 0.0 : m_time.last(); }
+    qint64 skippedLines() const { return m_skipped; }
+
+private:
+    TabulatedSource() = default;
+
+    bool loadText(const QString& fileName, QString* error);
+    bool loadBinary(const QString& fileName, QString* error);
+    bool finish(QString* error);
+    void buildSplines();
+
+    QVector<double> m_time;
+    QVector<double> m_values[6];    // x1, y1, x2, y2, x3, y3
+    QVector<double> m_curvature[6]; // вторые производные сплайна в узлах
+    qint64 m_skipped = 0;
+};
+
+#endif // TABULATEDSOURCE_H
@@ -0,0 +1,368 @@
+#include "threebody.h"
+#include <QLineF>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+ThreeBodySystem::ThreeBodySystem(const QList<double>& masses, const State& initial,
+                                 Integrator integrator, double step, double tolerance)
+    : m_state(initial),
+      m_integrator(integrator),
+      m_step(step > 0 ? step : 1e-3),
+      m_tolerance(tolerance > 0 ? tolerance : 1e-10)
+{
+    for (int i = 0; i < 3; ++i) {
+        m_masses[i] = masses.value(i, 1.0);
+    }
+    accelerations(m_state.x, m_acceleration);
+    m_binding = -energy(m_state);
+}
+
+double ThreeBodySystem::accelerations(const double x[6], double a[6])
+{
+    std::fill(a, a + 6, 0.0);
+    double u = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i + 1; j < 3; ++j) {
+            const double dx = x[2 * j] - x[2 * i];
+            const double dy = x[2 * j + 1] - x[2 * i + 1];
+            const double r2 = dx * dx + dy * dy;
+            const double r = std::sqrt(r2);
+            const double inv = 1.0 / (r2 * r);
+            u += m_masses[i] * m_masses[j] / r;
+            a[2 * i] += m_masses[j] * dx * inv;
+            a[2 * i + 1] += m_masses[j] * dy * inv;
+            a[2 * j] -= m_masses[i] * dx * inv;
+            a[2 * j + 1] -= m_masses[i] * dy * inv;
+        }
+    }
+    ++m_evaluations;
+    return u;
+}
+
+void ThreeBodySystem::kickDriftKick(double dt)
+{
+    // Ускорение в начале шага уже известно с прошлого шага
+    const double half = 0.5 * dt;
+    for (int k = 0; k < 6; ++k) {
+        m_state.v[k] += half * m_acceleration[k];
+        m_state.x[k] += dt * m_state.v[k];
+    }
+    accelerations(m_state.x, m_acceleration);
+    for (int k = 0; k < 6; ++k) {
+        m_state.v[k] += half * m_acceleration[k];
+    }
+}
+
+void ThreeBodySystem::logHLeapfrog(double ds)
+{
+    // Алгоритмическая регуляризация (Mikkola-Tanikawa, Preto-Tremaine):
+    // дрейф по dt = ds / (T + B), толчок по dt = ds / U. При сближении U растёт,
+    // и шаг по t уменьшается сам, а сама схема для двух тел проходит через
+    // столкновение без особенности - стоимость сближения как у обычного участка.
+    auto kinetic = [this]() {
+        double t = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            t += 0.5 * m_masses[i] * (m_state.v[2 * i] * m_state.v[2 * i] +
+                                      m_state.v[2 * i + 1] * m_state.v[2 * i + 1]);
+        }
+        return t;
+    };
+    auto drift = [this, &kinetic](double dsHalf) {
+        // T + B = U на точном решении; защищаемся от нуля для несвязанных систем
+        const double dt = dsHalf / std::max(kinetic() + m_binding, 1e-300);
+        for (int k = 0; k < 6; ++k) m_state.x[k] += dt * m_state.v[k];
+        m_state.t += dt;
+    };
+
+    drift(0.5 * ds);
+    const double u = accelerations(m_state.x, m_acceleration);
+    const double dt = ds / u;
+    for (int k = 0; k < 6; ++k) m_state.v[k] += dt * m_acceleration[k];
+    drift(0.5 * ds);
+}
+
+bool ThreeBodySystem::advance()
+{
+    if (m_failed) return false;
+
+    switch (m_integrator) {
+    case Leapfrog:
+        kickDriftKick(m_step);
+        m_state.t += m_step;
+        m_lastStep = m_step;
+        break;
+    case Yoshida4: {
+        // w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2·w1
+        static const double w1 = 1.0 / (2.0 - std::cbrt(2.0));
+        static const double w0 = 1.0 - 2.0 * w1;
+        kickDriftKick(w1 * m_step);
+        kickDriftKick(w0 * m_step);
+        kickDriftKick(w1 * m_step);
+        m_state.t += m_step;
+        m_lastStep = m_step;
+        break;
+    }
+    case DormandPrince5:
+        if (!dormandPrinceStep()) m_failed = true;
+        break;
+    case LogH4: {
+        static const double w1 = 1.0 / (2.0 - std::cbrt(2.0));
+        static const double w0 = 1.0 - 2.0 * w1;
+        const double t0 = m_state.t;
+        logHLeapfrog(w1 * m_step);
+        logHLeapfrog(w0 * m_step);
+        logHLeapfrog(w1 * m_step);
+        m_lastStep = m_state.t - t0;
+        break;
+    }
+    }
+
+    for (int k = 0; k < 6 && !m_failed; ++k) {
+        if (!std::isfinite(m_state.x[k]) || !std::isfinite(m_state.v[k])) m_failed = true;
+    }
+    return !m_failed;
+}
+
+bool ThreeBodySystem::dormandPrinceStep()
+{
+    // Таблица Бутчера Дормана-Принса 5(4); y = (x, v), f(y) = (v, a(x))
+    static const double a21 = 1.0 / 5;
+    static const double a31 = 3.0 / 40, a32 = 9.0 / 40;
+    static const double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+    static const double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187, a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+    static const double a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247,
+                        a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+    static const double b1 = 35.0 / 384, b3 = 500.0 / 1113, b4 = 125.0 / 192,
+                        b5 = -2187.0 / 6784, b6 = 11.0 / 84;
+    static const double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920,
+                        e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+    double y[12], k[7][12], stage[12], next[12];
+    std::memcpy(y, m_state.x, sizeof(m_state.x));
+    std::memcpy(y + 6, m_state.v, sizeof(m_state.v));
+
+    auto derivative = [this](const double in[12], double out[12]) {
+        std::memcpy(out, in + 6, 6 * sizeof(double));
+        accelerations(in, out + 6);
+    };
+
+    std::memcpy(k[0], y + 6, 6 * sizeof(double));
+    std::memcpy(k[0] + 6, m_acceleration, 6 * sizeof(double));
+
+    double h = m_step;
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        if (!(h > 1e-14 * (1.0 + std::abs(m_state.t)))) return false;
+
+        for (int i = 0; i < 12; ++i) stage[i] = y[i] + h * a21 * k[0][i];
+        derivative(stage, k[1]);
+        for (int i = 0; i < 12; ++i) stage[i] = y[i] + h * (a31 * k[0][i] + a32 * k[1][i]);
+        derivative(stage, k[2]);
+        for (int i = 0; i < 12; ++i) stage[i] = y[i] + h * (a41 * k[0][i] + a42 * k[1][i] + a43 * k[2][i]);
+        derivative(stage, k[3]);
+        for (int i = 0; i < 12; ++i) {
+            stage[i] = y[i] + h * (a51 * k[0][i] + a52 * k[1][i] + a53 * k[2][i] + a54 * k[3][i]);
+        }
+        derivative(stage, k[4]);
+        for (int i = 0; i < 12; ++i) {
+            stage[i] = y[i] + h * (a61 * k[0][i] + a62 * k[1][i] + a63 * k[2][i] +
+                                   a64 * k[3][i] + a65 * k[4][i]);
+        }
+        derivative(stage, k[5]);
+        for (int i = 0; i < 12; ++i) {
+            next[i] = y[i] + h * (b1 * k[0][i] + b3 * k[2][i] + b4 * k[3][i] + b5 * k[4][i] + b6 * k[5][i]);
+        }
+        derivative(next, k[6]);
+
+        // Оценка ошибки по разности решений 5-го и 4-го порядка
+        double sum = 0.0;
+        for (int i = 0; i < 12; ++i) {
+            const double delta = h * (e1 * k[0][i] + e3 * k[2][i] + e4 * k[3][i] +
+                                      e5 * k[4][i] + e6 * k[5][i] + e7 * k[6][i]);
+            const double scale = m_tolerance * (1.0 + std::max(std::abs(y[i]), std::abs(next[i])));
+            sum += (delta / scale) * (delta / scale);
+        }
+        const double error = std::sqrt(sum / 12.0);
+
+        if (error <= 1.0 && std::isfinite(error)) {
+            std::memcpy(m_state.x, next, sizeof(m_state.x));
+            std::memcpy(m_state.v, next + 6, sizeof(m_state.v));
+            std::memcpy(m_acceleration, k[6] + 6, sizeof(m_acceleration));
+            m_state.t += h;
+            m_lastStep = h;
+
+            const double factor = error > 0 ? 0.9 * std::pow(error, -0.2) : 5.0;
+            m_step = h * std::clamp(factor, 0.2, 5.0);
+            return true;
+        }
+
+        ++m_rejected;
+        const double factor = std::isfinite(error) ? 0.9 * std::pow(error, -0.2) : 0.2;
+        h *= std::clamp(factor, 0.2, 1.0);
+    }
+    return false;
+}
+
+double ThreeBodySystem::energy(const State& state) const
+{
+    double kinetic = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        kinetic += 0.5 * m_masses[i] * (state.v[2 * i] * state.v[2 * i] + state.v[2 * i + 1] * state.v[2 * i + 1]);
+    }
+    double potential = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i + 1; j < 3; ++j) {
+            const double r = std::hypot(state.x[2 * j] - state.x[2 * i], state.x[2 * j + 1] - state.x[2 * i + 1]);
+            potential -= m_masses[i] * m_masses[j] / r;
+        }
+    }
+    return kinetic + potential;
+}
+
+double ThreeBodySystem::angularMomentum(const State& state) const
+{
+    double l = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        l += m_masses[i] * (state.x[2 * i] * state.v[2 * i + 1] - state.x[2 * i + 1] * state.v[2 * i]);
+    }
+    return l;
+}
+
+void ThreeBodySystem::toCenterOfMass(State& state, const double masses[3])
+{
+    const double total = masses[0] + masses[1] + masses[2];
+    for (int axis = 0; axis < 2; ++axis) {
+        double position = 0.0, momentum = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            position += masses[i] * state.x[2 * i + axis];
+            momentum += masses[i] * state.v[2 * i + axis];
+        }
+        for (int i = 0; i < 3; ++i) {
+            state.x[2 * i + axis] -= position / total;
+            state.v[2 * i + axis] -= momentum / total;
+        }
+    }
+}
+
+namespace {
+
+// Восьмёрка Шенсине-Монтгомери при G = 1 и единичных массах (Simó): тело 3 в
+// центре, тела 1 и 2 симметрично; наибольшая сторона - между ними, ≈ 2
+const double EightX = 0.97000436, EightY = -0.24308753;
+const double EightVx = -0.93240737, EightVy = -0.86473146;
+const double EightPeriod = 6.32591398;
+
+double eightSize() { return 2.0 * std::hypot(EightX, EightY); }
+
+// Восьмёрка существует только при равных массах; при разных масштаб скоростей
+// берётся по средней, но орбита уже не замкнётся
+double eightMass(const QList<double>& masses)
+{
+    const double m[3] = {masses.value(0, 1.0), masses.value(1, 1.0), masses.value(2, 1.0)};
+    const double mean = (m[0] + m[1] + m[2]) / 3.0;
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(m[i] - mean) > 1e-9 * mean) {
+            qWarning() << "Figure-eight needs equal masses, got" << m[0] << m[1] << m[2];
+            break;
+        }
+    }
+    return mean;
+}
+
+} // namespace
+
+ThreeBodySystem::State ThreeBodySystem::figureEight(const QList<double>& masses)
+{
+    const double m[3] = {masses.value(0, 1.0), masses.value(1, 1.0), masses.value(2, 1.0)};
+
+    // Как у остальных заготовок, наибольшая сторона равна 1. Решение остаётся
+    // решением, если координаты поделить на s, а скорости умножить на √(m·s)
+    const double size = eightSize();
+    const double velocity = std::sqrt(eightMass(masses) * size);
+
+    State state;
+    state.x[0] = EightX / size;  state.x[1] = EightY / size;
+    state.x[2] = -EightX / size; state.x[3] = -EightY / size;
+    state.v[4] = EightVx * velocity; state.v[5] = EightVy * velocity;
+    state.v[0] = state.v[2] = -0.5 * state.v[4];
+    state.v[1] = state.v[3] = -0.5 * state.v[5];
+    toCenterOfMass(state, m);
+    return state;
+}
+
+double ThreeBodySystem::figureEightPeriod(const QList<double>& masses)
+{
+    // T ∝ s^{3/2}/√m
+    const double size = eightSize();
+    return EightPeriod / (size * std::sqrt(size * eightMass(masses)));
+}
+
+ThreeBodySystem::State ThreeBodySystem::triangleAtRest(const QPointF points[3], const QList<double>& masses)
+{
+    const double m[3] = {masses.value(0, 1.0), masses.value(1, 1.0), masses.value(2, 1.0)};
+
+    // Масштаб: наибольшая сторона равна 1, иначе при G = 1 и размерах сцены
+    // (~100 единиц) движение было бы очень медленным
+    double size = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        size = std::max(size, QLineF(points[i], points[(i + 1) % 3]).length());
+    }
+    if (size <= 0) size = 1.0;
+
+    State state;
+    for (int i = 0; i < 3; ++i) {
+        state.x[2 * i] = points[i].x() / size;
+        state.x[2 * i + 1] = points[i].y() / size;
+    }
+    toCenterOfMass(state, m);
+    return state;
+}
+
+ThreeBodySystem::State ThreeBodySystem::rotatingTriangle(const QPointF points[3], const QList<double>& masses)
+{
+    State state = triangleAtRest(points, masses);
+
+    // ω² = G·M / a³ для средней стороны a (лагранжево решение для равностороннего)
+    double side = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3;
+        side += std::hypot(state.x[2 * j] - state.x[2 * i], state.x[2 * j + 1] - state.x[2 * i + 1]) / 3.0;
+    }
+    const double total = masses.value(0, 1.0) + masses.value(1, 1.0) + masses.value(2, 1.0);
+    const double omega = std::sqrt(total / (side * side * side));
+
+    for (int i = 0; i < 3; ++i) {
+        state.v[2 * i] = -omega * state.x[2 * i + 1];
+        state.v[2 * i + 1] = omega * state.x[2 * i];
+    }
+    return state;
+}
+
+const char* ThreeBodySystem::integratorName(Integrator integrator)
+{
+    switch (integrator) {
+    case Leapfrog: return "Leapfrog";
+    case Yoshida4: return "Yoshida 4";
+    case DormandPrince5: return "Dormand-Prince 5(4)";
+    case LogH4: return "Regularized (logH 4)";
+    }
+    return "";
+}
+
+bool ThreeBodySystem::hasVariableStep(Integrator integrator)
+{
+    return integrator == DormandPrince5 || integrator == LogH4;
+}
+
+double ThreeBodySystem::minimumSeparation(const State& state)
+{
+    double r = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i + 1; j < 3; ++j) {
+            r = std::min(r, std::hypot(state.x[2 * j] - state.x[2 * i], state.x[2 * j + 1] - state.x[2 * i + 1]));
+        }
+    }
+    return r;
+}
@@ -0,0 +1,90 @@
+#ifndef THREEBODY_H
+#define THREEBODY_H
+
+#include <QPointF>
+#include <QList>
+#include <QtGlobal>
+
+// Плоская ньютоновская задача трёх тел (G = 1).
+// Состояние хранится плоскими массивами x1, y1, x2, y2, x3, y3, чтобы шаг
+// обходился без выделения памяти: на одном ядре получаются миллионы шагов в секунду.
+class ThreeBodySystem
+{
+public:
+    enum Integrator {
+        Leapfrog,       // симплектический, 2-й порядок, 1 вычисление сил на шаг
+        Yoshida4,       // симплектический, 4-й порядок (композиция Йошиды), 3 вычисления
+        DormandPrince5, // явный 5(4) с контролем ошибки и переменным шагом
+        LogH4           // регуляризованный: логарифмический гамильтониан, шаг по
+                        // фиктивному времени ds = U dt, композиция Йошиды 4-го порядка
+    };
+
+    struct State {
+        double t = 0.0;
+        double x[6] = {};
+        double v[6] = {};
+    };
+
+    // step - фиксированный шаг симплектических схем, начальный для адаптивной
+    // и шаг по фиктивному времени s для регуляризованной;
+    // tolerance - допуск локальной ошибки адаптивной схемы
+    ThreeBodySystem(const QList<double>& masses, const State& initial,
+                    Integrator integrator, double step, double tolerance = 1e-10);
+
+    // Один (принятый) шаг; false, если движение дошло до столкновения
+    bool advance();
+
+    const State& state() const { return m_state; }
+    bool failed() const { return m_failed; }
+    double lastStep() const { return m_lastStep; }
+    quint64 forceEvaluations() const { return m_evaluations; }
+    quint64 rejectedSteps() const { return m_rejected; }
+
+    double energy() const { return energy(m_state); }
+    double angularMomentum() const { return angularMomentum(m_state); }
+    double energy(const State& state) const;
+    double angularMomentum(const State& state) const;
+
+    // Начальные условия. Все переводятся в систему центра масс с нулевым импульсом.
+    // Восьмёрка Шенсине-Монтгомери, приведённая к единичной наибольшей стороне.
+    // Существует только при равных массах; при разных - предупреждение в лог,
+    // скорости берутся по средней массе
+    static State figureEight(const QList<double>& masses);
+    // Её период: ≈ 2.2365 при единичных массах
+    static double figureEightPeriod(const QList<double>& masses);
+    // Треугольник сцены, приведённый к единичной наибольшей стороне и вращающийся
+    // как целое с угловой скоростью лагранжева решения (точно для равностороннего)
+    static State rotatingTriangle(const QPointF points[3], const QList<double>& masses);
+    // Треугольник сцены в покое (свободное падение)
+    static State triangleAtRest(const QPointF points[3], const QList<double>& masses);
+
+    static const char* integratorName(Integrator integrator);
+    // Шаг по t меняется от шага к шагу (адаптивная и регуляризованная схемы)
+    static bool hasVariableStep(Integrator integrator);
+
+    // Наименьшее расстояние между телами
+    static double minimumSeparation(const State& state);
+
+private:
+    // Возвращает силовую функцию U = Σ mᵢmⱼ/rᵢⱼ (потенциальная энергия равна -U)
+    double accelerations(const double x[6], double a[6]);
+    void kickDriftKick(double dt);
+    void logHLeapfrog(double ds);
+    bool dormandPrinceStep();
+    static void toCenterOfMass(State& state, const double masses[3]);
+
+    double m_masses[3];
+    State m_state;
+    Integrator m_integrator;
+    double m_step;
+    double m_tolerance;
+    double m_lastStep = 0.0;
+    double m_binding = 0.0;         // B = -E0 для регуляризованной схемы
+
+    double m_acceleration[6] = {};  // силы в текущем состоянии (FSAL для всех схем)
+    quint64 m_evaluations = 0;
+    quint64 m_rejected = 0;
+    bool m_failed = false;
+};
+
+#endif // THREEBODY_H
@@ -0,0 +1,237 @@
+#ifndef THREEBODYLANES_H
+#define THREEBODYLANES_H
+
+#include <QList>
+#include <algorithm>
+#include <cmath>
+
+// Пачка из L независимых задач трёх тел в SoA-раскладке: координата k всех
+// дорожек лежит подряд, и каждая операция шага - цикл по дорожкам, который
+// компилятор векторизует (нужны -O3 -fno-math-errno из TS.pro; проверено
+// -fopt-info-vec: drift, kick и оба цикла ThreeBodyTangent). Схема - регуляризованный (logH) чехарда-шаг
+// drift(ds/2) kick(ds) drift(ds/2) с общим шагом по фиктивному времени s:
+// дрейф идёт по dt = ds/(T + B), толчок - по dt = ds/U, где B = -E0,
+// поэтому дорожки идут в ногу даже при разных тесных сближениях.
+// Остановленная дорожка (active = 0) стоит на месте, не выходя из циклов.
+template <int L>
+struct ThreeBodyLanes {
+    double m[3] = {1.0, 1.0, 1.0};
+    double x[6][L];
+    double v[6][L];
+    double t[L];
+    double binding[L];  // B = -E0 для каждой дорожки
+    double active[L];   // 1 - шагает, 0 - остановлена
+    double r01[L], r02[L], r12[L]; // расстояния на последнем толчке
+    double dt[L];       // приращение физического времени последнего дрейфа или толчка
+
+    void setMasses(const QList<double>& masses)
+    {
+        for (int i = 0; i < 3; ++i) m[i] = masses.value(i, 1.0);
+    }
+
+    // Начальное состояние дорожки; binding берётся из энергии
+    void load(int l, const double position[6], const double velocity[6], double time = 0.0)
+    {
+        for (int k = 0; k < 6; ++k) {
+            x[k][l] = position[k];
+            v[k][l] = velocity ? velocity[k] : 0.0;
+        }
+        t[l] = time;
+        active[l] = 1.0;
+        binding[l] = potential(l) - kinetic(l);
+    }
+
+    double kinetic(int l) const
+    {
+        return 0.5 * (m[0] * (v[0][l] * v[0][l] + v[1][l] * v[1][l]) +
+                      m[1] * (v[2][l] * v[2][l] + v[3][l] * v[3][l]) +
+                      m[2] * (v[4][l] * v[4][l] + v[5][l] * v[5][l]));
+    }
+
+    double potential(int l) const
+    {
+        return m[0] * m[1] / std::hypot(x[2][l] - x[0][l], x[3][l] - x[1][l]) +
+               m[0] * m[2] / std::hypot(x[4][l] - x[0][l], x[5][l] - x[1][l]) +
+               m[1] * m[2] / std::hypot(x[4][l] - x[2][l], x[5][l] - x[3][l]);
+    }
+
+    void drift(double ds)
+    {
+        const double m0 = m[0], m1 = m[1], m2 = m[2];
+        for (int l = 0; l < L; ++l) {
+            const double kinetic = 0.5 * (m0 * (v[0][l] * v[0][l] + v[1][l] * v[1][l]) +
+                                          m1 * (v[2][l] * v[2][l] + v[3][l] * v[3][l]) +
+                                          m2 * (v[4][l] * v[4][l] + v[5][l] * v[5][l]));
+            const double h = active[l] * ds / std::max(kinetic + binding[l], 1e-300);
+            for (int k = 0; k < 6; ++k) x[k][l] += h * v[k][l];
+            t[l] += h;
+            dt[l] = h;
+        }
+    }
+
+    void kick(double ds)
+    {
+        const double m0 = m[0], m1 = m[1], m2 = m[2];
+        for (int l = 0; l < L; ++l) {
+            const double dx01 = x[2][l] - x[0][l], dy01 = x[3][l] - x[1][l];
+            const double dx02 = x[4][l] - x[0][l], dy02 = x[5][l] - x[1][l];
+            const double dx12 = x[4][l] - x[2][l], dy12 = x[5][l] - x[3][l];
+            const double d01 = std::sqrt(dx01 * dx01 + dy01 * dy01);
+            const double d02 = std::sqrt(dx02 * dx02 + dy02 * dy02);
+            const double d12 = std::sqrt(dx12 * dx12 + dy12 * dy12);
+            const double i01 = 1.0 / (d01 * d01 * d01);
+            const double i02 = 1.0 / (d02 * d02 * d02);
+            const double i12 = 1.0 / (d12 * d12 * d12);
+            const double u = m0 * m1 / d01 + m0 * m2 / d02 + m1 * m2 / d12;
+
+            const double h = active[l] * ds / u;
+            v[0][l] += h * (m1 * dx01 * i01 + m2 * dx02 * i02);
+            v[1][l] += h * (m1 * dy01 * i01 + m2 * dy02 * i02);
+            v[2][l] += h * (-m0 * dx01 * i01 + m2 * dx12 * i12);
+            v[3][l] += h * (-m0 * dy01 * i01 + m2 * dy12 * i12);
+            v[4][l] += h * (-m0 * dx02 * i02 - m1 * dx12 * i12);
+            v[5][l] += h * (-m0 * dy02 * i02 - m1 * dy12 * i12);
+
+            dt[l] = h;
+            r01[l] = d01;
+            r02[l] = d02;
+            r12[l] = d12;
+        }
+    }
+
+    void step(double ds)
+    {
+        drift(0.5 * ds);
+        kick(ds);
+        drift(0.5 * ds);
+    }
+
+    // Вылет тела k: дальше radius от центра масс двух других, удаляется
+    // и не связано с ними. Номер тела или -1.
+    int escapingBody(int l, double radius) const
+    {
+        for (int k = 0; k < 3; ++k) {
+            const int i = (k + 1) % 3, j = (k + 2) % 3;
+            const double mass = m[i] + m[j];
+            const double rx = x[2 * k][l] - (m[i] * x[2 * i][l] + m[j] * x[2 * j][l]) / mass;
+            const double ry = x[2 * k + 1][l] - (m[i] * x[2 * i + 1][l] + m[j] * x[2 * j + 1][l]) / mass;
+            const double wx = v[2 * k][l] - (m[i] * v[2 * i][l] + m[j] * v[2 * j][l]) / mass;
+            const double wy = v[2 * k + 1][l] - (m[i] * v[2 * i + 1][l] + m[j] * v[2 * j + 1][l]) / mass;
+            const double r = std::hypot(rx, ry);
+            if (r < radius || rx * wx + ry * wy <= 0) continue;
+
+            const double mu = m[k] * mass / (m[k] + mass);
+            if (0.5 * mu * (wx * wx + wy * wy) - m[k] * mass / r > 0) return k;
+        }
+        return -1;
+    }
+};
+
+// Касательный вектор (δx, δv) к каждой дорожке ThreeBodyLanes - линеаризованные
+// уравнения движения. Подшаги повторяют подшаги дорожек с тем же приращением dt:
+// при замороженном dt касательное отображение чехарды с переменным шагом есть
+// схема для вариационных уравнений в физическом времени, dδx/dt = δv,
+// dδv/dt = ∂a/∂x · δx, без лишней составляющей вдоль потока от dt(x, v).
+// Норма периодически сбрасывается к 1, логарифм роста копится в logGrowth.
+template <int L>
+struct ThreeBodyTangent {
+    double dx[6][L];
+    double dv[6][L];
+    double logGrowth[L];
+
+    // Начальное направление дорожки (dx[0..5], dv[0..5]); центр масс
+    // и полный импульс исключаются, вектор нормируется
+    void load(int l, const double direction[12], const double m[3])
+    {
+        const double total = m[0] + m[1] + m[2];
+        for (int c = 0; c < 2; ++c) {
+            const double cx = (m[0] * direction[c] + m[1] * direction[2 + c] + m[2] * direction[4 + c]) / total;
+            const double cv = (m[0] * direction[6 + c] + m[1] * direction[8 + c] + m[2] * direction[10 + c]) / total;
+            for (int i = 0; i < 3; ++i) {
+                dx[2 * i + c][l] = direction[2 * i + c] - cx;
+                dv[2 * i + c][l] = direction[6 + 2 * i + c] - cv;
+            }
+        }
+        logGrowth[l] = 0.0;
+        const double n = norm(l);
+        const double scale = n > 0 ? 1.0 / n : 1.0;
+        for (int k = 0; k < 6; ++k) {
+            dx[k][l] *= scale;
+            dv[k][l] *= scale;
+        }
+    }
+
+    double norm(int l) const
+    {
+        double sum = 0.0;
+        for (int k = 0; k < 6; ++k) sum += dx[k][l] * dx[k][l] + dv[k][l] * dv[k][l];
+        return std::sqrt(sum);
+    }
+
+    void drift(const ThreeBodyLanes<L>& lanes)
+    {
+        for (int l = 0; l < L; ++l) {
+            const double h = lanes.dt[l];
+            for (int k = 0; k < 6; ++k) dx[k][l] += h * dv[k][l];
+        }
+    }
+
+    // Вызывается после lanes.kick: толчок не меняет x, поэтому вторые
+    // производные потенциала берутся в тех же точках
+    void kick(const ThreeBodyLanes<L>& lanes)
+    {
+        const double* m = lanes.m;
+        static constexpr int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+        for (int l = 0; l < L; ++l) {
+            const double h = lanes.dt[l];
+            for (const auto& pair : pairs) {
+                const int i = pair[0], j = pair[1];
+                const double ex = lanes.x[2 * j][l] - lanes.x[2 * i][l];
+                const double ey = lanes.x[2 * j + 1][l] - lanes.x[2 * i + 1][l];
+                const double r2 = ex * ex + ey * ey;
+                const double r = std::sqrt(r2);
+                const double i3 = 1.0 / (r2 * r);
+                const double i5 = 3.0 * i3 / r2;
+
+                // δ(e/r³) = δe/r³ - 3e(e·δe)/r⁵
+                const double qx = dx[2 * j][l] - dx[2 * i][l];
+                const double qy = dx[2 * j + 1][l] - dx[2 * i + 1][l];
+                const double dot = ex * qx + ey * qy;
+                const double fx = h * (qx * i3 - ex * dot * i5);
+                const double fy = h * (qy * i3 - ey * dot * i5);
+
+                dv[2 * i][l] += m[j] * fx;
+                dv[2 * i + 1][l] += m[j] * fy;
+                dv[2 * j][l] -= m[i] * fx;
+                dv[2 * j + 1][l] -= m[i] * fy;
+            }
+        }
+    }
+
+    // Шаг дорожек вместе с касательными векторами
+    void step(ThreeBodyLanes<L>& lanes, double ds)
+    {
+        lanes.drift(0.5 * ds);
+        drift(lanes);
+        lanes.kick(ds);
+        kick(lanes);
+        lanes.drift(0.5 * ds);
+        drift(lanes);
+    }
+
+    void renormalize()
+    {
+        for (int l = 0; l < L; ++l) {
+            const double n = norm(l);
+            if (!(n > 0) || !std::isfinite(n)) continue;
+            logGrowth[l] += std::log(n);
+            const double scale = 1.0 / n;
+            for (int k = 0; k < 6; ++k) {
+                dx[k][l] *= scale;
+                dv[k][l] *= scale;
+            }
+        }
+    }
+};
+
+#endif // THREEBODYLANES_H
@@ -0,0 +1,155 @@
+#include "threebodysource.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ThreeBodySource::ThreeBodySource(const QList<double>& masses, const ThreeBodySystem::State& initial,
+                                 ThreeBodySystem::Integrator integrator, double step, double tolerance)
+    : m_integrator(integrator),
+      m_system(masses, initial, integrator, step, tolerance)
+{
+    m_energy0 = m_system.energy();
+    m_angularMomentum0 = m_system.angularMomentum();
+
+    // У восьмёрки L0 = 0, поэтому уход момента меряем относительно Σ m|r||v|
+    double scale = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        scale += masses.value(i, 1.0) * std::hypot(initial.x[2 * i], initial.x[2 * i + 1]) *
+                 std::hypot(initial.v[2 * i], initial.v[2 * i + 1]);
+    }
+    m_angularMomentumScale = scale > 0 ? scale : 1.0;
+
+    m_checkpoints.append(m_system);
+    appendKnot();
+}
+
+void ThreeBodySource::appendKnot() const
+{
+    const ThreeBodySystem::State& state = m_system.state();
+    Knot knot;
+    knot.t = state.t;
+    std::memcpy(knot.x, state.x, sizeof(knot.x));
+    std::memcpy(knot.v, state.v, sizeof(knot.v));
+    m_knots.append(knot);
+
+    // Контроль сохранения - в узлах, а не на каждом шаге
+    const double energyDrift = std::abs(m_system.energy() - m_energy0) / std::max(std::abs(m_energy0), 1e-300);
+    const double momentumDrift = std::abs(m_system.angularMomentum() - m_angularMomentum0) / m_angularMomentumScale;
+    m_diagnostics.energyDrift = std::max(m_diagnostics.energyDrift, energyDrift);
+    m_diagnostics.angularMomentumDrift = std::max(m_diagnostics.angularMomentumDrift, momentumDrift);
+    m_diagnostics.time = m_frontier;
+}
+
+void ThreeBodySource::cover(double t) const
+{
+    // Запрос до начала окна: пересчёт от последней контрольной точки не позже t
+    if (t < m_knots.first().t) {
+        auto it = std::upper_bound(m_checkpoints.constBegin(), m_checkpoints.constEnd(), t,
+                                   [](double value, const ThreeBodySystem& system) { return value < system.state().t; });
+        m_system = *(it == m_checkpoints.constBegin() ? it : it - 1);
+        m_knots.clear();
+        appendKnot();
+    }
+    if (m_system.failed() || m_knots.last().t >= t) return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Схемы с переменным шагом сами сгущают шаги у сближений - там храним каждый
+    const bool everyStep = ThreeBodySystem::hasVariableStep(m_integrator);
+    const double target = t + ExtendSpan;
+    double lastKnot = m_knots.last().t;
+    while (m_system.state().t < target) {
+        if (!m_system.advance()) break;
+        const double now = m_system.state().t;
+        // Повторный пересчёт после перемотки назад в статистику шагов не входит
+        if (now > m_frontier) {
+            m_frontier = now;
+            ++m_diagnostics.steps;
+        }
+        if (now - m_checkpoints.last().state().t >= CheckpointSpan) {
+            m_checkpoints.append(m_system);
+        }
+        if (everyStep || now - lastKnot >= OutputStep * (1.0 - 1e-9)) {
+            appendKnot();
+            lastKnot = now;
+        }
+    }
+    if (!m_system.failed() && m_knots.last().t < m_system.state().t) {
+        appendKnot();
+    }
+
+    // Окно узлов: старые отбрасываются половиной разом, но узел перед t остаётся
+    if (m_knots.size() > MaxKnots) {
+        auto it = std::upper_bound(m_knots.constBegin(), m_knots.constEnd(), t,
+                                   [](double value, const Knot& knot) { return value < knot.t; });
+        const qsizetype limit = qMax<qsizetype>(0, (it - m_knots.constBegin()) - 1);
+        const qsizetype drop = qMin<qsizetype>(m_knots.size() - MaxKnots / 2, limit);
+        if (drop > 0) m_knots.remove(0, drop);
+    }
+
+    m_integrationNs += timer.nsecsElapsed();
+    m_diagnostics.forceEvaluations = std::max(m_diagnostics.forceEvaluations, m_system.forceEvaluations());
+    m_diagnostics.rejectedSteps = std::max(m_diagnostics.rejectedSteps, m_system.rejectedSteps());
+    m_diagnostics.failed = m_diagnostics.failed || m_system.failed();
+    m_diagnostics.stepsPerSecond = m_integrationNs > 0 ? m_diagnostics.steps * 1e9 / m_integrationNs : 0.0;
+}
+
+bool ThreeBodySource::positionsAt(double t, QPointF points[3]) const
+{
+    if (!(t >= 0.0)) return false;
+
+    {
+        QReadLocker locker(&m_lock);
+        if (covers(t)) return interpolate(t, points);
+    }
+
+    // Досчитываем и читаем под одной блокировкой: иначе другой поток
+    // мог бы сдвинуть окно узлов между расчётом и чтением
+    QWriteLocker locker(&m_lock);
+    cover(t);
+    if (!covers(t)) return false; // интегрирование остановилось раньше
+    return interpolate(t, points);
+}
+
+bool ThreeBodySource::interpolate(double t, QPointF points[3]) const
+{
+    // Отрезок [k, k+1], содержащий t
+    auto it = std::upper_bound(m_knots.constBegin(), m_knots.constEnd(), t,
+                               [](double value, const Knot& knot) { return value < knot.t; });
+    const qsizetype k = qBound<qsizetype>(0, (it - m_knots.constBegin()) - 1, m_knots.size() - 1);
+
+    const Knot& a = m_knots[k];
+    if (k + 1 >= m_knots.size()) {
+        for (int i = 0; i < 3; ++i) points[i] = QPointF(a.x[2 * i], a.x[2 * i + 1]);
+        return true;
+    }
+
+    // Эрмитов кубический сплайн по положениям и скоростям концов
+    const Knot& b = m_knots[k + 1];
+    const double h = b.t - a.t;
+    const double s = (t - a.t) / h;
+    const double s2 = s * s, s3 = s2 * s;
+    const double h00 = 2 * s3 - 3 * s2 + 1;
+    const double h10 = (s3 - 2 * s2 + s) * h;
+    const double h01 = -2 * s3 + 3 * s2;
+    const double h11 = (s3 - s2) * h;
+
+    double x[6];
+    for (int c = 0; c < 6; ++c) {
+        x[c] = h00 * a.x[c] + h10 * a.v[c] + h01 * b.x[c] + h11 * b.v[c];
+    }
+    for (int i = 0; i < 3; ++i) {
+        points[i] = QPointF(x[2 * i], x[2 * i + 1]);
+    }
+    return true;
+}
+
+ThreeBodySource::Diagnostics ThreeBodySource::diagnostics() const
+{
+    QReadLocker locker(&m_lock);
+    return m_diagnostics;
+}
@@ -0,0 +1,74 @@
+#ifndef THREEBODYSOURCE_H
+#define THREEBODYSOURCE_H
+
+#include <QList>
+#include <QVector>
+#include <QReadWriteLock>
+#include "positionsource.h"
+#include "threebody.h"
+
+// Положения тел из численного решения задачи трёх тел.
+// Интегрирование идёт лениво: запрос за пределами уже посчитанного отрезка
+// продолжает его (под блокировкой записи) в том потоке, который спросил, -
+// обычно это поток симуляции или построитель шкалы времени, но не GUI.
+// Узлы плотного вывода (положения и скорости) хранятся с шагом не реже
+// OutputStep (для схем с переменным шагом - на каждом шаге); между ними - кубический эрмитов сплайн, так что случайный доступ
+// по t не требует повторного интегрирования.
+// Узлов хранится не больше MaxKnots (окно у последнего запроса); раз в
+// CheckpointSpan запоминается состояние интегратора, и запрос до начала окна
+// пересчитывает узлы от ближайшей контрольной точки - память не растёт со временем.
+class ThreeBodySource : public PositionSource
+{
+public:
+    ThreeBodySource(const QList<double>& masses, const ThreeBodySystem::State& initial,
+                    ThreeBodySystem::Integrator integrator, double step, double tolerance = 1e-10);
+
+    bool positionsAt(double t, QPointF points[3]) const override;
+
+    // Контроль интегрирования: уход энергии и момента импульса относительно начальных
+    struct Diagnostics {
+        double time = 0.0;              // до какого t посчитано
+        quint64 steps = 0;
+        quint64 forceEvaluations = 0;
+        quint64 rejectedSteps = 0;
+        double energyDrift = 0.0;       // max |E - E0| / |E0|
+        double angularMomentumDrift = 0.0; // max |L - L0| / масштаб момента
+        double stepsPerSecond = 0.0;
+        bool failed = false;            // столкновение или вырожденный шаг
+    };
+    Diagnostics diagnostics() const;
+
+    ThreeBodySystem::Integrator integrator() const { return m_integrator; }
+
+    static constexpr double OutputStep = 1e-3;  // максимальный шаг между узлами
+    static constexpr double ExtendSpan = 1.0;   // интегрируем вперёд с запасом
+    static constexpr int MaxKnots = 1 << 18;    // ~27 МБ узлов
+    static constexpr double CheckpointSpan = 10.0;
+
+private:
+    struct Knot {
+        double t;
+        double x[6];
+        double v[6];
+    };
+
+    void cover(double t) const;
+    void appendKnot() const;
+    bool covers(double t) const { return m_knots.first().t <= t && m_knots.last().t >= t; }
+    bool interpolate(double t, QPointF points[3]) const;
+
+    const ThreeBodySystem::Integrator m_integrator;
+
+    mutable QReadWriteLock m_lock;
+    mutable ThreeBodySystem m_system;
+    mutable QVector<Knot> m_knots;
+    mutable QVector<ThreeBodySystem> m_checkpoints; // по возрастанию t
+    mutable double m_frontier = 0.0;                // дальше всего посчитанное t
+    mutable Diagnostics m_diagnostics;
+    mutable qint64 m_integrationNs = 0;
+    double m_energy0 = 0.0;
+    double m_angularMomentum0 = 0.0;
+    double m_angularMomentumScale = 1.0;
+};
+
+#endif // THREEBODYSOURCE_H
@@ -0,0 +1,164 @@
+#include "timelinecache.h"
+#include "parallelfor.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+
+TimelineCache::TimelineCache(QObject* parent)
+    : QThread(parent)
+{
+}
+
+TimelineCache::~TimelineCache()
+{
+    stop();
+}
+
+void TimelineCache::rebuild(std::shared_ptr<const PositionSource> source, const QList<double>& masses,
+                            double maxTime, int resolution)
+{
+    QMutexLocker locker(&m_mutex);
+    m_timeline.reset();
+
+    if (!source || maxTime <= 0 || resolution < 2) {
+        m_generation.fetch_add(1);
+        m_hasPending = false;
+        return;
+    }
+
+    m_pending.source = std::move(source);
+    m_pending.masses = masses;
+    m_pending.maxTime = maxTime;
+    m_pending.resolution = resolution;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+}
+
+void TimelineCache::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1); // прерывает идущее построение
+    m_hasPending = false;
+    m_timeline.reset();
+}
+
+void TimelineCache::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+bool TimelineCache::isReady() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timeline != nullptr;
+}
+
+int TimelineCache::sampleCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timeline ? m_timeline->samples.size() : 0;
+}
+
+bool TimelineCache::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+bool TimelineCache::lookup(double t, ShapeState& state) const
+{
+    std::shared_ptr<const Timeline> timeline;
+    {
+        QMutexLocker locker(&m_mutex);
+        timeline = m_timeline;
+    }
+    if (!timeline || t < 0 || t > timeline->maxTime) return false;
+
+    const int last = timeline->samples.size() - 1;
+    double position = t / timeline->maxTime * last;
+    int index = qBound(0, static_cast<int>(std::floor(position)), last);
+    int next = qMin(index + 1, last);
+
+    const ShapeState& a = timeline->samples[index];
+    const ShapeState& b = timeline->samples[next];
+    if (!a.valid && !b.valid) return false;
+
+    state = ShapeState::interpolate(a, b, position - index);
+    return true;
+}
+
+QVector<ShapeState> TimelineCache::samples() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timeline ? m_timeline->samples : QVector<ShapeState>();
+}
+
+void TimelineCache::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        auto timeline = std::make_shared<Timeline>();
+        timeline->maxTime = request.maxTime;
+        timeline->samples.resize(request.resolution);
+        ShapeState* samples = timeline->samples.data();
+
+        const int count = request.resolution;
+        const double step = request.maxTime / (count - 1);
+        const int progressStep = qMax(1, count / 100);
+        std::atomic<int> done{0};
+
+        try {
+            parallelFor(0, count, [&](int i) {
+                if (isCancelled(request.generation)) return;
+
+                QPointF points[3];
+                if (request.source->positionsAt(i * step, points)) {
+                    PositionSource::fitToScene(points);
+                    samples[i] = ShapeState::compute({points[0], points[1], points[2]}, request.masses);
+                }
+
+                int finished = done.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (finished % progressStep == 0) {
+                    emit progress(finished * 100 / count);
+                }
+            });
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in TimelineCache:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in TimelineCache";
+            continue;
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (isCancelled(request.generation)) continue;
+            m_timeline = timeline;
+        }
+        emit ready(count, timer.elapsed());
+    }
+}
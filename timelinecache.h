@@ -0,0 +1,74 @@
+#ifndef TIMELINECACHE_H
+#define TIMELINECACHE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include <atomic>
+#include <memory>
+#include "shapestate.h"
+#include "positionsource.h"
+
+// Предвычисленная шкала времени анимации.
+// Фоновый поток равномерно выбирает [0, maxTime] на всех ядрах и хранит
+// для каждой выборки треугольник, точку сферы, ζ и корни в непрерывном массиве.
+// Перемотка слайдером сводится к поиску соседних выборок и интерполяции.
+class TimelineCache : public QThread
+{
+    Q_OBJECT
+public:
+    explicit TimelineCache(QObject* parent = nullptr);
+    ~TimelineCache();
+
+    // Отменяет текущее построение и запускает новое
+    void rebuild(std::shared_ptr<const PositionSource> source, const QList<double>& masses,
+                 double maxTime, int resolution);
+    // Сбрасывает готовую шкалу (функции или массы больше не те)
+    void invalidate();
+    void stop();
+
+    bool isReady() const;
+    int sampleCount() const;
+
+    // Состояние в момент t; false, если шкала не готова или t вне её
+    bool lookup(double t, ShapeState& state) const;
+
+    // Все выборки готовой шкалы (данные разделяются, не копируются)
+    QVector<ShapeState> samples() const;
+
+signals:
+    void progress(int percent);
+    void ready(int samples, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        std::shared_ptr<const PositionSource> source;
+        QList<double> masses;
+        double maxTime = 0.0;
+        int resolution = 0;
+        quint64 generation = 0;
+    };
+
+    struct Timeline {
+        double maxTime = 0.0;
+        QVector<ShapeState> samples;
+    };
+
+    bool isCancelled(quint64 generation) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const Timeline> m_timeline; // под m_mutex
+};
+
+#endif // TIMELINECACHE_H
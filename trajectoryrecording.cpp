@@ -0,0 +1,480 @@
+#include "trajectoryrecording.h"
+#include "coordtransform.h"
+#include <QSysInfo>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace TrajectoryRecording {
+
+namespace {
+
+const char HeaderMagic[8] = {'T', 'S', 'R', 'E', 'C', 'O', 'R', 'D'};
+const char ChunkMagic[4] = {'C', 'H', 'N', 'K'};
+constexpr qint64 ChunkHeaderBytes = 64;
+constexpr qint64 PageBytes = 4096;
+constexpr int FieldNameBytes = 16;
+
+const char* const FieldNames[FieldCount] = {
+    "t", "x1", "y1", "x2", "y2", "x3", "y3", "nx", "ny", "nz", "radius",
+    "z0_re", "z0_im", "z1_re", "z1_im", "z2_re", "z2_im", "z3_re", "z3_im", "flags"
+};
+
+qint64 roundUp(qint64 value, qint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void put(QByteArray& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool take(const uchar*& cursor, const uchar* end, T& value)
+{
+    if (end - cursor < qint64(sizeof(T))) return false;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+template <typename T>
+T load(const uchar* base, qint64 offset)
+{
+    T value;
+    std::memcpy(&value, base + offset, sizeof(T));
+    return value;
+}
+
+}
+
+const char* fieldName(Field field)
+{
+    return FieldNames[field];
+}
+
+FieldType fieldType(Field field)
+{
+    if (field == Time) return Float64;
+    if (field == Flags) return UInt32;
+    return Float32;
+}
+
+Layout Layout::make(quint32 chunkCapacity, quint32 overviewCapacity)
+{
+    Layout layout;
+    layout.chunkCapacity = chunkCapacity;
+    layout.overviewCapacity = overviewCapacity;
+
+    qint64 offset = ChunkHeaderBytes;
+    for (int f = 0; f < FieldCount; ++f) {
+        layout.fieldSize[f] = fieldType(Field(f)) == Float64 ? 8 : 4;
+        layout.overviewOffset[f] = offset;
+        offset = roundUp(offset + qint64(layout.fieldSize[f]) * overviewCapacity, 8);
+    }
+    for (int f = 0; f < FieldCount; ++f) {
+        layout.mainOffset[f] = offset;
+        offset = roundUp(offset + qint64(layout.fieldSize[f]) * chunkCapacity, 8);
+    }
+    // Чанки выровнены на страницу, чтобы отображение читалось целыми страницами
+    layout.chunkBytes = roundUp(offset, PageBytes);
+    return layout;
+}
+
+}
+
+using namespace TrajectoryRecording;
+
+// ---------------------------------------------------------------------------
+// TrajectoryRecorder
+
+TrajectoryRecorder::TrajectoryRecorder()
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+bool TrajectoryRecorder::open(const QString& fileName, const QList<double>& masses,
+                              const QStringList& functions, quint32 chunkCapacity)
+{
+    close();
+
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+        m_error = "Recording requires a little-endian host";
+        return false;
+    }
+
+    // Ёмкость кратна размеру обзора, чтобы шаг прореживания был целым
+    chunkCapacity = qMax(OverviewCapacity, chunkCapacity / OverviewCapacity * OverviewCapacity);
+    m_layout = Layout::make(chunkCapacity, OverviewCapacity);
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = "Cannot open file for writing: " + fileName;
+        return false;
+    }
+
+    QByteArray header;
+    header.append(HeaderMagic, sizeof(HeaderMagic));
+    put(header, Version);
+    put(header, quint32(0)); // размер заголовка, заполняется ниже
+    put(header, m_layout.chunkCapacity);
+    put(header, m_layout.overviewCapacity);
+    put(header, quint32(FieldCount));
+    put(header, quint32(0)); // резерв
+    for (int i = 0; i < 3; ++i) {
+        put(header, masses.value(i, 1.0));
+    }
+    for (int i = 0; i < 6; ++i) {
+        QByteArray text = functions.value(i).toUtf8();
+        put(header, quint32(text.size()));
+        header.append(text);
+    }
+    for (int f = 0; f < FieldCount; ++f) {
+        char name[FieldNameBytes] = {};
+        std::strncpy(name, fieldName(Field(f)), FieldNameBytes - 1);
+        header.append(name, FieldNameBytes);
+        put(header, quint32(fieldType(Field(f))));
+        put(header, m_layout.fieldSize[f]);
+    }
+
+    const quint32 headerSize = quint32(roundUp(header.size(), 4096));
+    std::memcpy(header.data() + sizeof(HeaderMagic) + sizeof(quint32), &headerSize, sizeof(headerSize));
+    header.append(QByteArray(headerSize - header.size(), '\0'));
+
+    if (m_file.write(header) != header.size()) {
+        m_error = "Write error: " + m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_chunk = QByteArray(m_layout.chunkBytes, '\0');
+    m_count = 0;
+    m_written = 0;
+    m_error.clear();
+    return true;
+}
+
+void TrajectoryRecorder::append(double t, const ShapeState& state, bool breakBefore)
+{
+    if (!m_file.isOpen()) return;
+
+    if (m_count == 0) m_firstTime = t;
+    m_lastTime = t;
+
+    uchar* chunk = reinterpret_cast<uchar*>(m_chunk.data());
+    const quint32 k = m_count;
+    auto putFloat = [&](Field field, double value) {
+        float v = float(value);
+        std::memcpy(chunk + m_layout.mainOffset[field] + qint64(k) * 4, &v, 4);
+    };
+
+    std::memcpy(chunk + m_layout.mainOffset[Time] + qint64(k) * 8, &t, 8);
+    putFloat(X1, state.points[0].x());
+    putFloat(Y1, state.points[0].y());
+    putFloat(X2, state.points[1].x());
+    putFloat(Y2, state.points[1].y());
+    putFloat(X3, state.points[2].x());
+    putFloat(Y3, state.points[2].y());
+    putFloat(NX, state.normalized.x());
+    putFloat(NY, state.normalized.y());
+    putFloat(NZ, state.normalized.z());
+    putFloat(Radius, state.radius);
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double roots[8] = {nan, nan, nan, nan, nan, nan, nan, nan};
+    for (int i = 0; i < state.rootCount; ++i) {
+        int branch = state.roots[i].branch;
+        if (branch < 0 || branch >= 4) continue;
+        roots[2 * branch] = state.roots[i].point.x();
+        roots[2 * branch + 1] = state.roots[i].point.y();
+    }
+    for (int i = 0; i < 8; ++i) {
+        putFloat(Field(Z0Re + i), roots[i]);
+    }
+
+    quint32 flags = (state.valid ? FlagValid : 0) | (breakBefore ? FlagBreak : 0);
+    std::memcpy(chunk + m_layout.mainOffset[Flags] + qint64(k) * 4, &flags, 4);
+
+    if (++m_count == m_layout.chunkCapacity) {
+        flushChunk();
+    }
+}
+
+void TrajectoryRecorder::flushChunk()
+{
+    if (m_count == 0 || !m_file.isOpen()) return;
+
+    uchar* chunk = reinterpret_cast<uchar*>(m_chunk.data());
+    const quint32 stride = m_layout.chunkCapacity / m_layout.overviewCapacity;
+    const quint32 overviewCount = (m_count + stride - 1) / stride;
+
+    // Обзор: каждая stride-я выборка; разрыв внутри окна переносится на обзорную точку
+    for (quint32 j = 0; j < overviewCount; ++j) {
+        const quint32 source = j * stride;
+        for (int f = 0; f < FieldCount; ++f) {
+            const quint32 size = m_layout.fieldSize[f];
+            std::memcpy(chunk + m_layout.overviewOffset[f] + qint64(j) * size,
+                        chunk + m_layout.mainOffset[f] + qint64(source) * size, size);
+        }
+
+        quint32 flags = load<quint32>(chunk, m_layout.mainOffset[Flags] + qint64(source) * 4);
+        const quint32 windowEnd = qMin(source + stride, m_count);
+        for (quint32 k = source + 1; k < windowEnd; ++k) {
+            flags |= load<quint32>(chunk, m_layout.mainOffset[Flags] + qint64(k) * 4) & FlagBreak;
+        }
+        std::memcpy(chunk + m_layout.overviewOffset[Flags] + qint64(j) * 4, &flags, 4);
+    }
+
+    std::memcpy(chunk, ChunkMagic, sizeof(ChunkMagic));
+    std::memcpy(chunk + 4, &m_count, 4);
+    std::memcpy(chunk + 8, &overviewCount, 4);
+    std::memcpy(chunk + 16, &m_firstTime, 8);
+    std::memcpy(chunk + 24, &m_lastTime, 8);
+
+    if (m_file.write(m_chunk) != m_chunk.size()) {
+        m_error = "Write error: " + m_file.errorString();
+        qWarning() << "TrajectoryRecorder:" << m_error;
+        m_file.close();
+        return;
+    }
+
+    m_written += m_count;
+    m_count = 0;
+}
+
+void TrajectoryRecorder::close()
+{
+    if (!m_file.isOpen()) return;
+    flushChunk();
+    m_file.close();
+}
+
+// ---------------------------------------------------------------------------
+// TrajectoryReplay
+
+TrajectoryReplay::~TrajectoryReplay()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+}
+
+std::shared_ptr<TrajectoryReplay> TrajectoryReplay::open(const QString& fileName, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return std::shared_ptr<TrajectoryReplay>();
+    };
+
+    std::shared_ptr<TrajectoryReplay> replay(new TrajectoryReplay());
+    replay->m_file.setFileName(fileName);
+    if (!replay->m_file.open(QIODevice::ReadOnly)) {
+        return fail("Cannot open file: " + fileName);
+    }
+
+    replay->m_size = replay->m_file.size();
+    replay->m_data = replay->m_file.map(0, replay->m_size);
+    if (!replay->m_data) {
+        return fail("Cannot map file: " + replay->m_file.errorString());
+    }
+
+    const uchar* cursor = replay->m_data;
+    const uchar* end = replay->m_data + replay->m_size;
+
+    char magic[8];
+    if (end - cursor < 8) return fail("Not a trajectory recording");
+    std::memcpy(magic, cursor, 8);
+    cursor += 8;
+    if (std::memcmp(magic, HeaderMagic, 8) != 0) return fail("Not a trajectory recording");
+
+    quint32 version, headerSize, chunkCapacity, overviewCapacity, fieldCount, reserved;
+    if (!take(cursor, end, version) || !take(cursor, end, headerSize) ||
+        !take(cursor, end, chunkCapacity) || !take(cursor, end, overviewCapacity) ||
+        !take(cursor, end, fieldCount) || !take(cursor, end, reserved)) {
+        return fail("Truncated header");
+    }
+    if (version != Version) return fail(QString("Unsupported recording version %1").arg(version));
+    if (fieldCount != FieldCount || overviewCapacity == 0 ||
+        chunkCapacity == 0 || chunkCapacity % overviewCapacity != 0) {
+        return fail("Unsupported sample layout");
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        double mass;
+        if (!take(cursor, end, mass)) return fail("Truncated header");
+        replay->m_masses.append(mass);
+    }
+    for (int i = 0; i < 6; ++i) {
+        quint32 length;
+        if (!take(cursor, end, length) || end - cursor < qint64(length)) return fail("Truncated header");
+        replay->m_functions.append(QString::fromUtf8(reinterpret_cast<const char*>(cursor), length));
+        cursor += length;
+    }
+
+    replay->m_layout = Layout::make(chunkCapacity, overviewCapacity);
+    for (int f = 0; f < FieldCount; ++f) {
+        char name[FieldNameBytes + 1] = {};
+        quint32 type, size;
+        if (end - cursor < FieldNameBytes) return fail("Truncated header");
+        std::memcpy(name, cursor, FieldNameBytes);
+        cursor += FieldNameBytes;
+        if (!take(cursor, end, type) || !take(cursor, end, size)) return fail("Truncated header");
+        if (std::strcmp(name, fieldName(Field(f))) != 0 || type != quint32(fieldType(Field(f))) ||
+            size != replay->m_layout.fieldSize[f]) {
+            return fail(QString("Unexpected field %1 in sample layout").arg(QString::fromLatin1(name)));
+        }
+    }
+
+    replay->m_headerSize = headerSize;
+    if (headerSize > replay->m_size) return fail("Truncated header");
+
+    // Разреженный индекс: по одной записи на чанк из заголовков чанков
+    const qint64 chunkBytes = replay->m_layout.chunkBytes;
+    const qint64 chunkCount = (replay->m_size - headerSize) / chunkBytes;
+    replay->m_chunks.reserve(chunkCount);
+    for (qint64 c = 0; c < chunkCount; ++c) {
+        const uchar* chunk = replay->m_data + headerSize + c * chunkBytes;
+        if (std::memcmp(chunk, ChunkMagic, sizeof(ChunkMagic)) != 0) break;
+
+        ChunkInfo info;
+        info.count = load<quint32>(chunk, 4);
+        info.overviewCount = load<quint32>(chunk, 8);
+        info.firstTime = load<double>(chunk, 16);
+        info.lastTime = load<double>(chunk, 24);
+        if (info.count == 0 || info.count > chunkCapacity || info.overviewCount > overviewCapacity) break;
+
+        replay->m_chunks.append(info);
+        replay->m_sampleCount += info.count;
+        // Неполным может быть только последний чанк
+        if (info.count < chunkCapacity) break;
+    }
+
+    if (replay->m_chunks.isEmpty()) return fail("Recording contains no samples");
+    replay->m_startTime = replay->m_chunks.first().firstTime;
+    replay->m_endTime = replay->m_chunks.last().lastTime;
+    return replay;
+}
+
+const uchar* TrajectoryReplay::chunkData(int chunk) const
+{
+    return m_data + m_headerSize + qint64(chunk) * m_layout.chunkBytes;
+}
+
+double TrajectoryReplay::time(qint64 index) const
+{
+    index = qBound(qint64(0), index, m_sampleCount - 1);
+    const int chunk = int(index / m_layout.chunkCapacity);
+    const qint64 k = index % m_layout.chunkCapacity;
+    return load<double>(chunkData(chunk), m_layout.mainOffset[Time] + k * 8);
+}
+
+ShapeState TrajectoryReplay::readState(const uchar* chunk, bool overview, quint32 index, quint32* flags) const
+{
+    const qint64* offsets = overview ? m_layout.overviewOffset : m_layout.mainOffset;
+    auto value = [&](Field field) {
+        return double(load<float>(chunk, offsets[field] + qint64(index) * 4));
+    };
+
+    ShapeState state;
+    const quint32 sampleFlags = load<quint32>(chunk, offsets[Flags] + qint64(index) * 4);
+    if (flags) *flags = sampleFlags;
+
+    state.points[0] = QPointF(value(X1), value(Y1));
+    state.points[1] = QPointF(value(X2), value(Y2));
+    state.points[2] = QPointF(value(X3), value(Y3));
+    state.valid = (sampleFlags & FlagValid) != 0;
+    if (!state.valid) return state;
+
+    state.normalized = QVector3D(value(NX), value(NY), value(NZ));
+    state.radius = value(Radius);
+    state.raw = state.normalized * float(state.radius);
+    state.zeta = QPointF(state.normalized.x(), state.normalized.y());
+
+    for (int branch = 0; branch < 4; ++branch) {
+        double re = value(Field(Z0Re + 2 * branch));
+        double im = value(Field(Z0Im + 2 * branch));
+        if (std::isnan(re) || std::isnan(im)) continue;
+        state.roots[state.rootCount++] = ComplexSolution(QPointF(re, im),
+                                                         CoordTransform::branchColor(branch), branch);
+    }
+    return state;
+}
+
+ShapeState TrajectoryReplay::state(qint64 index, bool* breakBefore) const
+{
+    index = qBound(qint64(0), index, m_sampleCount - 1);
+    const int chunk = int(index / m_layout.chunkCapacity);
+    quint32 flags = 0;
+    ShapeState result = readState(chunkData(chunk), false, quint32(index % m_layout.chunkCapacity), &flags);
+    if (breakBefore) *breakBefore = (flags & FlagBreak) != 0;
+    return result;
+}
+
+qint64 TrajectoryReplay::indexAtTime(double t) const
+{
+    // Сначала чанк по разреженному индексу...
+    auto chunkIt = std::upper_bound(m_chunks.constBegin(), m_chunks.constEnd(), t,
+                                    [](double value, const ChunkInfo& info) { return value < info.firstTime; });
+    const int chunk = qMax(0, int(chunkIt - m_chunks.constBegin()) - 1);
+
+    // ...затем выборка внутри чанка
+    const uchar* data = chunkData(chunk);
+    const qint64 timeOffset = m_layout.mainOffset[Time];
+    quint32 lo = 0, hi = m_chunks[chunk].count;
+    while (lo < hi) {
+        quint32 mid = (lo + hi) / 2;
+        if (load<double>(data, timeOffset + qint64(mid) * 8) <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    const quint32 k = lo > 0 ? lo - 1 : 0;
+    return qint64(chunk) * m_layout.chunkCapacity + k;
+}
+
+bool TrajectoryReplay::stateAt(double t, ShapeState& state) const
+{
+    if (m_sampleCount == 0 || t < m_startTime || t > m_endTime) return false;
+
+    const qint64 index = indexAtTime(t);
+    const qint64 next = qMin(index + 1, m_sampleCount - 1);
+
+    ShapeState a = this->state(index);
+    bool breakBefore = false;
+    ShapeState b = this->state(next, &breakBefore);
+    const double ta = time(index);
+    const double tb = time(next);
+
+    // Через разрыв не интерполируем
+    if (next == index || breakBefore || tb <= ta) {
+        state = a;
+    } else {
+        state = ShapeState::interpolate(a, b, (t - ta) / (tb - ta));
+    }
+    return state.valid;
+}
+
+void TrajectoryReplay::overview(TrajectoryBatch& batch) const
+{
+    int total = 0;
+    for (const ChunkInfo& info : m_chunks) total += info.overviewCount;
+    batch.clear();
+    batch.reserve(total + m_chunks.size());
+
+    for (int c = 0; c < m_chunks.size(); ++c) {
+        const uchar* data = chunkData(c);
+        for (quint32 j = 0; j < m_chunks[c].overviewCount; ++j) {
+            quint32 flags = 0;
+            ShapeState state = readState(data, true, j, &flags);
+            if ((flags & FlagBreak) && !batch.isEmpty()) batch.appendBreak();
+            batch.append(state);
+        }
+    }
+}
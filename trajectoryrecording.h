@@ -0,0 +1,150 @@
+#ifndef TRAJECTORYRECORDING_H
+#define TRAJECTORYRECORDING_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QFile>
+#include <memory>
+#include "shapestate.h"
+
+// Запись и воспроизведение прогонов анимации.
+//
+// Файл: заголовок (выровнен на 4096) и цепочка чанков фиксированного размера.
+//   Заголовок: magic "TSRECORD", версия, размер заголовка, ёмкость чанка,
+//   ёмкость обзора, число полей, массы, шесть функций (длина + UTF-8),
+//   таблица полей (имя[16], тип, размер).
+//   Чанк: 64-байтовый заголовок ("CHNK", число выборок, число обзорных выборок,
+//   t первой и последней), затем обзорный блок (каждая stride-я выборка,
+//   чтобы открыть длинную запись, не читая её целиком), затем основной блок.
+//   Оба блока - SoA: для каждого поля непрерывный массив фиксированной длины.
+// Так как чанки одного размера, выборка i находится без поиска; по времени -
+// бинарный поиск по разреженному индексу (t первой/последней выборки чанка),
+// затем внутри чанка.
+namespace TrajectoryRecording {
+
+enum Field {
+    Time,                       // f64, время записи (монотонное, без перескоков)
+    X1, Y1, X2, Y2, X3, Y3,     // f32, треугольник
+    NX, NY, NZ,                 // f32, точка на единичной сфере
+    Radius,                     // f32, |ξ|
+    Z0Re, Z0Im, Z1Re, Z1Im, Z2Re, Z2Im, Z3Re, Z3Im, // f32, корни по ветвям (NaN - нет)
+    Flags,                      // u32, FlagValid | FlagBreak
+    FieldCount
+};
+
+enum FieldType : quint32 {
+    Float32 = 1,
+    Float64 = 2,
+    UInt32 = 3
+};
+
+enum SampleFlags : quint32 {
+    FlagValid = 1,
+    FlagBreak = 2   // перед выборкой траектория разрывается
+};
+
+constexpr quint32 Version = 1;
+constexpr quint32 DefaultChunkCapacity = 65536;
+constexpr quint32 OverviewCapacity = 256;
+
+struct Layout {
+    quint32 chunkCapacity = DefaultChunkCapacity;
+    quint32 overviewCapacity = OverviewCapacity;
+    quint32 fieldSize[FieldCount];
+    qint64 overviewOffset[FieldCount]; // от начала чанка
+    qint64 mainOffset[FieldCount];     // от начала чанка
+    qint64 chunkBytes = 0;
+
+    static Layout make(quint32 chunkCapacity, quint32 overviewCapacity);
+};
+
+const char* fieldName(Field field);
+FieldType fieldType(Field field);
+
+}
+
+// Писатель: только дописывает в конец, полный чанк уходит одной записью.
+// Используется из одного потока (потока симуляции).
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    bool open(const QString& fileName, const QList<double>& masses, const QStringList& functions,
+              quint32 chunkCapacity = TrajectoryRecording::DefaultChunkCapacity);
+    void append(double t, const ShapeState& state, bool breakBefore);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    qint64 sampleCount() const { return m_written + m_count; }
+    QString errorString() const { return m_error; }
+
+private:
+    void flushChunk();
+
+    QFile m_file;
+    TrajectoryRecording::Layout m_layout;
+    QByteArray m_chunk;     // буфер текущего чанка в формате файла
+    quint32 m_count = 0;    // выборок в буфере
+    qint64 m_written = 0;   // выборок в уже записанных чанках
+    double m_firstTime = 0.0;
+    double m_lastTime = 0.0;
+    QString m_error;
+};
+
+// Воспроизведение через отображение файла в память (QFile::map).
+// Открытие читает только заголовки чанков; данные подгружаются ОС по мере обращения.
+class TrajectoryReplay
+{
+public:
+    ~TrajectoryReplay();
+
+    static std::shared_ptr<TrajectoryReplay> open(const QString& fileName, QString* error = nullptr);
+
+    qint64 sampleCount() const { return m_sampleCount; }
+    double startTime() const { return m_startTime; }
+    double endTime() const { return m_endTime; }
+    QList<double> masses() const { return m_masses; }
+    QStringList functions() const { return m_functions; }
+    QString fileName() const { return m_file.fileName(); }
+
+    double time(qint64 index) const;
+    ShapeState state(qint64 index, bool* breakBefore = nullptr) const;
+
+    // Последняя выборка с временем <= t
+    qint64 indexAtTime(double t) const;
+    // Состояние в момент t с интерполяцией между соседними выборками
+    bool stateAt(double t, ShapeState& state) const;
+
+    // Прореженная траектория всей записи из обзорных блоков
+    void overview(TrajectoryBatch& batch) const;
+
+private:
+    struct ChunkInfo {
+        quint32 count = 0;
+        quint32 overviewCount = 0;
+        double firstTime = 0.0;
+        double lastTime = 0.0;
+    };
+
+    TrajectoryReplay() = default;
+    const uchar* chunkData(int chunk) const;
+    ShapeState readState(const uchar* chunk, bool overview, quint32 index, quint32* flags) const;
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_headerSize = 0;
+    TrajectoryRecording::Layout m_layout;
+    QVector<ChunkInfo> m_chunks;   // разреженный индекс по времени
+    qint64 m_sampleCount = 0;
+    double m_startTime = 0.0;
+    double m_endTime = 0.0;
+    QList<double> m_masses;
+    QStringList m_functions;
+};
+
+#endif // TRAJECTORYRECORDING_H
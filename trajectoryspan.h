@@ -0,0 +1,35 @@
+#ifndef TRAJECTORYSPAN_H
+#define TRAJECTORYSPAN_H
+
+#include <QPointF>
+#include <QVector3D>
+#include <limits>
+#include <cmath>
+
+// Маркеры разрыва для пакетной загрузки траекторий.
+// В непрерывном буфере точек точка с NaN-координатой начинает новый сегмент
+// (например, при перескоке времени с maxTime на 0 или пропавшем корне).
+
+inline QPointF trajectoryBreakPoint()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    return QPointF(nan, nan);
+}
+
+inline QVector3D trajectoryBreakVertex()
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    return QVector3D(nan, nan, nan);
+}
+
+inline bool isTrajectoryBreak(const QPointF& point)
+{
+    return std::isnan(point.x()) || std::isnan(point.y());
+}
+
+inline bool isTrajectoryBreak(const QVector3D& point)
+{
+    return std::isnan(point.x()) || std::isnan(point.y()) || std::isnan(point.z());
+}
+
+#endif // TRAJECTORYSPAN_H
@@ -0,0 +1,345 @@
+#include "trianglemontecarlo.h"
+#include "coordtransform.h"
+#include "parallelfor.h"
+#include "philox.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Ветвление-свободные log и sincos для циклов по блоку: std::log, std::cos и
+// std::sin без -ffast-math остаются скалярными вызовами libm, и цикл с ними
+// не векторизуется. Здесь только арифметика, сравнения с выбором и
+// целочисленные операции над битами double, которые есть в SSE2.
+// Аргументы - числа Philox из (0, 1); ошибка - несколько ulp.
+
+inline quint64 bitsOf(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+inline double fromBits(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+// ln u для нормального положительного u: u = 2^k·m, m ∈ [√½, √2),
+// ln m = 2 atanh(s), s = (m - 1)/(m + 1), |s| < 0.172
+inline double laneLog(double u)
+{
+    const quint64 SqrtHalf = 0x3fe6a09e667f3bcdull;
+    const quint64 bits = bitsOf(u);
+    const quint64 shifted = bits - SqrtHalf;
+    const double m = fromBits(bits - (shifted & 0xfff0000000000000ull));
+    // k = shifted >> 52 со знаком: сдвиг в смещённом коде и перевод в double
+    // через 2^52, без преобразования int64 -> double, которого нет в SSE2
+    const double k = fromBits(((shifted ^ 0x8000000000000000ull) >> 52) | 0x4330000000000000ull)
+                     - (4503599627370496.0 + 2048.0);
+
+    const double s = (m - 1.0) / (m + 1.0);
+    const double z = s * s;
+    double series = 1.0 / 23.0;
+    series = series * z + 1.0 / 21.0;
+    series = series * z + 1.0 / 19.0;
+    series = series * z + 1.0 / 17.0;
+    series = series * z + 1.0 / 15.0;
+    series = series * z + 1.0 / 13.0;
+    series = series * z + 1.0 / 11.0;
+    series = series * z + 1.0 / 9.0;
+    series = series * z + 1.0 / 7.0;
+    series = series * z + 1.0 / 5.0;
+    series = series * z + 1.0 / 3.0;
+    const double Ln2Hi = 6.93147180369123816490e-01;
+    const double Ln2Lo = 1.90821492927058770002e-10;
+    return k * Ln2Hi + (2.0 * s + (2.0 * s * z * series + k * Ln2Lo));
+}
+
+// sin и cos угла 2πu для u ∈ [0, 1]: четверть оборота q = round(4u),
+// остаток |2π(u - q/4)| ≤ π/4 идёт в ряды Тейлора, затем поворот на q·π/2
+inline void laneSinCos2Pi(double u, double& sine, double& cosine)
+{
+    // Округление до целого сложением с 1.5·2^52 (roundpd есть только с SSE4.1)
+    const double Round = 6755399441055744.0;
+    const double q = (4.0 * u + Round) - Round;
+    const double a = 2.0 * M_PI * (u - 0.25 * q);
+    const double z = a * a;
+
+    double sa = 1.0 / 355687428096000.0;            // 1/17!
+    sa = sa * z - 1.0 / 1307674368000.0;
+    sa = sa * z + 1.0 / 6227020800.0;
+    sa = sa * z - 1.0 / 39916800.0;
+    sa = sa * z + 1.0 / 362880.0;
+    sa = sa * z - 1.0 / 5040.0;
+    sa = sa * z + 1.0 / 120.0;
+    sa = sa * z - 1.0 / 6.0;
+    sa = a + a * z * sa;
+
+    double ca = 1.0 / 20922789888000.0;             // 1/16!
+    ca = ca * z - 1.0 / 87178291200.0;
+    ca = ca * z + 1.0 / 479001600.0;
+    ca = ca * z - 1.0 / 3628800.0;
+    ca = ca * z + 1.0 / 40320.0;
+    ca = ca * z - 1.0 / 720.0;
+    ca = ca * z + 1.0 / 24.0;
+    ca = ca * z - 0.5;
+    ca = 1.0 + z * ca;
+
+    // q ∈ {0, 1, 2, 3, 4}; 4 - тот же поворот, что и 0
+    const bool swap = (q == 1.0) | (q == 3.0);
+    const double s = swap ? ca : sa;
+    const double c = swap ? sa : ca;
+    sine = (q > 1.5) & (q < 3.5) ? -s : s;
+    cosine = (q > 0.5) & (q < 2.5) ? -c : c;
+}
+
+} // namespace
+
+MonteCarloProportion MonteCarloProportion::of(quint64 count, quint64 total)
+{
+    MonteCarloProportion proportion;
+    proportion.count = count;
+    if (total == 0) return proportion;
+
+    // Интервал Уилсона: не вырождается при долях около 0 и 1
+    const double z = 1.959963984540054;
+    const double n = double(total);
+    const double p = count / n;
+    const double denominator = 1.0 + z * z / n;
+    const double center = (p + z * z / (2.0 * n)) / denominator;
+    const double half = z * std::sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denominator;
+    proportion.estimate = p;
+    proportion.low = std::max(0.0, center - half);
+    proportion.high = std::min(1.0, center + half);
+    return proportion;
+}
+
+TriangleMonteCarlo::TriangleMonteCarlo(QObject* parent)
+    : QThread(parent)
+{
+}
+
+TriangleMonteCarlo::~TriangleMonteCarlo()
+{
+    stop();
+}
+
+void TriangleMonteCarlo::launch(const MonteCarloOptions& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.options = options;
+    m_pending.generation = m_generation.fetch_add(1) + 1;
+    m_hasPending = true;
+    m_condition.wakeOne();
+}
+
+void TriangleMonteCarlo::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetch_add(1);
+    m_hasPending = false;
+}
+
+void TriangleMonteCarlo::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abort = true;
+        m_generation.fetch_add(1);
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+std::shared_ptr<const MonteCarloResult> TriangleMonteCarlo::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+bool TriangleMonteCarlo::isCancelled(quint64 generation) const
+{
+    return m_generation.load(std::memory_order_relaxed) != generation;
+}
+
+void TriangleMonteCarlo::sampleChunk(const MonteCarloOptions& options, quint64 chunk, int count,
+                                     Tally& tally, ShapeHistogram& density)
+{
+    PhiloxStream rng(options.seed, chunk);
+
+    alignas(64) double uniform[6][Block];
+    alignas(64) double position[6][Block];
+    alignas(64) double coordinate[3][Block];
+    alignas(64) double nondegenerate[Block];
+    const double* positions[6] = {position[0], position[1], position[2], position[3], position[4], position[5]};
+    double* coordinates[3] = {coordinate[0], coordinate[1], coordinate[2]};
+
+    for (int first = 0; first < count; first += Block) {
+        const int size = std::min(Block, count - first);
+        rng.uniforms(&uniform[0][0], 6 * Block);
+
+        // Вершина v: пара (uniform[2v], uniform[2v + 1]) -> (x, y)
+        for (int v = 0; v < 3; ++v) {
+            const double* u1 = uniform[2 * v];
+            const double* u2 = uniform[2 * v + 1];
+            double* x = position[2 * v];
+            double* y = position[2 * v + 1];
+            switch (options.measure) {
+            case MonteCarloOptions::GaussianVertices:
+                // Бокс-Мюллер
+                for (int n = 0; n < size; ++n) {
+                    const double r = std::sqrt(-2.0 * laneLog(u1[n]));
+                    double sine, cosine;
+                    laneSinCos2Pi(u2[n], sine, cosine);
+                    x[n] = r * cosine;
+                    y[n] = r * sine;
+                }
+                break;
+            case MonteCarloOptions::UniformDisk:
+                for (int n = 0; n < size; ++n) {
+                    const double r = std::sqrt(u1[n]);
+                    double sine, cosine;
+                    laneSinCos2Pi(u2[n], sine, cosine);
+                    x[n] = r * cosine;
+                    y[n] = r * sine;
+                }
+                break;
+            case MonteCarloOptions::UniformSquare:
+                for (int n = 0; n < size; ++n) {
+                    x[n] = u1[n];
+                    y[n] = u2[n];
+                }
+                break;
+            }
+        }
+
+        CoordTransform::getRawSphereCoordinates(size, positions, options.masses, coordinates);
+
+        // Угол при вершине тупой, если скалярное произведение сторон при ней < 0.
+        // Счёт в double: выбор 1.0/0.0 по сравнению векторизуется и без SSE4,
+        // а сумма по блоку точна
+        const double* x1 = position[0];
+        const double* y1 = position[1];
+        const double* x2 = position[2];
+        const double* y2 = position[3];
+        const double* x3 = position[4];
+        const double* y3 = position[5];
+        double valid = 0.0, obtuse0 = 0.0, obtuse1 = 0.0, obtuse2 = 0.0, positive = 0.0;
+        for (int n = 0; n < size; ++n) {
+            const double ax = x2[n] - x1[n], ay = y2[n] - y1[n];
+            const double bx = x3[n] - x1[n], by = y3[n] - y1[n];
+            const double cx = x3[n] - x2[n], cy = y3[n] - y2[n];
+            const double area = ax * by - ay * bx;
+            const double weight = area != 0.0 ? 1.0 : 0.0;
+            nondegenerate[n] = weight;
+            valid += weight;
+            obtuse0 += ax * bx + ay * by < 0.0 ? weight : 0.0;
+            obtuse1 += -ax * cx - ay * cy < 0.0 ? weight : 0.0;
+            obtuse2 += bx * cx + by * cy < 0.0 ? weight : 0.0;
+            positive += coordinate[1][n] > 0.0 ? weight : 0.0;
+        }
+        tally.samples += quint64(valid);
+        tally.degenerate += quint64(size) - quint64(valid);
+        tally.obtuseAt[0] += quint64(obtuse0);
+        tally.obtuseAt[1] += quint64(obtuse1);
+        tally.obtuseAt[2] += quint64(obtuse2);
+        tally.positive += quint64(positive);
+
+        // Разброс по ячейкам гистограммы - единственный цикл с переходами
+        for (int n = 0; n < size; ++n) {
+            if (nondegenerate[n] == 0.0) continue;
+            density.add(QVector3D(coordinate[0][n], coordinate[1][n], coordinate[2][n]));
+        }
+    }
+}
+
+void TriangleMonteCarlo::run()
+{
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_abort) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_abort) return;
+
+            request = m_pending;
+            m_pending = Request();
+            m_hasPending = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const MonteCarloOptions& options = request.options;
+        auto result = std::make_shared<MonteCarloResult>();
+        result->options = options;
+
+        const quint64 chunks = (options.samples + Chunk - 1) / Chunk;
+        const int progressStep = qMax<int>(1, int(chunks / 100));
+        std::atomic<int> done{0};
+        std::mutex mergeMutex;
+        Tally total;
+
+        try {
+            parallelFor(0, int(chunks), [&](int chunk) {
+                if (isCancelled(request.generation)) return;
+
+                const int count = int(std::min<quint64>(Chunk, options.samples - quint64(chunk) * Chunk));
+                Tally tally;
+                ShapeHistogram density(result->density.nside());
+                sampleChunk(options, quint64(chunk), count, tally, density);
+
+                {
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    total.samples += tally.samples;
+                    total.degenerate += tally.degenerate;
+                    for (int i = 0; i < 3; ++i) total.obtuseAt[i] += tally.obtuseAt[i];
+                    total.positive += tally.positive;
+                    result->density.merge(density);
+                }
+
+                int finished = done.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (finished % progressStep == 0) {
+                    emit progress(int(qint64(finished) * 100 / qint64(chunks)));
+                }
+            }, 1);
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in TriangleMonteCarlo:" << e.what();
+            continue;
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in TriangleMonteCarlo";
+            continue;
+        }
+
+        // Тупой угол может быть только один, поэтому области не пересекаются
+        const quint64 obtuse = total.obtuseAt[0] + total.obtuseAt[1] + total.obtuseAt[2];
+        result->samples = total.samples;
+        result->degenerate = total.degenerate;
+        result->obtuse = MonteCarloProportion::of(obtuse, total.samples);
+        for (int i = 0; i < 3; ++i) {
+            result->obtuseAt[i] = MonteCarloProportion::of(total.obtuseAt[i], total.samples);
+        }
+        result->acute = MonteCarloProportion::of(total.samples - obtuse, total.samples);
+        result->positive = MonteCarloProportion::of(total.positive, total.samples);
+        result->elapsedMs = timer.elapsed();
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (isCancelled(request.generation)) continue;
+            m_result = result;
+        }
+        emit ready(result->samples, result->elapsedMs);
+    }
+}
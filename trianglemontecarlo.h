@@ -0,0 +1,106 @@
+#ifndef TRIANGLEMONTECARLO_H
+#define TRIANGLEMONTECARLO_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <atomic>
+#include <memory>
+#include "shapehistogram.h"
+
+struct MonteCarloOptions {
+    enum Measure {
+        GaussianVertices,   // вершины ~ N(0, I₂): P(тупоугольный) = 3/4
+        UniformDisk,        // вершины равномерно в единичном круге: 9/8 - 4/π²
+        UniformSquare       // вершины равномерно в единичном квадрате
+    };
+
+    Measure measure = GaussianVertices;
+    QList<double> masses = {1.0, 1.0, 1.0};  // только для карты сферы форм
+    quint64 samples = 100000000;
+    quint64 seed = 1;
+};
+
+// Доля с 95% доверительным интервалом Уилсона
+struct MonteCarloProportion {
+    quint64 count = 0;
+    double estimate = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+
+    static MonteCarloProportion of(quint64 count, quint64 total);
+};
+
+struct MonteCarloResult {
+    MonteCarloOptions options;
+    quint64 samples = 0;                // учтённые треугольники (без вырожденных)
+    quint64 degenerate = 0;             // нулевая площадь
+    MonteCarloProportion obtuse;
+    MonteCarloProportion obtuseAt[3];   // тупой угол при вершине i: области сферы форм
+    MonteCarloProportion acute;
+    MonteCarloProportion positive;      // ξ3 > 0: обход 1-2-3 по часовой стрелке
+    ShapeHistogram density;             // плотность на сфере форм (зависит от масс)
+    qint64 elapsedMs = 0;
+};
+
+// Случайные треугольники на всех ядрах. Работа режется на куски по Chunk
+// треугольников; кусок c берёт числа из потока Philox (seed, c), поэтому
+// результат при том же seed один и тот же при любом числе потоков.
+// Внутри куска треугольники идут блоками по Block в SoA-массивах.
+// Преобразование меры (свои log и sincos вместо вызовов libm), пакетный
+// CoordTransform::getRawSphereCoordinates и проверка углов по скалярным
+// произведениям векторизуются с флагами из TS.pro; раскладка по ячейкам
+// гистограммы - отдельный скалярный цикл, вырожденные треугольники в неё
+// не попадают. Счётчики и гистограмма куска сливаются в общие под блокировкой.
+class TriangleMonteCarlo : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int Block = 256;
+    static constexpr int Chunk = 1 << 18;
+
+    explicit TriangleMonteCarlo(QObject* parent = nullptr);
+    ~TriangleMonteCarlo();
+
+    void launch(const MonteCarloOptions& options);
+    void cancel();
+    void stop();
+
+    std::shared_ptr<const MonteCarloResult> result() const;
+
+signals:
+    void progress(int percent);
+    void ready(quint64 samples, qint64 elapsedMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Request {
+        MonteCarloOptions options;
+        quint64 generation = 0;
+    };
+
+    struct Tally {
+        quint64 samples = 0;
+        quint64 degenerate = 0;
+        quint64 obtuseAt[3] = {};
+        quint64 positive = 0;
+    };
+
+    bool isCancelled(quint64 generation) const;
+    static void sampleChunk(const MonteCarloOptions& options, quint64 chunk, int count,
+                            Tally& tally, ShapeHistogram& density);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    Request m_pending;
+    bool m_hasPending = false;
+    bool m_abort = false;
+
+    std::atomic<quint64> m_generation{0};
+    std::shared_ptr<const MonteCarloResult> m_result; // под m_mutex
+};
+
+#endif // TRIANGLEMONTECARLO_H
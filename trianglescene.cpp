@@ -1,4 +1,5 @@
 #include "trianglescene.h"
+#include "updatescheduler.h"
 #include <QGraphicsLineItem>
 #include <QGraphicsSimpleTextItem>
 #include <QTimer>
@@ -28,14 +29,14 @@ TriangleScene::TriangleScene(QObject* parent) : QGraphicsScene(parent)
         for (auto point : points) {
             if (point) {
                 addItem(point);
-                connect(point, &DragPoint::positionChanged, this, &TriangleScene::updateTriangle);
+                connect(point, &DragPoint::positionChanged, this, &TriangleScene::requestTriangleUpdate);
                 connect(point, &DragPoint::positionChanging, this, [this]() {
-                    // НЕМЕДЛЕННОЕ обновление при перемещении точки
-                    updateTriangle();
+                    // Одно движение мыши даёт несколько сигналов - планировщик их схлопывает
+                    requestTriangleUpdate();
                     emit pointPositionChanging(); // Явно испускаем сигнал
                 });
                 connect(point, &DragPoint::dragFinished, this, [this]() {
-                    updateTriangle();
+                    requestTriangleUpdate();
                     emit dragFinished();
                 });
 
@@ -91,8 +92,7 @@ TriangleScene::~TriangleScene()
     // Отключаем все сигналы сначала
     for (auto point : points) {
         if (point) {
-            disconnect(point, &DragPoint::positionChanged, this, &TriangleScene::updateTriangle);
-            disconnect(point, &DragPoint::dragFinished, this, &TriangleScene::updateTriangle);
+            disconnect(point, nullptr, this, nullptr);
         }
     }
 
@@ -157,6 +157,21 @@ void TriangleScene::updateTriangle()
     }
 }
 
+void TriangleScene::requestTriangleUpdate()
+{
+    if (m_scheduler && m_updateStage >= 0) {
+        m_scheduler->markDirty(m_updateStage);
+    } else {
+        updateTriangle();
+    }
+}
+
+void TriangleScene::setUpdateScheduler(UpdateScheduler* scheduler, int stage)
+{
+    m_scheduler = scheduler;
+    m_updateStage = stage;
+}
+
 void TriangleScene::setPoints(const QList<QPointF>& newPoints)
 {
     if (newPoints.size() != 3) {
@@ -275,10 +290,9 @@ void TriangleScene::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
             }
         }
 
-        // НЕМЕДЛЕННОЕ обновление треугольника и отправка сигналов
-        updateTriangle();
+        // Обновление треугольника (updateTriangle сам испустит triangleUpdated)
+        requestTriangleUpdate();
         emit pointPositionChanging(); // Добавляем этот сигнал
-        emit triangleUpdated();
 
         event->accept();
         return;
@@ -6,6 +6,8 @@
 #include <QPointF>
 #include "dragpoint.h"
 
+class UpdateScheduler;
+
 class TriangleScene : public QGraphicsScene
 {
     Q_OBJECT
@@ -14,6 +16,9 @@ public:
     ~TriangleScene();
 
     void updateTriangle();
+    // Отложенное обновление: через планировщик, если он задан, иначе сразу
+    void requestTriangleUpdate();
+    void setUpdateScheduler(UpdateScheduler* scheduler, int stage);
     QList<QPointF> getPoints() const;
     QList<double> getMasses() const;
     void setPoints(const QList<QPointF>& points);
@@ -40,6 +45,8 @@ private:
     QList<QGraphicsSimpleTextItem*> labels;
 
     bool isDraggingScene = false;
+    UpdateScheduler* m_scheduler = nullptr;
+    int m_updateStage = -1;
     QPointF lastDragPos;
 };
 
@@ -0,0 +1,52 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Тройной буфер "последнего значения": писатель никогда не ждёт читателя,
+// читатель всегда получает самое свежее целиком записанное значение.
+// Один писатель и один читатель.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Только поток-писатель
+    void write(const T& value)
+    {
+        m_buffers[m_writeIndex] = value;
+        // Публикуем записанный буфер и забираем себе освободившийся
+        int previous = m_middle.exchange(m_writeIndex | FreshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    // Только поток-читатель. Возвращает false, если нового значения не было;
+    // в этом случае value не меняется.
+    bool read(T& value)
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FreshBit)) return false;
+
+        int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        value = m_buffers[m_readIndex];
+        return true;
+    }
+
+    bool hasFresh() const
+    {
+        return (m_middle.load(std::memory_order_acquire) & FreshBit) != 0;
+    }
+
+private:
+    enum { IndexMask = 3, FreshBit = 4 };
+
+    T m_buffers[3];
+    int m_writeIndex = 0;            // принадлежит писателю
+    int m_readIndex = 1;             // принадлежит читателю
+    std::atomic<int> m_middle{2};    // обменный буфер + флаг свежести
+};
+
+#endif // TRIPLEBUFFER_H
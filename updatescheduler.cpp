@@ -0,0 +1,113 @@
+#include "updatescheduler.h"
+#include <QMetaObject>
+#include <QStringList>
+#include <QDebug>
+
+UpdateScheduler::UpdateScheduler(QObject* parent)
+    : QObject(parent)
+{
+}
+
+int UpdateScheduler::addStage(const QString& name, std::function<void()> callback)
+{
+    if (m_stages.size() >= 32) {
+        qWarning() << "UpdateScheduler: too many stages, ignoring" << name;
+        return -1;
+    }
+
+    Stage stage;
+    stage.callback = std::move(callback);
+    stage.stats.name = name;
+    m_stages.append(stage);
+    return m_stages.size() - 1;
+}
+
+void UpdateScheduler::markDirty(int stage)
+{
+    if (stage < 0 || stage >= m_stages.size()) return;
+
+    m_stages[stage].stats.requests++;
+    m_dirty |= (1u << stage);
+
+    // Во время flush() более поздние этапы выполнятся в этом же проходе,
+    // а для уже пройденных flush() сам запланирует следующий
+    if (!m_flushing) {
+        scheduleFlush();
+    }
+}
+
+bool UpdateScheduler::isDirty(int stage) const
+{
+    if (stage < 0 || stage >= m_stages.size()) return false;
+    return (m_dirty & (1u << stage)) != 0;
+}
+
+void UpdateScheduler::scheduleFlush()
+{
+    if (m_flushPending) return;
+    m_flushPending = true;
+    QMetaObject::invokeMethod(this, &UpdateScheduler::flush, Qt::QueuedConnection);
+}
+
+void UpdateScheduler::flush()
+{
+    m_flushPending = false;
+    if (m_flushing || m_dirty == 0) return;
+
+    m_flushing = true;
+    for (int i = 0; i < m_stages.size(); ++i) {
+        quint32 bit = 1u << i;
+        if (!(m_dirty & bit)) continue;
+
+        m_dirty &= ~bit;
+        m_stages[i].stats.runs++;
+
+        try {
+            if (m_stages[i].callback) m_stages[i].callback();
+        }
+        catch (const std::exception& e) {
+            qWarning() << "Exception in update stage" << m_stages[i].stats.name << ":" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Unknown exception in update stage" << m_stages[i].stats.name;
+        }
+    }
+    m_flushing = false;
+    ++m_flushCount;
+
+    // Этап, помеченный заново уже после своего выполнения, ждёт следующего прохода
+    if (m_dirty != 0) {
+        scheduleFlush();
+    }
+}
+
+QVector<UpdateScheduler::StageStats> UpdateScheduler::stats() const
+{
+    QVector<StageStats> result;
+    for (const Stage& stage : m_stages) {
+        result.append(stage.stats);
+    }
+    return result;
+}
+
+void UpdateScheduler::resetStats()
+{
+    for (Stage& stage : m_stages) {
+        stage.stats.requests = 0;
+        stage.stats.runs = 0;
+    }
+    m_flushCount = 0;
+}
+
+QString UpdateScheduler::statsSummary() const
+{
+    QStringList parts;
+    for (const Stage& stage : m_stages) {
+        parts << QString("%1 %2/%3 (-%4)")
+                     .arg(stage.stats.name)
+                     .arg(stage.stats.runs)
+                     .arg(stage.stats.requests)
+                     .arg(stage.stats.coalesced());
+    }
+    return QString("Updates run/requested: %1").arg(parts.join(", "));
+}
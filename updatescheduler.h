@@ -0,0 +1,55 @@
+#ifndef UPDATESCHEDULER_H
+#define UPDATESCHEDULER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+// Планировщик обновлений на флагах "грязности".
+// Сигналы больше не вызывают пересчёт напрямую, а только помечают этап;
+// все помеченные этапы выполняются по одному разу в следующем проходе
+// цикла событий, в порядке регистрации.
+class UpdateScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    struct StageStats {
+        QString name;
+        quint64 requests = 0; // сколько раз этап помечали
+        quint64 runs = 0;     // сколько раз он реально выполнился
+        quint64 coalesced() const { return requests - runs; }
+    };
+
+    explicit UpdateScheduler(QObject* parent = nullptr);
+
+    // Возвращает номер этапа для markDirty (не больше 32 этапов)
+    int addStage(const QString& name, std::function<void()> callback);
+
+    void markDirty(int stage);
+    bool isDirty(int stage) const;
+
+    QVector<StageStats> stats() const;
+    quint64 flushCount() const { return m_flushCount; }
+    void resetStats();
+    QString statsSummary() const;
+
+public slots:
+    void flush();
+
+private:
+    void scheduleFlush();
+
+    struct Stage {
+        std::function<void()> callback;
+        StageStats stats;
+    };
+
+    QVector<Stage> m_stages;
+    quint32 m_dirty = 0;
+    bool m_flushPending = false;
+    bool m_flushing = false;
+    quint64 m_flushCount = 0;
+};
+
+#endif // UPDATESCHEDULER_H